@@ -0,0 +1,823 @@
+//
+//  Benchmark.cpp
+//  TLB-Coherence-Simulator
+//
+//  Copyright © 2018 Yashwant Marathe. All rights reserved.
+//
+
+#include "Benchmark.hpp"
+#include <vector>
+#include <chrono>
+#include <random>
+#include <cstring>
+#include <algorithm>
+#include <cstdlib>
+#include <cmath>
+#include <memory>
+#include <thread>
+#include <sstream>
+#include "utils.hpp"
+#include "Simulator.hpp"
+#include "TimeParallelSim.hpp"
+#include "Cache.hpp"
+#include "TraceMerger.hpp"
+#include "TagStore.hpp"
+#include "Coherence.hpp"
+#include "ReplPolicy.hpp"
+
+static double elapsedSeconds(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+typedef std::vector<std::vector<trace_tlb_entry_t>> TraceStreams;
+
+//Per-core record streams, as seen by TraceProcessor in -m mode
+static TraceStreams makeStreams(unsigned int num_streams, uint64_t total_records)
+{
+    std::mt19937_64 gen(42);
+    std::uniform_int_distribution<uint64_t> step(0, 3);
+    TraceStreams streams(num_streams);
+
+    for(int i = 0; i < num_streams; i++)
+    {
+        uint64_t ts = 100000;
+        streams[i].resize(total_records / num_streams);
+        for(trace_tlb_entry_t &rec : streams[i])
+        {
+            ts += step(gen);
+            rec.ts = ts;
+            rec.va = gen();
+            rec.large = false;
+            rec.write = 0;
+        }
+    }
+
+    return streams;
+}
+
+//Linear scan over the stream heads with the used_up/empty_file bookkeeping, what getNextEntry used to do
+static uint64_t mergeLinear(const TraceStreams &streams)
+{
+    unsigned int num_streams = streams.size();
+    std::vector<size_t> pos(num_streams, 0);
+    std::vector<const trace_tlb_entry_t*> buf(num_streams);
+    std::unique_ptr<bool[]> used_up(new bool[num_streams]);
+    std::unique_ptr<bool[]> empty_file(new bool[num_streams]);
+    uint64_t checksum = 0;
+
+    for(int i = 0; i < num_streams; i++)
+    {
+        buf[i] = streams[i].data();
+        used_up[i] = false;
+        empty_file[i] = streams[i].empty();
+    }
+
+    while(true)
+    {
+        int index = -1;
+        uint64_t least = 0xffffffffffffffff;
+
+        for(int i = 0; i < num_streams; i++)
+        {
+            if(used_up[i] && !empty_file[i])
+            {
+                if(++pos[i] < streams[i].size())
+                {
+                    buf[i] = &streams[i][pos[i]];
+                    used_up[i] = false;
+                }
+                else
+                {
+                    empty_file[i] = true;
+                }
+            }
+            if(!empty_file[i] && buf[i]->ts < least)
+            {
+                least = buf[i]->ts;
+                index = i;
+            }
+        }
+
+        if(index == -1)
+        {
+            break;
+        }
+
+        checksum = checksum * 31 + index;
+        used_up[index] = true;
+    }
+
+    return checksum;
+}
+
+static uint64_t mergeTree(const TraceStreams &streams)
+{
+    unsigned int num_streams = streams.size();
+    std::vector<size_t> pos(num_streams, 0);
+    std::vector<const trace_tlb_entry_t*> buf(num_streams);
+    TraceMerger merger(num_streams);
+    uint64_t checksum = 0;
+
+    for(int i = 0; i < num_streams; i++)
+    {
+        if(!streams[i].empty())
+        {
+            buf[i] = streams[i].data();
+            merger.push(i, buf[i]->ts);
+        }
+    }
+    merger.build();
+
+    while(!merger.empty())
+    {
+        unsigned int index = merger.top();
+
+        checksum = checksum * 31 + index;
+        if(++pos[index] < streams[index].size())
+        {
+            buf[index] = &streams[index][pos[index]];
+            merger.update_top(buf[index]->ts);
+        }
+        else
+        {
+            merger.pop();
+        }
+    }
+
+    return checksum;
+}
+
+//Merge throughput of the per-core trace streams as the core count grows
+static int benchMerge(int argc, char *argv[])
+{
+    uint64_t total_records = (argc > 0) ? strtoull(argv[0], NULL, 10) : 8 * 1024 * 1024;
+
+    std::cout << "Merging " << total_records << " records" << std::endl;
+    std::cout << "cores\tlinear Mrec/s\ttree Mrec/s\tspeedup" << std::endl;
+
+    for(unsigned int num_streams = 2; num_streams <= 256; num_streams *= 2)
+    {
+        TraceStreams streams = makeStreams(num_streams, total_records);
+        uint64_t num_records = (total_records / num_streams) * num_streams;
+
+        auto start = std::chrono::steady_clock::now();
+        uint64_t linear_sum = mergeLinear(streams);
+        double linear_time = elapsedSeconds(start);
+
+        start = std::chrono::steady_clock::now();
+        uint64_t tree_sum = mergeTree(streams);
+        double tree_time = elapsedSeconds(start);
+
+        if(linear_sum != tree_sum)
+        {
+            std::cout << "[Error] Merge order differs for " << num_streams << " cores" << std::endl;
+            return 1;
+        }
+
+        std::cout << num_streams << "\t" << num_records / linear_time / 1e6 << "\t\t" << num_records / tree_time / 1e6 << "\t\t" << linear_time / tree_time << std::endl;
+    }
+
+    return 0;
+}
+
+//Tag store as it used to be: a vector of lines per set, each line with its own heap allocated protocol object
+class LegacyCoherence {
+public:
+    CoherenceState coh_state = INVALID;
+    unsigned int m_cache_level = 0;
+    virtual ~LegacyCoherence() {}
+};
+
+class LegacyLine {
+public:
+    bool valid = false;
+    bool dirty = false;
+    bool lock = false;
+    bool is_translation = false;
+    bool is_large = false;
+    uint64_t tag = 0;
+    uint64_t tid = 0;
+    uint64_t cotag = 0;
+    LegacyCoherence *m_coherence_prot = nullptr;
+};
+
+typedef std::vector<std::vector<LegacyLine>> LegacyTagStore;
+
+static uint64_t lookupLegacy(const LegacyTagStore &tags, const std::vector<uint64_t> &addrs, unsigned int num_index_bits)
+{
+    uint64_t hits = 0;
+
+    for(uint64_t addr : addrs)
+    {
+        const std::vector<LegacyLine> &set = tags[addr & ((1 << num_index_bits) - 1)];
+        uint64_t tag = addr >> num_index_bits;
+        bool is_translation = addr & 1;
+        uint64_t tid = 0;
+
+        auto it = std::find_if(set.begin(), set.end(), [tag, is_translation, tid](const LegacyLine &l)
+                               {
+                                   return (is_translation) ?  ((l.tag == tag) && (l.valid) && (l.is_translation == is_translation) && (l.tid == tid)) :  ((l.tag == tag) && (l.valid) && (l.is_translation == is_translation));
+                               });
+        hits += (it != set.end()) && (it->m_coherence_prot->coh_state != INVALID);
+    }
+
+    return hits;
+}
+
+static uint64_t lookupTagStore(TagStore &tags, const std::vector<uint64_t> &addrs, unsigned int num_index_bits)
+{
+    uint64_t hits = 0;
+
+    for(uint64_t addr : addrs)
+    {
+        uint64_t set = addr & ((1 << num_index_bits) - 1);
+        unsigned int way = tags.find(set, addr >> num_index_bits, addr & 1, 0);
+        hits += (way != tags.get_associativity()) && (tags.line(set, way).get_coherence_state() != INVALID);
+    }
+
+    return hits;
+}
+
+//Footprint and lookup throughput of the flat tag store against the per-set vectors of CacheLine it replaced
+static int benchTagStore(int argc, char *argv[])
+{
+    uint64_t num_lookups = (argc > 0) ? strtoull(argv[0], NULL, 10) : 16 * 1024 * 1024;
+    const unsigned int shapes[][2] = {{64, 8}, {1024, 16}, {2048, 16}, {8192, 16}};
+
+    std::cout << "Looking up " << num_lookups << " addresses, about half of them hits" << std::endl;
+    std::cout << "sets\tways\tlegacy B/line\tflat B/line\tlegacy Mlookup/s\tflat Mlookup/s\tspeedup" << std::endl;
+
+    for(const unsigned int *shape : shapes)
+    {
+        unsigned int num_sets = shape[0];
+        unsigned int associativity = shape[1];
+        unsigned int num_index_bits = log2(num_sets);
+        std::mt19937_64 gen(42);
+
+        LegacyTagStore legacy(num_sets, std::vector<LegacyLine>(associativity));
+        TagStore flat(num_sets, associativity);
+
+        //Fill every way, tags alternate between data and translation lines
+        std::vector<uint64_t> resident;
+        for(unsigned int i = 0; i < num_sets; i++)
+        {
+            for(unsigned int j = 0; j < associativity; j++)
+            {
+                uint64_t tag = (gen() & 0xffffffffff) | 1;
+                tag ^= (j & 1);
+
+                LegacyLine &l = legacy[i][j];
+                l.valid = true;
+                l.is_translation = tag & 1;
+                l.tag = tag;
+                l.m_coherence_prot = new LegacyCoherence();
+                l.m_coherence_prot->coh_state = SHARED;
+
+                TagStore::Line line = flat.line(i, j);
+                line.set_valid(true);
+                line.set_translation(tag & 1);
+                line.set_tag(tag);
+                line.set_coherence_state(SHARED);
+
+                resident.push_back((tag << num_index_bits) | i);
+            }
+        }
+
+        //Lookups use the low tag bit as is_translation, as the fill did
+        std::vector<uint64_t> addrs(num_lookups);
+        for(uint64_t &addr : addrs)
+        {
+            addr = (gen() & 1) ? resident[gen() % resident.size()] : ((gen() & 0xffffffffff) << num_index_bits) | (gen() % num_sets);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        uint64_t legacy_hits = lookupLegacy(legacy, addrs, num_index_bits);
+        double legacy_time = elapsedSeconds(start);
+
+        start = std::chrono::steady_clock::now();
+        uint64_t flat_hits = lookupTagStore(flat, addrs, num_index_bits);
+        double flat_time = elapsedSeconds(start);
+
+        if(legacy_hits != flat_hits)
+        {
+            std::cout << "[Error] Hit count differs for " << num_sets << " x " << associativity << std::endl;
+            return 1;
+        }
+
+        //Every legacy line also held a protocol object on the heap
+        double num_lines = (double) num_sets * associativity;
+        double legacy_bytes = (sizeof(LegacyTagStore::value_type) * num_sets + sizeof(LegacyLine) * num_lines + sizeof(LegacyCoherence) * num_lines) / num_lines;
+        double flat_bytes = flat.get_memory_usage() / num_lines;
+
+        std::cout << num_sets << "\t" << associativity << "\t" << legacy_bytes << "\t\t" << flat_bytes << "\t\t" << num_lookups / legacy_time / 1e6 << "\t\t\t" << num_lookups / flat_time / 1e6 << "\t\t" << legacy_time / flat_time << std::endl;
+
+        for(std::vector<LegacyLine> &set : legacy)
+        {
+            for(LegacyLine &l : set)
+            {
+                delete l.m_coherence_prot;
+            }
+        }
+    }
+
+    return 0;
+}
+
+//Scalar against vector tag match, per associativity, with translations and tids
+//A 1K line store stays in the L1 and shows the match itself, a 32K line store the L2 sized TLBs and caches
+static int benchTagMatch(int argc, char *argv[])
+{
+    uint64_t num_lookups = (argc > 0) ? strtoull(argv[0], NULL, 10) : 16 * 1024 * 1024;
+
+    if(!TagStore::simd_supported())
+    {
+        std::cout << "Vector tag match not available on this build or CPU, timing the scalar match only" << std::endl;
+    }
+
+    std::cout << "Looking up " << num_lookups << " addresses, about half of them hits, half translations" << std::endl;
+    std::cout << "lines\tways\tscalar Mlookup/s\tsimd Mlookup/s\tspeedup" << std::endl;
+
+    for(unsigned int num_lines = 1024; num_lines <= 32 * 1024; num_lines *= 32)
+    for(unsigned int associativity = 4; associativity <= 32; associativity *= 2)
+    {
+        unsigned int num_sets = num_lines / associativity;
+        unsigned int num_index_bits = log2(num_sets);
+        std::mt19937_64 gen(42);
+        TagStore tags(num_sets, associativity);
+
+        //Low tag bit is is_translation, translations are spread over four tids
+        std::vector<uint64_t> resident;
+        std::vector<uint64_t> resident_tid;
+        for(unsigned int i = 0; i < num_sets; i++)
+        {
+            for(unsigned int j = 0; j < associativity; j++)
+            {
+                uint64_t tag = gen() & 0xffffffffff;
+                uint64_t tid = (tag & 1) ? gen() % 4 : 0;
+
+                TagStore::Line line = tags.line(i, j);
+                line.set_valid(true);
+                line.set_translation(tag & 1);
+                line.set_tag(tag);
+                line.set_tid(tid);
+                line.set_coherence_state(SHARED);
+
+                resident.push_back((tag << num_index_bits) | i);
+                resident_tid.push_back(tid);
+            }
+        }
+
+        std::vector<uint64_t> addrs(num_lookups);
+        std::vector<uint64_t> tids(num_lookups);
+        for(size_t i = 0; i < num_lookups; i++)
+        {
+            size_t r = gen() % resident.size();
+            bool hit = gen() & 1;
+            addrs[i] = hit ? resident[r] : ((gen() & 0xffffffffff) << num_index_bits) | (gen() % num_sets);
+            tids[i] = hit ? resident_tid[r] : gen() % 4;
+        }
+
+        uint64_t hits[2] = {0, 0};
+        double times[2] = {0, 0};
+        for(int simd = 0; simd < 2; simd++)
+        {
+            tags.set_use_simd(simd);
+            if(simd && !tags.get_use_simd())
+            {
+                break;
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            for(size_t i = 0; i < num_lookups; i++)
+            {
+                uint64_t set = addrs[i] & ((1 << num_index_bits) - 1);
+                uint64_t tag = addrs[i] >> num_index_bits;
+                hits[simd] += (tags.find(set, tag, tag & 1, tids[i]) != associativity);
+            }
+            times[simd] = elapsedSeconds(start);
+        }
+
+        if(times[1] == 0)
+        {
+            std::cout << num_lines << "\t" << associativity << "\t" << num_lookups / times[0] / 1e6 << "\t\t\t-\t\t-" << std::endl;
+            continue;
+        }
+
+        if(hits[0] != hits[1])
+        {
+            std::cout << "[Error] Scalar and vector tag match disagree for " << associativity << " ways" << std::endl;
+            return 1;
+        }
+
+        std::cout << num_lines << "\t" << associativity << "\t" << num_lookups / times[0] / 1e6 << "\t\t\t" << num_lookups / times[1] / 1e6 << "\t\t" << times[0] / times[1] << std::endl;
+    }
+
+    return 0;
+}
+
+//LRU as it used to be: a stack position per way, the set's positions copied and scanned for every victim
+class LegacyLRURepl {
+private:
+    unsigned int m_associativity;
+    std::vector<std::vector<int>> m_stack_position;
+
+public:
+    LegacyLRURepl(unsigned int num_sets, unsigned int associativity) : m_associativity(associativity), m_stack_position(num_sets, std::vector<int>(associativity))
+    {
+        for(std::vector<int> &set : m_stack_position)
+        {
+            for(unsigned int i = 0; i < m_associativity; i++)
+            {
+                set[i] = m_associativity - i - 1;
+            }
+        }
+    }
+
+    unsigned int getVictim(TagStore &tags, uint64_t set_num)
+    {
+        for(unsigned int i = 0; i < m_associativity; i++)
+        {
+            if(!tags.line(set_num, i).is_valid())
+            {
+                return i;
+            }
+        }
+
+        std::vector<int> set = m_stack_position[set_num];
+        for(unsigned int i = 0; i < set.size(); i++)
+        {
+            if(set[i] == (int) m_associativity - 1)
+            {
+                return i;
+            }
+        }
+
+        return 0;
+    }
+
+    void updateReplState(uint64_t set_num, unsigned int way)
+    {
+        std::vector<int> &set = m_stack_position[set_num];
+        int pivot = set[way];
+        for(unsigned int i = 0; i < set.size(); i++)
+        {
+            if(set[i] < pivot)
+            {
+                set[i]++;
+            }
+        }
+        set[way] = 0;
+    }
+};
+
+//Runs the accesses through a cache of the given shape, one in 64 accesses invalidates a line instead
+//Returns the misses, which only agree between policies if every victim does
+template <typename Repl>
+static uint64_t runLRU(Repl &repl, TagStore &tags, const std::vector<uint64_t> &addrs, unsigned int num_index_bits)
+{
+    uint64_t misses = 0;
+
+    for(uint64_t addr : addrs)
+    {
+        uint64_t set = addr & ((1 << num_index_bits) - 1);
+        uint64_t tag = addr >> num_index_bits;
+        unsigned int way = tags.find(set, tag, false, 0);
+
+        if((tag & 63) == 0)
+        {
+            tags.line(set, tag % tags.get_associativity()).set_valid(false);
+        }
+        else if(way != tags.get_associativity())
+        {
+            repl.updateReplState(set, way);
+        }
+        else
+        {
+            misses++;
+            way = repl.getVictim(tags, set);
+            tags.line(set, way).fill(tag, 0, 0, false, false, false);
+            repl.updateReplState(set, way);
+        }
+    }
+
+    return misses;
+}
+
+//Hit and fill throughput of the constant time LRU against the copying stack position LRU it replaced
+static int benchLRU(int argc, char *argv[])
+{
+    uint64_t num_accesses = (argc > 0) ? strtoull(argv[0], NULL, 10) : 16 * 1024 * 1024;
+    const unsigned int shapes[][2] = {{64, 8}, {1024, 16}, {8192, 16}, {16384, 4}, {16, 64}};
+
+    std::cout << "Running " << num_accesses << " accesses, each set sees twice its ways in tags" << std::endl;
+    std::cout << "sets\tways\tmiss rate\tlegacy B/set\tlist B/set\tlegacy Maccess/s\tlist Maccess/s\tspeedup" << std::endl;
+
+    for(const unsigned int *shape : shapes)
+    {
+        unsigned int num_sets = shape[0];
+        unsigned int associativity = shape[1];
+        unsigned int num_index_bits = log2(num_sets);
+        std::mt19937_64 gen(42);
+
+        //Skewed towards low tags so that recency matters
+        std::vector<uint64_t> addrs(num_accesses);
+        for(uint64_t &addr : addrs)
+        {
+            uint64_t tag = std::min(gen() % (2 * associativity), gen() % (2 * associativity)) + 1;
+            addr = (tag << num_index_bits) | (gen() % num_sets);
+        }
+
+        TagStore legacy_tags(num_sets, associativity);
+        LegacyLRURepl legacy(num_sets, associativity);
+        TagStore list_tags(num_sets, associativity);
+        LRURepl list(num_sets, associativity);
+
+        auto start = std::chrono::steady_clock::now();
+        uint64_t legacy_misses = runLRU(legacy, legacy_tags, addrs, num_index_bits);
+        double legacy_time = elapsedSeconds(start);
+
+        start = std::chrono::steady_clock::now();
+        uint64_t list_misses = runLRU(list, list_tags, addrs, num_index_bits);
+        double list_time = elapsedSeconds(start);
+
+        if(legacy_misses != list_misses)
+        {
+            std::cout << "[Error] Miss count differs for " << num_sets << " x " << associativity << std::endl;
+            return 1;
+        }
+
+        double legacy_bytes = sizeof(std::vector<int>) + sizeof(int) * associativity;
+        double list_bytes = (double) list.get_memory_usage() / num_sets;
+
+        std::cout << num_sets << "\t" << associativity << "\t" << (double) list_misses / num_accesses << "\t" << legacy_bytes << "\t\t" << list_bytes << "\t\t" << num_accesses / legacy_time / 1e6 << "\t\t\t" << num_accesses / list_time / 1e6 << "\t\t" << legacy_time / list_time << std::endl;
+    }
+
+    return 0;
+}
+
+//Wall time of a serial and of a parallel run of the same config, and how far the IPC of the parallel run strays from the serial one
+static int benchParallel(int argc, char *argv[])
+{
+    if(argc < 1)
+    {
+        std::cout << "Usage: -bench parallel <config> [worker threads] [quantum]" << std::endl;
+        return 1;
+    }
+
+    unsigned int num_threads = (argc > 1) ? strtoul(argv[1], NULL, 10) : std::max(1U, std::thread::hardware_concurrency());
+    unsigned int quantum = (argc > 2) ? strtoul(argv[2], NULL, 10) : 0;
+    double seconds[2];
+    std::vector<double> ipc[2];
+
+    for(int parallel = 0; parallel < 2; parallel++)
+    {
+        //TraceProcessor draws the thread switches from rand(), both runs get the ones of a fresh process
+        srand(1);
+
+        Simulator sim;
+        sim.tp.parseAndSetupInputs(argv[0]);
+        sim.tp.verifyOpenTraceFiles();
+        sim.build();
+        sim.initial_fill();
+
+        quantum = (quantum > 0) ? quantum : sim.default_quantum();
+
+        auto start = std::chrono::steady_clock::now();
+        if(parallel)
+        {
+            sim.run_parallel(num_threads, quantum);
+        }
+        else
+        {
+            sim.run();
+        }
+        seconds[parallel] = elapsedSeconds(start);
+
+        for(int i = 0; i < sim.cores.size(); i++)
+        {
+            ipc[parallel].push_back((sim.cores[i]->m_clk > 0) ? (double) sim.cores[i]->m_num_retired / sim.cores[i]->m_clk : 0);
+        }
+    }
+
+    std::cout << "core\tserial IPC\tparallel IPC\terror %" << std::endl;
+    double max_error = 0;
+    for(int i = 0; i < ipc[0].size(); i++)
+    {
+        double error = (ipc[0][i] > 0) ? 100.0 * (ipc[1][i] - ipc[0][i]) / ipc[0][i] : 0;
+        max_error = std::max(max_error, std::abs(error));
+        std::cout << i << "\t" << ipc[0][i] << "\t\t" << ipc[1][i] << "\t\t" << error << std::endl;
+    }
+
+    std::cout << "Worker threads = " << num_threads << ", quantum = " << quantum << " cycles, host threads = " << std::thread::hardware_concurrency() << std::endl;
+    std::cout << "Serial " << seconds[0] << " s, parallel " << seconds[1] << " s, speedup = " << seconds[0] / seconds[1] << ", largest IPC error = " << max_error << " %" << std::endl;
+
+    return 0;
+}
+
+//Totals over all cores and shared levels that a time-parallel run is checked on
+static std::vector<std::pair<std::string, double>> summarizeRun(Simulator &sim)
+{
+    double cycles = 0, instructions = 0, shootdowns = 0, l1d_misses = 0, l2d_misses = 0, l1_tlb_misses = 0, l2_tlb_misses = 0;
+
+    for(int i = 0; i < sim.cores.size(); i++)
+    {
+        cycles += sim.cores[i]->get_num_cycles();
+        instructions += sim.cores[i]->m_num_retired;
+        shootdowns += sim.cores[i]->num_shootdown;
+        l1d_misses += sim.l1_data_caches[i]->num_data_misses;
+        l2d_misses += sim.l2_data_caches[i]->num_data_misses + sim.l2_data_caches[i]->num_tr_misses;
+    }
+
+    for(int i = 0; i < sim.l1_tlb.size(); i++)
+    {
+        l1_tlb_misses += sim.l1_tlb[i]->num_tr_misses;
+        l2_tlb_misses += sim.l2_tlb[i]->num_tr_misses;
+    }
+
+    std::vector<std::pair<std::string, double>> summary;
+    summary.push_back(std::make_pair("cycles", cycles));
+    summary.push_back(std::make_pair("instructions", instructions));
+    summary.push_back(std::make_pair("IPC", (cycles > 0) ? instructions / cycles : 0));
+    summary.push_back(std::make_pair("shootdowns", shootdowns));
+    summary.push_back(std::make_pair("L1 D$ misses", l1d_misses));
+    summary.push_back(std::make_pair("L2 D$ misses", l2d_misses));
+    summary.push_back(std::make_pair("L1 TLB misses", l1_tlb_misses));
+    summary.push_back(std::make_pair("L2 TLB misses", l2_tlb_misses));
+    summary.push_back(std::make_pair("L3 misses", (double) sim.llc->num_data_misses + sim.llc->num_tr_misses));
+    summary.push_back(std::make_pair("L3 TLB misses", (double) sim.l3_tlb_small->num_tr_misses + sim.l3_tlb_large->num_tr_misses));
+    return summary;
+}
+
+static int benchTimeParallel(int argc, char *argv[])
+{
+    if(argc < 1)
+    {
+        std::cout << "Usage: -bench timeparallel <config> [segments] [warm-up overlap] [end ts] [shootdown penalty]" << std::endl;
+        return 1;
+    }
+
+    unsigned int num_segments = (argc > 1) ? strtoul(argv[1], NULL, 10) : std::max(2U, std::thread::hardware_concurrency());
+    uint64_t overlap = (argc > 2) ? strtoull(argv[2], NULL, 10) : 10000;
+    uint64_t end_ts = (argc > 3) ? strtoull(argv[3], NULL, 10) : UINT64_MAX;
+    uint64_t penalty = (argc > 4) ? strtoull(argv[4], NULL, 10) : 0;
+    uint64_t start_ts;
+    double seconds[2];
+    std::vector<std::pair<std::string, double>> summary[2];
+
+    //Serial run over [start_ts, end_ts), keep end_ts small enough for it to finish in reasonable time
+    {
+        Simulator sim;
+        sim.tp.parseAndSetupInputs(argv[0]);
+        sim.tp.end_ts = std::min(sim.tp.end_ts, end_ts);
+        sim.tp.shootdown_penalty = (penalty > 0) ? penalty : sim.tp.shootdown_penalty;
+        penalty = sim.tp.shootdown_penalty;
+        start_ts = (sim.tp.start_ts != 0) ? sim.tp.start_ts : sim.tp.warmup_period;
+        end_ts = (sim.tp.end_ts != UINT64_MAX) ? sim.tp.end_ts : sim.tp.find_end_ts();
+
+        sim.tp.verifyOpenTraceFiles();
+        sim.build();
+        sim.initial_fill();
+
+        auto start = std::chrono::steady_clock::now();
+        sim.run();
+        seconds[0] = elapsedSeconds(start);
+
+        summary[0] = summarizeRun(sim);
+    }
+
+    {
+        TimeParallelSim tpsim(num_segments, start_ts, end_ts, overlap, [&](TraceProcessor &tp) {
+            tp.parseAndSetupInputs(argv[0]);
+            tp.shootdown_penalty = penalty;
+        });
+
+        auto start = std::chrono::steady_clock::now();
+        tpsim.run();
+        seconds[1] = elapsedSeconds(start);
+
+        summary[1] = summarizeRun(tpsim.get_merged());
+
+        //Every segment must have run to its end, and the merged counters must make it into the stats file
+        std::ostringstream stats;
+        tpsim.get_merged().print_stats(stats);
+        if(stats.str().empty() || summary[1][0].second == 0 || summary[1][1].second == 0)
+        {
+            std::cout << "[Error] Time-parallel run left no merged stats" << std::endl;
+            return 1;
+        }
+    }
+
+    std::cout << "counter\tserial\ttime-parallel\terror %" << std::endl;
+    for(int i = 0; i < summary[0].size(); i++)
+    {
+        double error = (summary[0][i].second > 0) ? 100.0 * (summary[1][i].second - summary[0][i].second) / summary[0][i].second : 0;
+        std::cout << summary[0][i].first << "\t" << summary[0][i].second << "\t" << summary[1][i].second << "\t" << error << std::endl;
+    }
+
+    std::cout << "Timestamps = " << start_ts << " to " << end_ts << ", segments = " << num_segments << ", warm-up overlap = " << overlap << ", shootdown penalty = " << penalty << ", host threads = " << std::thread::hardware_concurrency() << std::endl;
+    std::cout << "Serial " << seconds[0] << " s, time-parallel " << seconds[1] << " s, speedup = " << seconds[0] / seconds[1] << std::endl;
+
+    return 0;
+}
+
+//Runs a trace with idle cycles ticked one by one and skipped, the stats must not differ.
+//Idle cycles need every core to wait at once, e.g. a one-core config of the baseline scheme stalled on shootdowns.
+static int benchSkip(int argc, char *argv[])
+{
+    if(argc < 1)
+    {
+        std::cout << "Usage: -bench skip <config> [shootdown penalty]" << std::endl;
+        return 1;
+    }
+
+    uint64_t penalty = (argc > 1) ? strtoull(argv[1], NULL, 10) : 0;
+    TranslationCoherenceScheme scheme = BASELINE_SCHEME;
+    double seconds[2];
+    uint64_t skipped[2];
+    std::string stats[2];
+
+    for(int skip = 0; skip < 2; skip++)
+    {
+        //TraceProcessor draws the thread switches from rand(), both runs get the ones of a fresh process
+        srand(1);
+
+        Simulator sim;
+        sim.tp.parseAndSetupInputs(argv[0]);
+        sim.tp.shootdown_penalty = (penalty > 0) ? penalty : sim.tp.shootdown_penalty;
+        penalty = sim.tp.shootdown_penalty;
+        scheme = sim.tp.scheme;
+        sim.tp.verifyOpenTraceFiles();
+        sim.build();
+        sim.initial_fill();
+
+        sim.skip_idle_cycles = skip;
+
+        auto start = std::chrono::steady_clock::now();
+        sim.run();
+        seconds[skip] = elapsedSeconds(start);
+        skipped[skip] = sim.num_skipped_cycles;
+
+        std::ostringstream out;
+        sim.print_stats(out);
+        stats[skip] = out.str();
+    }
+
+    std::cout << "Scheme = " << schemeName(scheme) << ", shootdown penalty = " << penalty << ", idle cycles skipped = " << skipped[1] << std::endl;
+    std::cout << "Ticked " << seconds[0] << " s, skipped " << seconds[1] << " s, speedup = " << seconds[0] / seconds[1] << std::endl;
+
+    if(skipped[0] != 0 || skipped[1] == 0)
+    {
+        std::cout << "[Error] No idle cycles were skipped" << std::endl;
+        return 1;
+    }
+
+    if(stats[0] != stats[1])
+    {
+        std::cout << "[Error] Stats differ with idle cycles skipped" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+int runBenchmark(int argc, char *argv[])
+{
+    if(argc > 0 && strcmp(argv[0], "merge") == 0)
+    {
+        return benchMerge(argc - 1, argv + 1);
+    }
+
+    if(argc > 0 && strcmp(argv[0], "tagstore") == 0)
+    {
+        return benchTagStore(argc - 1, argv + 1);
+    }
+
+    if(argc > 0 && strcmp(argv[0], "tagmatch") == 0)
+    {
+        return benchTagMatch(argc - 1, argv + 1);
+    }
+
+    if(argc > 0 && strcmp(argv[0], "lru") == 0)
+    {
+        return benchLRU(argc - 1, argv + 1);
+    }
+
+    if(argc > 0 && strcmp(argv[0], "parallel") == 0)
+    {
+        return benchParallel(argc - 1, argv + 1);
+    }
+
+    if(argc > 0 && strcmp(argv[0], "timeparallel") == 0)
+    {
+        return benchTimeParallel(argc - 1, argv + 1);
+    }
+
+    if(argc > 0 && strcmp(argv[0], "skip") == 0)
+    {
+        return benchSkip(argc - 1, argv + 1);
+    }
+
+    std::cout << "Available benchmarks: merge [records], tagstore [lookups], tagmatch [lookups], lru [accesses], parallel <config> [threads] [quantum], timeparallel <config> [segments] [overlap] [end ts] [penalty], skip <config> [penalty]" << std::endl;
+    return 1;
+}
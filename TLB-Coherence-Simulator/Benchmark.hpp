@@ -0,0 +1,17 @@
+//
+//  Benchmark.hpp
+//  TLB-Coherence-Simulator
+//
+//  Copyright © 2018 Yashwant Marathe. All rights reserved.
+//
+
+#ifndef Benchmark_hpp
+#define Benchmark_hpp
+
+#include <iostream>
+
+//Microbenchmarks for simulator internals, run as: prog -bench <name> [args]
+//Returns the process exit status
+int runBenchmark(int argc, char *argv[]);
+
+#endif /* Benchmark_hpp */
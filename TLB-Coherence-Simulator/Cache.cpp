@@ -13,6 +13,7 @@
 #include <iomanip>
 #include "utils.hpp"
 #include "Core.hpp"
+#include "ParallelSim.hpp"
 #include <climits>
 
 uint64_t Cache::get_line_offset(const uint64_t addr)
@@ -30,21 +31,23 @@ uint64_t Cache::get_tag(const uint64_t addr)
     return ((addr >> m_num_line_offset_bits) >> m_num_index_bits);
 }
 
-bool Cache::is_found(const std::vector<CacheLine>& set, const uint64_t tag, bool is_translation, uint64_t tid, unsigned int &hit_pos)
+bool Cache::is_found(uint64_t index, const uint64_t tag, bool is_translation, uint64_t tid, unsigned int &hit_pos)
 {
-    auto it = std::find_if(set.begin(), set.end(), [tag, is_translation, tid, this](const CacheLine &l)
-                           {
-                               //Threads share address space, so no need to check for tid if the request type is not translation
-                               return (is_translation) ?  ((l.tag == tag) && (l.valid) && (l.is_translation == is_translation) && (l.tid == tid)) :  ((l.tag == tag) && (l.valid) && (l.is_translation == is_translation));
-                           });
-    
-    hit_pos = static_cast<unsigned int>(it - set.begin());
-    return (it != set.end());
+    hit_pos = m_tag_store.find(index, tag, is_translation, tid);
+    return (hit_pos != m_associativity);
+}
+
+bool Cache::is_hit(uint64_t index, const uint64_t tag, bool is_translation, uint64_t tid, unsigned int &hit_pos)
+{
+    return is_found(index, tag, is_translation, tid, hit_pos) && !m_tag_store.line(index, hit_pos).is_locked();
 }
 
-bool Cache::is_hit(const std::vector<CacheLine> &set, const uint64_t tag, bool is_translation, uint64_t tid, unsigned int &hit_pos)
+CoherenceAction Cache::update_coherence_state(TagStore::Line line, kind txn_kind, CoherenceState propagate_coh_state)
 {
-    return is_found(set, tag, is_translation, tid, hit_pos) & !set[hit_pos].lock;
+    CoherenceState coh_state = line.get_coherence_state();
+    CoherenceAction coh_action = nextCoherenceState(*m_coherence_table, coh_state, txn_kind, m_cache_level == 1, propagate_coh_state);
+    line.set_coherence_state(coh_state);
+    return coh_action;
 }
 
 void Cache::invalidate(const uint64_t addr, uint64_t tid, bool is_translation)
@@ -52,13 +55,12 @@ void Cache::invalidate(const uint64_t addr, uint64_t tid, bool is_translation)
     unsigned int hit_pos;
     uint64_t tag = get_tag(addr);
     uint64_t index = get_index(addr);
-    std::vector<CacheLine>& set = m_tagStore[index];
     
     //If we find line in the cache, invalidate the line
     
-    if(is_found(set, tag, is_translation, tid, hit_pos))
+    if(is_found(index, tag, is_translation, tid, hit_pos))
     {
-        set[hit_pos].valid = false;
+        m_tag_store.line(index, hit_pos).set_valid(false);
     }
     
     //Go all the way up to highest cache
@@ -81,11 +83,13 @@ void Cache::invalidate(const uint64_t addr, uint64_t tid, bool is_translation)
 
 }
 
-void Cache::evict(uint64_t set_num, const CacheLine &line)
+void Cache::evict(uint64_t set_num, unsigned int way)
 {
+    TagStore::Line line = m_tag_store.line(set_num, way);
+
     //Send back invalidate
     
-    uint64_t evict_addr = ((line.tag << m_num_line_offset_bits) << m_num_index_bits) | (set_num << m_num_line_offset_bits);
+    uint64_t evict_addr = ((line.tag() << m_num_line_offset_bits) << m_num_index_bits) | (set_num << m_num_line_offset_bits);
     
     if(m_inclusive)
     {
@@ -97,7 +101,7 @@ void Cache::evict(uint64_t set_num, const CacheLine &line)
                 auto higher_cache = m_higher_caches[i].lock();
                 if(higher_cache != nullptr)
                 {
-                    higher_cache->invalidate(evict_addr, line.tid, line.is_translation);
+                    higher_cache->invalidate(evict_addr, line.tid(), line.is_translation());
                 }
             }
         }
@@ -110,25 +114,39 @@ void Cache::evict(uint64_t set_num, const CacheLine &line)
     //Send writeback if dirty
     //If not, due to inclusiveness, lower caches still have data
     //So do runtime check to ensure hit (and inclusiveness)
-    if(line.valid)
+    if(line.is_valid())
     {
-        std::shared_ptr<Cache> lower_cache = find_lower_cache_in_core(evict_addr, line.is_translation, line.is_large);
+        std::shared_ptr<Cache> lower_cache = find_lower_cache_in_core(evict_addr, line.is_translation(), line.is_large());
     
-        Request req(evict_addr, line.is_translation ? TRANSLATION_WRITEBACK : DATA_WRITEBACK, line.tid, line.is_large, m_core_id);
+        Request req(evict_addr, line.is_translation() ? TRANSLATION_WRITEBACK : DATA_WRITEBACK, line.tid(), line.is_large(), m_core_id);
     
-        if((line.dirty || line.is_translation))
+        if((line.is_dirty() || line.is_translation()))
         {
             if(lower_cache != nullptr)
             {
                 CacheType lower_cache_type = lower_cache->get_cache_type();
                 bool is_tr_to_dat_boundary = (m_cache_type == TRANSLATION_ONLY) && (lower_cache_type == DATA_AND_TRANSLATION);
                 req.m_addr = (is_tr_to_dat_boundary) ? m_core->getL3TLBAddr(req.m_addr, req.m_type, req.m_tid, req.m_is_large, false) : req.m_addr;
-                RequestStatus val = lower_cache->lookupAndFillCache(req, 0, line.m_coherence_prot->getCoherenceState());
-                line.m_coherence_prot->forceCoherenceState(INVALID);
 
-                if(m_inclusive)
+                if(ParallelSim::is_deferring() && lower_cache->get_core_id() == -1)
                 {
-                    assert((val == REQUEST_HIT) || (val == MSHR_HIT_AND_LOCKED));
+                    CoherenceState coh_state = line.get_coherence_state();
+                    bool inclusive = m_inclusive;
+                    ParallelSim::defer([lower_cache, req, coh_state, inclusive]() mutable {
+                        RequestStatus val = lower_cache->lookupAndFillCache(req, 0, coh_state);
+                        assert(!inclusive || (val == REQUEST_HIT) || (val == MSHR_HIT_AND_LOCKED));
+                    });
+                    line.set_coherence_state(INVALID);
+                }
+                else
+                {
+                    RequestStatus val = lower_cache->lookupAndFillCache(req, 0, line.get_coherence_state());
+                    line.set_coherence_state(INVALID);
+
+                    if(m_inclusive)
+                    {
+                        assert((val == REQUEST_HIT) || (val == MSHR_HIT_AND_LOCKED));
+                    }
                 }
             }
             else
@@ -136,9 +154,9 @@ void Cache::evict(uint64_t set_num, const CacheLine &line)
                 //Writeback to memory
             }
         }
-        else if(!line.dirty)
+        else if(!line.is_dirty())
         {
-            line.m_coherence_prot->forceCoherenceState(INVALID);
+            line.set_coherence_state(INVALID);
         }
         else
         {
@@ -147,8 +165,7 @@ void Cache::evict(uint64_t set_num, const CacheLine &line)
                 unsigned int hit_pos;
                 uint64_t index = lower_cache->get_index(evict_addr);
                 uint64_t tag = lower_cache->get_tag(evict_addr);
-                std::vector<CacheLine> set = lower_cache->m_tagStore[index];
-                assert(lower_cache->is_found(set, tag, line.is_translation, line.tid, hit_pos));
+                assert(lower_cache->is_found(index, tag, line.is_translation(), line.tid(), hit_pos));
             }
         }
     }
@@ -157,7 +174,7 @@ void Cache::evict(uint64_t set_num, const CacheLine &line)
     //If we're in penultimate TLB and performing an eviction, update the presence map
     if(m_cache_sys->get_is_translation_hier() && m_cache_sys->is_penultimate_level(m_cache_level))
     {
-        Request req(evict_addr, TRANSLATION_READ, line.tid, line.is_large, m_core_id);
+        Request req(evict_addr, TRANSLATION_READ, line.tid(), line.is_large(), m_core_id);
         bool is_found = false;
 
         for(int i = 0; i < m_higher_caches.size(); i++)
@@ -169,7 +186,7 @@ void Cache::evict(uint64_t set_num, const CacheLine &line)
         if(!is_found)
         {
             //std::cout << "[EVICTION] Removing from presence map = " << std::hex << req << std::dec;
-            m_tp_ptr->remove_from_presence_map(evict_addr, line.tid, line.is_large, m_core_id);
+            m_tp_ptr->remove_from_presence_map(evict_addr, line.tid(), line.is_large(), m_core_id);
         }
         //std::cout << "[EVICTION]: In level = " << m_cache_level << " and in hier = " << m_cache_sys->get_is_translation_hier() << "\n";
     }
@@ -186,11 +203,10 @@ bool Cache::lookupCache(Request &req)
 
     uint64_t tag = get_tag(addr);
     uint64_t index = get_index(addr);
-    std::vector<CacheLine>& set = m_tagStore[index];
 
     bool is_translation = (txn_kind == TRANSLATION_WRITE) | (txn_kind == TRANSLATION_WRITEBACK) | (txn_kind == TRANSLATION_READ);
 
-    if(is_found(set, tag, is_translation, tid, hit_pos))
+    if(is_found(index, tag, is_translation, tid, hit_pos))
     {
         return true;
     }
@@ -198,6 +214,22 @@ bool Cache::lookupCache(Request &req)
     return false;
 }
 
+void Cache::wait_in_flight(std::shared_ptr<Request> r, bool is_translation, bool is_large)
+{
+    uint64_t deadline;
+    RequestQueue *in_flight = find_in_flight(r->m_addr, is_translation, is_large, deadline);
+
+    if(in_flight != nullptr)
+    {
+        in_flight->insert(deadline, r);
+    }
+    else
+    {
+        //The in-flight request already retired, and released the MSHR entry, in this quantum: r is served by the next tick
+        m_cache_sys->m_wait_list.insert(m_cache_sys->m_clk, r);
+    }
+}
+
 RequestStatus Cache::lookupAndFillCache(Request &req, unsigned int curr_latency, CoherenceState propagate_coh_state)
 {
     unsigned int hit_pos;
@@ -222,7 +254,6 @@ RequestStatus Cache::lookupAndFillCache(Request &req, unsigned int curr_latency,
     
     uint64_t tag = get_tag(addr);
     uint64_t index = get_index(addr);
-    std::vector<CacheLine>& set = m_tagStore[index];
 
     if(m_core_id == -1)
     {
@@ -236,7 +267,7 @@ RequestStatus Cache::lookupAndFillCache(Request &req, unsigned int curr_latency,
 
     bool is_translation = (txn_kind == TRANSLATION_WRITE) | (txn_kind == TRANSLATION_WRITEBACK) | (txn_kind == TRANSLATION_READ);
 
-    if(is_hit(set, tag, is_translation, tid, hit_pos))
+    if(is_hit(index, tag, is_translation, tid, hit_pos))
     {
         #ifdef DEADLOCK_DEBUG
         if(req.m_addr == 0x0)
@@ -245,38 +276,30 @@ RequestStatus Cache::lookupAndFillCache(Request &req, unsigned int curr_latency,
         }
         #endif
 
-        CacheLine &line = set[hit_pos];
+        TagStore::Line line = m_tag_store.line(index, hit_pos);
         
-        cur_addr = ((line.tag << m_num_line_offset_bits) << m_num_index_bits) | (index << m_num_line_offset_bits);
+        cur_addr = ((line.tag() << m_num_line_offset_bits) << m_num_index_bits) | (index << m_num_line_offset_bits);
         
         //Is line dirty now?
-        line.dirty = line.dirty || (((txn_kind == DATA_WRITE) || (txn_kind == TRANSLATION_WRITE)) && (m_cache_level == 1)) || (txn_kind == DATA_WRITEBACK);
+        line.set_dirty(line.is_dirty() || (((txn_kind == DATA_WRITE) || (txn_kind == TRANSLATION_WRITE)) && (m_cache_level == 1)) || (txn_kind == DATA_WRITEBACK));
         
-        assert(!((txn_kind == TRANSLATION_WRITE) | (txn_kind == TRANSLATION_WRITEBACK) | (txn_kind == TRANSLATION_READ)) ^(line.is_translation));
+        assert(!((txn_kind == TRANSLATION_WRITE) | (txn_kind == TRANSLATION_WRITEBACK) | (txn_kind == TRANSLATION_READ)) ^(line.is_translation()));
         
         m_repl->updateReplState(index, hit_pos);
 
         req.add_callback(m_callback);
         std::shared_ptr<Request> r = std::make_shared<Request>(req);
         
-        uint64_t deadline = m_cache_sys->m_clk + curr_latency;
-        
-        //If element already exists in list, push deadline.
-        while(m_cache_sys->m_hit_list.find(deadline) != m_cache_sys->m_hit_list.end())
-        {
-            deadline++;
-        }
-    
-        m_cache_sys->m_hit_list.insert(std::make_pair(deadline, r));
+        m_cache_sys->m_hit_list.insert(m_cache_sys->m_clk + curr_latency, r);
 
         //Coherence handling
-        CoherenceAction coh_action = line.m_coherence_prot->setNextCoherenceState(txn_kind, propagate_coh_state);
+        CoherenceAction coh_action = update_coherence_state(line, txn_kind, propagate_coh_state);
         
         //If we need to do writeback, we need to do it for addr already in cache
         //If we need to broadcast, we need to do it for addr in lookupAndFillCache call
         coh_addr = (coh_action == MEMORY_DATA_WRITEBACK || coh_action == MEMORY_TRANSLATION_WRITEBACK) ? cur_addr : addr;
-        coh_tid = (coh_action == MEMORY_DATA_WRITEBACK || coh_action == MEMORY_TRANSLATION_WRITEBACK) ? line.tid : tid;
-        coh_is_large = (coh_action == MEMORY_DATA_WRITEBACK || coh_action == MEMORY_TRANSLATION_WRITEBACK) ? line.is_large : is_large;
+        coh_tid = (coh_action == MEMORY_DATA_WRITEBACK || coh_action == MEMORY_TRANSLATION_WRITEBACK) ? line.tid() : tid;
+        coh_is_large = (coh_action == MEMORY_DATA_WRITEBACK || coh_action == MEMORY_TRANSLATION_WRITEBACK) ? line.is_large() : is_large;
         
         req.m_addr = coh_addr;
         req.m_tid = coh_tid;
@@ -293,8 +316,7 @@ RequestStatus Cache::lookupAndFillCache(Request &req, unsigned int curr_latency,
         return REQUEST_HIT;
     }
     
-    auto it_not_valid = std::find_if(set.begin(), set.end(), [](const CacheLine &l) { return !l.valid; });
-    bool needs_eviction = (it_not_valid == set.end()) && (!is_found(set, tag, is_translation, tid, hit_pos));
+    bool needs_eviction = (m_tag_store.find_invalid(index) == m_associativity) && (!is_found(index, tag, is_translation, tid, hit_pos));
   
     if(txn_kind == TRANSLATION_WRITEBACK || txn_kind == DATA_WRITEBACK)
     {
@@ -310,15 +332,7 @@ RequestStatus Cache::lookupAndFillCache(Request &req, unsigned int curr_latency,
         req.add_callback(m_callback);
         std::shared_ptr<Request> r = std::make_shared<Request>(req);
 
-        uint64_t deadline = m_cache_sys->m_clk + curr_latency;
-
-        //If element already exists in list, push deadline.
-        while(m_cache_sys->m_hit_list.find(deadline) != m_cache_sys->m_hit_list.end())
-        {
-            deadline++;
-        }
-
-        m_cache_sys->m_hit_list.insert(std::make_pair(deadline, r));
+        m_cache_sys->m_hit_list.insert(m_cache_sys->m_clk + curr_latency, r);
 
         return REQUEST_MISS;
     }
@@ -328,117 +342,66 @@ RequestStatus Cache::lookupAndFillCache(Request &req, unsigned int curr_latency,
 
     bool mshr_hit = false;
 
-    unsigned int mshr_size = m_cache_sys->is_last_level(m_cache_level) ? 32 * NUM_CORES :
-                                m_cache_sys->is_penultimate_level(m_cache_level) && !m_cache_sys->get_is_translation_hier() ? 32 : 16;
+    if(m_mshr.get_capacity() == 0)
+    {
+        m_mshr.set_capacity((m_mshr_size != 0) ? m_mshr_size : default_mshr_size());
+    }
+
+    mshr_occupancy_sum += m_mshr.size();
+    num_mshr_lookups++;
 
-    auto mshr_iter = m_mshr_addr.find(req.m_addr);
+    uint32_t mshr_head = m_mshr.find_addr(req.m_addr);
 
-    if(mshr_iter != m_mshr_addr.end())
+    if(mshr_head != MSHRFile::NO_ENTRY)
     {
-        bool found_req = (m_mshr_entries.find(req) != m_mshr_entries.end());
+        bool found_req = (m_mshr.find(req) != MSHRFile::NO_ENTRY);
 
         if(req.m_type == TRANSLATION_WRITE || req.m_type == DATA_WRITE)
         {
-            for(auto it = mshr_iter->second.begin(); it != mshr_iter->second.end(); it++)
+            for(uint32_t e = mshr_head; e != MSHRFile::NO_ENTRY; e = m_mshr.next(e))
             {
-                QueueEntry *q = *it;
-                q->m_dirty = true;
+                m_mshr[e].m_dirty = true;
             }
         }
 
         //If MSHR hit due to request from another core, mark MSHR entry as core-agnostic.
         //OR safely mark all MSHR hits as core agnostic
-        for(auto it = mshr_iter->second.begin(); it != mshr_iter->second.end(); it++)
+        for(uint32_t e = mshr_head; e != MSHRFile::NO_ENTRY; e = m_mshr.next(e))
         {
-            QueueEntry *q = *it;
-            q->m_is_core_agnostic = true;
+            m_mshr[e].m_is_core_agnostic = true;
         }
 
-        //If Cachesys is not last cachesys, point to last cachesys
-        //TODO: FIXME: Ugly hack, fix this
-        CacheSys* cs_ptr = (m_cache_sys->get_core_id() != (NUM_CORES - 1)) ? m_cache_sys->m_other_cache_sys[NUM_CORES - 2].get() : m_cache_sys;
-        assert(cs_ptr->get_core_id() == (NUM_CORES - 1));
-
-        bool added_to_list = false;
-
-        for(auto it = cs_ptr->m_wait_list.begin(); it != cs_ptr->m_wait_list.end() ; it++)
+        //If we did not find exact request in MSHR, the request waits for the in-flight request of the same address
+        if(!found_req)
         {
-            //If we did not find exact request in MSHR, add the current request to wait list
-            if(it->second->m_addr == req.m_addr && !found_req)
-            {
-                req.add_callback(m_callback);
-                std::shared_ptr<Request> r = std::make_shared<Request>(req);
-
-                uint64_t deadline = it->first;
-
-                while(cs_ptr->m_wait_list.find(deadline) != cs_ptr->m_wait_list.end())
-                {
-                    deadline++;
-                }
+            req.add_callback(m_callback);
+            std::shared_ptr<Request> r = std::make_shared<Request>(req);
 
-                cs_ptr->m_wait_list.insert(std::make_pair(deadline, r));
-                added_to_list = true;
-                break;
-            }
-        }
+            uint64_t deadline;
 
-        for(auto it = cs_ptr->m_hit_list.begin(); it != cs_ptr->m_hit_list.end() && !added_to_list; it++)
-        {
-            //If we did not find exact request in MSHR, add the current request to wait list
-            if(it->second->m_addr == req.m_addr && !found_req && it->second->m_is_core_agnostic)
+            if(ParallelSim::is_deferring())
             {
-                req.add_callback(m_callback);
-                std::shared_ptr<Request> r = std::make_shared<Request>(req);
-
-                uint64_t deadline = it->first;
-
-                while(cs_ptr->m_wait_list.find(deadline) != cs_ptr->m_wait_list.end())
+                //Worker threads only queue behind a hit of their own hierarchy. The queues of the shared levels
+                //and of the other cores change in the serial phase, the in-flight request is looked up there.
+                if(m_cache_sys->m_hit_list.find_addr(req.m_addr, false, deadline))
                 {
-                    deadline++;
+                    m_cache_sys->m_hit_list.insert(deadline, r);
                 }
-
-                cs_ptr->m_wait_list.insert(std::make_pair(deadline, r));
-                added_to_list = true;
-                break;
-            }
-        }
-
-        for(auto it = m_cache_sys->m_hit_list.begin(); it != m_cache_sys->m_hit_list.end() && !added_to_list; it++)
-        {
-            //If we did not find exact request in MSHR, add the current request to wait list
-            if(it->second->m_addr == req.m_addr && !found_req)
-            {
-                req.add_callback(m_callback);
-                std::shared_ptr<Request> r = std::make_shared<Request>(req);
-
-                uint64_t deadline = it->first;
-
-                while(m_cache_sys->m_hit_list.find(deadline) != m_cache_sys->m_hit_list.end())
+                else
                 {
-                    deadline++;
+                    ParallelSim::defer([this, r, is_translation, is_large]() {
+                        wait_in_flight(r, is_translation, is_large);
+                    });
                 }
-
-                m_cache_sys->m_hit_list.insert(std::make_pair(deadline, r));
-                added_to_list = true;
-                break;
             }
-        }
-
-        //TODO:FIXME: Ugly hack to fix TID mismatch while retiring from MSHR
-        if(!added_to_list && !found_req)
-        {
-            std::cout << "[MSHR_HIT_NOT_ADDED_TO_LIST] At clk = " << m_core->m_clk << ", in hier = " << m_cache_sys->get_is_translation_hier() << ", in level = " << m_cache_level << ":" << std::hex << req << std::dec;
-            req.add_callback(m_callback);
-            std::shared_ptr<Request> r = std::make_shared<Request>(req);
-
-            uint64_t deadline = m_cache_sys->m_clk + 1;
-
-            while(m_cache_sys->m_hit_list.find(deadline) != m_cache_sys->m_hit_list.end())
+            else
             {
-                deadline++;
-            }
+                RequestQueue *in_flight = find_in_flight(req.m_addr, is_translation, is_large, deadline);
 
-            m_cache_sys->m_hit_list.insert(std::make_pair(deadline, r));
+                //Every MSHR entry has its request queued somewhere until it retires
+                assert(in_flight != nullptr);
+                in_flight->insert(deadline, r);
+            }
         }
 
         num_mshr_tr_hits += (is_translation);
@@ -459,32 +422,17 @@ RequestStatus Cache::lookupAndFillCache(Request &req, unsigned int curr_latency,
 
         mshr_hit = true;
     }
-    else if(m_mshr_entries.size() < mshr_size)
+    else if(!m_mshr.full())
     {
-        QueueEntry *queue_entry = new QueueEntry();
+        uint32_t e = m_mshr.allocate(req);
 
         if(req.m_type == TRANSLATION_WRITE || req.m_type == DATA_WRITE)
         {
-            queue_entry->m_dirty = true;
+            m_mshr[e].m_dirty = true;
         }
 
-        m_mshr_entries.insert(std::make_pair(req, queue_entry));
-        if(m_mshr_addr.find(req.m_addr) != m_mshr_addr.end())
-        {
-            m_mshr_addr[req.m_addr].push_back(queue_entry);
-        }
-        else
-        {
-            m_mshr_addr[req.m_addr] = std::list<QueueEntry*>();
-            m_mshr_addr[req.m_addr].push_back(queue_entry);
-        }
-
-	    auto it = m_mshr_entries.find(req);
-	    //Ensure insertion in the MSHR
-	    assert(it != m_mshr_entries.end());
-
-        //Ensure insertion in the MSHR address list
-        assert(m_mshr_addr.find(req.m_addr) != m_mshr_addr.end());
+        //Ensure insertion in the MSHR
+        assert(m_mshr.find(req) == e);
 
         num_tr_misses += (is_translation);
         num_data_misses += (!is_translation);
@@ -508,6 +456,7 @@ RequestStatus Cache::lookupAndFillCache(Request &req, unsigned int curr_latency,
     else
     {
         //MSHR full
+        num_mshr_full_stalls++;
         return REQUEST_RETRY;
     }
     
@@ -526,6 +475,13 @@ RequestStatus Cache::lookupAndFillCache(Request &req, unsigned int curr_latency,
                 Request req_copy((is_tr_to_dat_boundary) ? m_core->getL3TLBAddr(addr, txn_kind, tid, is_large): addr, req.m_type, req.m_tid, req.m_is_large, req.m_core_id);
                 lower_cache->lookupAndFillCache(req_copy, curr_latency + m_latency_cycles);
             }
+            else if(ParallelSim::is_deferring() && lower_cache->get_core_id() == -1)
+            {
+                unsigned int latency = curr_latency + m_latency_cycles;
+                ParallelSim::defer([lower_cache, req, latency]() mutable {
+                    lower_cache->lookupAndFillCache(req, latency);
+                });
+            }
             else
             {
                 lower_cache->lookupAndFillCache(req, curr_latency + m_latency_cycles);
@@ -540,14 +496,7 @@ RequestStatus Cache::lookupAndFillCache(Request &req, unsigned int curr_latency,
     {
         req.add_callback(m_callback);
         std::shared_ptr<Request> r = std::make_shared<Request>(req);
-        uint64_t deadline = m_cache_sys->m_clk + curr_latency + m_cache_sys->m_memory_latency;
-        
-        //If element already exists in the list, move deadline.
-        while(m_cache_sys->m_wait_list.find(deadline) != m_cache_sys->m_wait_list.end())
-        {
-            deadline++;
-        }
-        m_cache_sys->m_wait_list.insert(std::make_pair(deadline, r));
+        m_cache_sys->m_wait_list.insert(m_cache_sys->m_clk + curr_latency + m_cache_sys->m_memory_latency, r);
     }
     //We are in last level of cache hier and translation entry and not doing writeback.
     //Go to L3 TLB.
@@ -576,15 +525,7 @@ void Cache::add_higher_cache(const std::weak_ptr<Cache>& c)
 void Cache::set_level(unsigned int level)
 {
     m_cache_level = level;
-    for(int i = 0; i < m_num_sets; i++)
-    {
-        std::vector<CacheLine> set = m_tagStore[i];
-        for(int j = 0; j < m_associativity; j++)
-        {
-            set[j].m_coherence_prot->set_level(level);
-            assert(set[j].m_coherence_prot->get_level() == m_cache_level);
-        }
-    }}
+}
 
 unsigned int Cache::get_level()
 {
@@ -593,12 +534,9 @@ unsigned int Cache::get_level()
 
 void Cache::printContents()
 {
-    for(auto &set: m_tagStore)
+    for(unsigned int i = 0; i < m_num_sets; i++)
     {
-        for(auto &line : set)
-        {
-            std::cout << *(line.m_coherence_prot) << line;
-        }
+        m_tag_store.print_set(std::cout, i);
         std::cout << std::endl;
     }
 }
@@ -610,7 +548,7 @@ void Cache::set_cache_sys(CacheSys *cache_sys)
 
 void Cache::release_lock(std::shared_ptr<Request> r)
 {
-    auto it = m_mshr_entries.find(*r);
+    uint32_t e = m_mshr.find(*r);
 
     #ifdef DEADLOCK_DEBUG
     if(r->m_addr == 0x0)
@@ -619,7 +557,7 @@ void Cache::release_lock(std::shared_ptr<Request> r)
     }
     #endif
 
-    if(it != m_mshr_entries.end())
+    if(e != MSHRFile::NO_ENTRY)
     {
         #ifdef DEADLOCK_DEBUG
         if(r->m_addr == 0x0)
@@ -635,24 +573,19 @@ void Cache::release_lock(std::shared_ptr<Request> r)
         unsigned int index = get_index(r->m_addr);
         unsigned int tag = get_tag(r->m_addr);
 
-        std::vector<CacheLine>& set = m_tagStore[index];
-        unsigned int insert_pos = m_repl->getVictim(set, index);
-        CacheLine &line = set[insert_pos];
-        QueueEntry *q = it->second;
+        unsigned int insert_pos = m_repl->getVictim(m_tag_store, index);
+        TagStore::Line line = m_tag_store.line(index, insert_pos);
+        MSHRFile::Entry *q = &m_mshr[e];
 
-        evict(index, line);
+        evict(index, insert_pos);
 
-        m_repl->updateReplState(index, insert_pos);
+        m_repl->insertReplState(index, insert_pos);
 
-        line.valid = true;
-        line.lock = false;
-        line.tag = tag;
-        line.is_translation = (txn_kind == TRANSLATION_READ) || (txn_kind == TRANSLATION_WRITE) || (txn_kind == TRANSLATION_WRITEBACK);
-        line.is_large = is_large;
-        line.tid = tid;
-        line.dirty = q->m_dirty || (((txn_kind == TRANSLATION_WRITE) || (txn_kind == DATA_WRITE)) && (m_cache_level == 1)) || (txn_kind == DATA_WRITEBACK);
+        bool is_translation = (txn_kind == TRANSLATION_READ) || (txn_kind == TRANSLATION_WRITE) || (txn_kind == TRANSLATION_WRITEBACK);
+        bool dirty = q->m_dirty || (((txn_kind == TRANSLATION_WRITE) || (txn_kind == DATA_WRITE)) && (m_cache_level == 1)) || (txn_kind == DATA_WRITEBACK);
         //If cache type is TRANSLATION_ONLY, include co-tag
-        line.cotag = (m_cache_type == TRANSLATION_ONLY) ? m_core->getL3TLBAddr(addr, txn_kind, tid, is_large, false) : -1;
+        uint64_t cotag = (m_cache_type == TRANSLATION_ONLY) ? m_core->getL3TLBAddr(addr, txn_kind, tid, is_large, false) : -1;
+        line.fill(tag, tid, cotag, is_translation, is_large, dirty);
 
         //If we are in the last level cache and queue_entry has been made core agnostic, make the upstream request core agnostic.
         if(q->m_is_core_agnostic && m_core_id == -1)
@@ -660,28 +593,17 @@ void Cache::release_lock(std::shared_ptr<Request> r)
 
         CoherenceState propagate_coh_state = q->m_coh_state;
 
-        CoherenceAction coh_action = line.m_coherence_prot->setNextCoherenceState(txn_kind, propagate_coh_state);
+        CoherenceAction coh_action = update_coherence_state(line, txn_kind, propagate_coh_state);
 
         handle_coherence_action(coh_action, *r, 0, true);
 
-        assert(m_mshr_addr.find(r->m_addr) != m_mshr_addr.end());
-
-        m_mshr_addr[r->m_addr].remove(q);
-
-        if(m_mshr_addr[r->m_addr].size() == 0)
-        {
-            m_mshr_addr.erase(r->m_addr);
-        }
-
-        delete(q);
-        
-        m_mshr_entries.erase(it);
+        m_mshr.release(e);
         
         //Ensure erasure in the MSHR
-        assert(m_mshr_entries.find(*r) == m_mshr_entries.end());
+        assert(m_mshr.find(*r) == MSHRFile::NO_ENTRY);
     }
 
-    it = m_wb_entries.find(*r);
+    auto it = m_wb_entries.find(*r);
 
     if(it != m_wb_entries.end())
     {
@@ -698,36 +620,31 @@ void Cache::release_lock(std::shared_ptr<Request> r)
         bool is_large = r->m_is_large;
         unsigned int index = get_index(r->m_addr);
         unsigned int tag = get_tag(r->m_addr);
-        std::vector<CacheLine>& set = m_tagStore[index];
 
-        unsigned int insert_pos = m_repl->getVictim(set, index);
-        CacheLine &line = set[insert_pos];
+        unsigned int insert_pos = m_repl->getVictim(m_tag_store, index);
+        TagStore::Line line = m_tag_store.line(index, insert_pos);
 
         Request req = *r;
 
-        req.m_addr = ((line.tag << m_num_line_offset_bits) << m_num_index_bits) | (index << m_num_line_offset_bits);
-        req.m_tid = line.tid;
-        req.m_is_large = line.is_large;
+        req.m_addr = ((line.tag() << m_num_line_offset_bits) << m_num_index_bits) | (index << m_num_line_offset_bits);
+        req.m_tid = line.tid();
+        req.m_is_large = line.is_large();
 
         CoherenceState propagate_coh_state = it->second->m_coh_state;
 
-        CoherenceAction coh_action = line.m_coherence_prot->setNextCoherenceState(txn_kind, propagate_coh_state);
+        CoherenceAction coh_action = update_coherence_state(line, txn_kind, propagate_coh_state);
 
         handle_coherence_action(coh_action, req, 0, true);
 
-        evict(index, line);
+        evict(index, insert_pos);
 
-        m_repl->updateReplState(index, insert_pos);
+        m_repl->insertReplState(index, insert_pos);
 
-        line.valid = true;
-        line.lock = false;
-        line.tag = tag;
-        line.is_translation = (txn_kind == TRANSLATION_READ) || (txn_kind == TRANSLATION_WRITE) || (txn_kind == TRANSLATION_WRITEBACK);
-        line.is_large = is_large;
-        line.tid = tid;
-        line.dirty = (((txn_kind == TRANSLATION_WRITE) || (txn_kind == DATA_WRITE)) && (m_cache_level == 1)) || (txn_kind == DATA_WRITEBACK) || (it->second->m_dirty);
+        bool is_translation = (txn_kind == TRANSLATION_READ) || (txn_kind == TRANSLATION_WRITE) || (txn_kind == TRANSLATION_WRITEBACK);
+        bool dirty = (((txn_kind == TRANSLATION_WRITE) || (txn_kind == DATA_WRITE)) && (m_cache_level == 1)) || (txn_kind == DATA_WRITEBACK) || (it->second->m_dirty);
         //If cache type is TRANSLATION_ONLY, include co-tag
-        line.cotag = (m_cache_type == TRANSLATION_ONLY) ? m_core->getL3TLBAddr(addr, txn_kind, tid, is_large, false) : -1;
+        uint64_t cotag = (m_cache_type == TRANSLATION_ONLY) ? m_core->getL3TLBAddr(addr, txn_kind, tid, is_large, false) : -1;
+        line.fill(tag, tid, cotag, is_translation, is_large, dirty);
 
         //If we are in the last level cache and queue_entry has been made core agnostic, make the upstream request core agnostic.
         if(it->second->m_is_core_agnostic && m_core_id == -1)
@@ -769,12 +686,93 @@ void Cache::release_lock(std::shared_ptr<Request> r)
     propagate_release_lock(r);
 }
 
+unsigned int Cache::get_associativity()
+{
+    return m_associativity;
+}
+
 unsigned int Cache::get_latency_cycles()
 {
     return m_latency_cycles;
 }
 
-bool Cache::handle_coherence_action(CoherenceAction coh_action, Request &r, unsigned int curr_latency, bool same_cache_sys)
+CacheSys* Cache::get_cache_sys()
+{
+    return m_cache_sys;
+}
+
+void Cache::set_mshr_size(unsigned int mshr_size)
+{
+    m_mshr_size = mshr_size;
+}
+
+unsigned int Cache::default_mshr_size()
+{
+    return m_cache_sys->is_last_level(m_cache_level) ? 32 * m_cache_sys->get_num_cores() :
+           m_cache_sys->is_penultimate_level(m_cache_level) && !m_cache_sys->get_is_translation_hier() ? 32 : 16;
+}
+
+unsigned int Cache::get_mshr_capacity() const
+{
+    return m_mshr.get_capacity();
+}
+
+unsigned int Cache::get_mshr_peak_occupancy() const
+{
+    return m_mshr.get_peak_size();
+}
+
+void Cache::reset_stats()
+{
+    num_data_hits = 0;
+    num_tr_hits = 0;
+    num_data_misses = 0;
+    num_tr_misses = 0;
+    num_mshr_data_hits = 0;
+    num_mshr_tr_hits = 0;
+    num_data_accesses = 0;
+    num_tr_accesses = 0;
+    num_data_coh_msgs = 0;
+    num_tr_coh_msgs = 0;
+    num_mshr_full_stalls = 0;
+    mshr_occupancy_sum = 0;
+    num_mshr_lookups = 0;
+
+    m_mshr.reset_peak_size();
+}
+
+void Cache::merge_stats(const Cache &other)
+{
+    num_data_hits += other.num_data_hits;
+    num_tr_hits += other.num_tr_hits;
+    num_data_misses += other.num_data_misses;
+    num_tr_misses += other.num_tr_misses;
+    num_mshr_data_hits += other.num_mshr_data_hits;
+    num_mshr_tr_hits += other.num_mshr_tr_hits;
+    num_data_accesses += other.num_data_accesses;
+    num_tr_accesses += other.num_tr_accesses;
+    num_data_coh_msgs += other.num_data_coh_msgs;
+    num_tr_coh_msgs += other.num_tr_coh_msgs;
+    num_mshr_full_stalls += other.num_mshr_full_stalls;
+    mshr_occupancy_sum += other.mshr_occupancy_sum;
+    num_mshr_lookups += other.num_mshr_lookups;
+
+    //The MSHR file is sized on the first miss, which this run may not have seen
+    if(m_mshr.get_capacity() == 0 && other.get_mshr_capacity() != 0)
+    {
+        m_mshr.set_capacity(other.get_mshr_capacity());
+    }
+
+    m_mshr.merge_peak_size(other.get_mshr_peak_occupancy());
+}
+
+void Cache::set_coherence_scheme(TranslationCoherenceScheme scheme)
+{
+    m_handle_coherence_action = (scheme == COTAG_SCHEME) ? &Cache::handle_coherence_action_scheme<true> : &Cache::handle_coherence_action_scheme<false>;
+}
+
+template <bool cotag>
+bool Cache::handle_coherence_action_scheme(CoherenceAction coh_action, Request &r, unsigned int curr_latency, bool same_cache_sys)
 {
     uint64_t addr = r.m_addr;
     uint64_t tid = r.m_tid;
@@ -803,7 +801,17 @@ bool Cache::handle_coherence_action(CoherenceAction coh_action, Request &r, unsi
                 req->m_addr = (m_cache_type == TRANSLATION_ONLY) ? m_core->getL3TLBAddr(addr, r.m_type, tid, is_large, false) : req->m_addr;
 
                 //TODO: Apply optimization to relay coherence updates to TLBs only on translation requests here
-                m_cache_sys->m_other_cache_sys[i]->m_coh_act_list.insert(std::make_pair(req, coh_action));
+                if(ParallelSim::is_deferring())
+                {
+                    CacheSys *other_cs = m_cache_sys->m_other_cache_sys[i].get();
+                    ParallelSim::defer([other_cs, req, coh_action]() {
+                        other_cs->m_coh_act_list.push_back(std::make_pair(req, coh_action));
+                    });
+                }
+                else
+                {
+                    m_cache_sys->m_other_cache_sys[i]->m_coh_act_list.push_back(std::make_pair(req, coh_action));
+                }
             }
         }
         //Coherence in data caches is enforced by address
@@ -814,41 +822,39 @@ bool Cache::handle_coherence_action(CoherenceAction coh_action, Request &r, unsi
             unsigned int hit_pos;
             uint64_t tag = get_tag(addr);
             uint64_t index = get_index(addr);
-            std::vector<CacheLine>& set = m_tagStore[index];
             //We might still be looking at a TRANSLATION_ENTRY because L2 and L3 are DATA_AND_TRANSLATION
             bool is_translation = (coh_action == BROADCAST_TRANSLATION_WRITE) || (coh_action == BROADCAST_TRANSLATION_READ);
             
-            if(is_found(set, tag, is_translation, tid, hit_pos))
+            if(is_found(index, tag, is_translation, tid, hit_pos))
             {
-                CacheLine &line = set[hit_pos];
+                TagStore::Line line = m_tag_store.line(index, hit_pos);
                 kind coh_txn_kind = txnKindForCohAction(coh_action);
-                line.m_coherence_prot->setNextCoherenceState(coh_txn_kind);
+                update_coherence_state(line, coh_txn_kind);
                 if(coh_txn_kind == DIRECTORY_DATA_WRITE || coh_txn_kind == DIRECTORY_TRANSLATION_WRITE)
                 {
-                    line.valid = false;
-                    assert(line.m_coherence_prot->getCoherenceState() == INVALID);
+                    line.set_valid(false);
+                    assert(line.get_coherence_state() == INVALID);
                 }
                 needs_state_correction = (coh_action == BROADCAST_DATA_READ) || (coh_action == BROADCAST_TRANSLATION_READ);
             }
         }
         //Translation coherence is enforced by co-tags
-#ifdef COTAG
-        else if(!same_cache_sys && (m_cache_type == TRANSLATION_ONLY))
+        else if(cotag && !same_cache_sys && (m_cache_type == TRANSLATION_ONLY))
         {
             assert(m_cache_sys->get_is_translation_hier());
             unsigned int index, hit_pos;
             
             if(is_found_by_cotag(addr, tid, index, hit_pos))
             {
-                CacheLine &line = m_tagStore[index][hit_pos];
+                TagStore::Line line = m_tag_store.line(index, hit_pos);
                 kind coh_txn_kind = txnKindForCohAction(coh_action);
-                line.m_coherence_prot->setNextCoherenceState(coh_txn_kind);
+                update_coherence_state(line, coh_txn_kind);
                 if(coh_txn_kind == DIRECTORY_TRANSLATION_WRITE)
                 {
                     std::cout << "[SHOOTDOWN] Invalidate line via co-tag on core " << m_core_id << ", level = " << m_cache_level << " : " <<  std::hex << r << std::dec;
                     
-                    line.valid = false;
-                    assert(line.m_coherence_prot->getCoherenceState() == INVALID);
+                    line.set_valid(false);
+                    assert(line.get_coherence_state() == INVALID);
 
                     if(m_cache_sys->get_is_translation_hier() && m_cache_sys->is_penultimate_level(m_cache_level))
                     {
@@ -861,7 +867,7 @@ bool Cache::handle_coherence_action(CoherenceAction coh_action, Request &r, unsi
             num_data_coh_msgs += (!is_translation);
             num_tr_coh_msgs += (is_translation);
         }
-#else
+        //Without co-tags, every line of the set the translation maps to is invalidated
         else if(!same_cache_sys && (m_cache_type == TRANSLATION_ONLY))
         {
             assert(m_cache_sys->get_is_translation_hier());
@@ -869,7 +875,7 @@ bool Cache::handle_coherence_action(CoherenceAction coh_action, Request &r, unsi
 
             if(is_translation)
             {
-                unsigned int pom_tlb_set_index = (is_large) ? (addr - m_core->m_l3_small_tlb_base - m_core->m_l3_small_tlb_size)/(16 * 4) : (addr - m_core->m_l3_small_tlb_base)/(16 * 4);
+                unsigned int pom_tlb_set_index = m_core->getL3TLBSetIndex(addr, is_large);
                 assert(pom_tlb_set_index >= 0);
                 unsigned int check_index, hit_pos;
                 unsigned int index = (pom_tlb_set_index) % (m_num_sets);
@@ -881,15 +887,15 @@ bool Cache::handle_coherence_action(CoherenceAction coh_action, Request &r, unsi
 
                 for(int j = 0; j < m_associativity; j++)
                 {
-                    CacheLine &line = m_tagStore[index][j];
+                    TagStore::Line line = m_tag_store.line(index, j);
                     kind coh_txn_kind = txnKindForCohAction(coh_action);
-                    line.m_coherence_prot->setNextCoherenceState(coh_txn_kind);
+                    update_coherence_state(line, coh_txn_kind);
                     if(coh_txn_kind == DIRECTORY_TRANSLATION_WRITE)
                     {
                         //std::cout << "[SHOOTDOWN] Invalidate line via co-tag on core " << m_core_id << ", level = " << m_cache_level << " : " <<  std::hex << r << std::dec;
 
-                        line.valid = false;
-                        assert(line.m_coherence_prot->getCoherenceState() == INVALID);
+                        line.set_valid(false);
+                        assert(line.get_coherence_state() == INVALID);
 
                         if(m_cache_sys->get_is_translation_hier() && m_cache_sys->is_penultimate_level(m_cache_level))
                         {
@@ -905,7 +911,6 @@ bool Cache::handle_coherence_action(CoherenceAction coh_action, Request &r, unsi
             num_tr_coh_msgs += (is_translation);
 
         }
-#endif
     }
     else if(coh_action == STATE_CORRECTION)
     {
@@ -913,12 +918,27 @@ bool Cache::handle_coherence_action(CoherenceAction coh_action, Request &r, unsi
         {
             unsigned int originating_core = r.m_core_id;
             assert(originating_core != m_core_id);
-            unsigned int index = (originating_core < m_core_id) ? originating_core : (originating_core - m_core_id - 1);
             //Since we are sending back the request that arrived, don't change the request address here
-            m_cache_sys->m_other_cache_sys[index]->m_coh_act_list.insert(std::make_pair(std::make_shared<Request>(r), coh_action));
-            if(!m_cache_sys->get_is_translation_hier())
+            CacheSys *data_cs = m_cache_sys->get_data_hier(originating_core);
+            CacheSys *tlb_cs = (!m_cache_sys->get_is_translation_hier()) ? m_cache_sys->get_tlb_hier(originating_core) : nullptr;
+
+            if(ParallelSim::is_deferring())
+            {
+                ParallelSim::defer([data_cs, tlb_cs, r, coh_action]() {
+                    data_cs->m_coh_act_list.push_back(std::make_pair(std::make_shared<Request>(r), coh_action));
+                    if(tlb_cs != nullptr)
+                    {
+                        tlb_cs->m_coh_act_list.push_back(std::make_pair(std::make_shared<Request>(r), coh_action));
+                    }
+                });
+            }
+            else
             {
-                m_cache_sys->m_other_cache_sys[(index + NUM_CORES - 1)]->m_coh_act_list.insert(std::make_pair(std::make_shared<Request>(r), coh_action));
+                data_cs->m_coh_act_list.push_back(std::make_pair(std::make_shared<Request>(r), coh_action));
+                if(tlb_cs != nullptr)
+                {
+                    tlb_cs->m_coh_act_list.push_back(std::make_pair(std::make_shared<Request>(r), coh_action));
+                }
             }
         }
         else
@@ -928,41 +948,34 @@ bool Cache::handle_coherence_action(CoherenceAction coh_action, Request &r, unsi
                 unsigned int hit_pos;
                 uint64_t tag = get_tag(addr);
                 uint64_t index = get_index(addr);
-                std::vector<CacheLine>& set = m_tagStore[index];
                 
-                if(is_found(set, tag, is_translation, tid, hit_pos))
+                if(is_found(index, tag, is_translation, tid, hit_pos))
                 {
-                    CacheLine &line = set[hit_pos];
-                    line.m_coherence_prot->forceCoherenceState(SHARED);
+                    m_tag_store.line(index, hit_pos).set_coherence_state(SHARED);
                 }
             }
-#ifdef COTAG
-            else
+            else if(cotag)
             {
                 unsigned int index, hit_pos;
                 if(is_found_by_cotag(addr, tid, index, hit_pos))
                 {
-                    CacheLine &line = m_tagStore[index][hit_pos];
-                    line.m_coherence_prot->forceCoherenceState(SHARED);
+                    m_tag_store.line(index, hit_pos).set_coherence_state(SHARED);
                 }
             }
-#else
             else
             {
                 if(is_translation)
                 {
-                    unsigned int pom_tlb_set_index = (is_large) ? (addr - m_core->m_l3_small_tlb_base - m_core->m_l3_small_tlb_size)/(16 * 4) : (addr - m_core->m_l3_small_tlb_base)/(16 * 4);
+                    unsigned int pom_tlb_set_index = m_core->getL3TLBSetIndex(addr, is_large);
                     assert(pom_tlb_set_index >= 0);
                     unsigned int check_index, hit_pos;
                     unsigned int index = (pom_tlb_set_index) % (m_num_sets);
                     for(int j = 0; j < m_associativity; j++)
                     {
-                        CacheLine &line = m_tagStore[index][j];
-                        line.m_coherence_prot->forceCoherenceState(SHARED);
+                        m_tag_store.line(index, j).set_coherence_state(SHARED);
                     }
                 }
             }
-#endif
         }
     }
     
@@ -972,6 +985,11 @@ bool Cache::handle_coherence_action(CoherenceAction coh_action, Request &r, unsi
 void Cache::set_cache_type(CacheType cache_type)
 {
     m_cache_type = cache_type;
+
+    if(m_cache_type == TRANSLATION_ONLY)
+    {
+        m_tag_store.enable_cotag_index();
+    }
 }
 
 CacheType Cache::get_cache_type()
@@ -984,6 +1002,63 @@ void Cache::set_core(std::shared_ptr<Core>& coreptr)
     m_core = coreptr;
 }
 
+RequestQueue* Cache::find_in_flight(uint64_t addr, bool is_translation, bool is_large, uint64_t &deadline)
+{
+    //Memory accesses of the shared last level wait in the CacheSys that level was attached to last
+    CacheSys* cs_ptr = m_cache_sys->m_caches.back()->get_cache_sys();
+
+    //The in-flight request is a memory access of the shared level, a core agnostic hit of the shared level, or a hit in this hierarchy
+    if(cs_ptr->m_wait_list.find_addr(addr, false, deadline) || cs_ptr->m_hit_list.find_addr(addr, true, deadline))
+    {
+        return &cs_ptr->m_wait_list;
+    }
+
+    if(m_cache_sys->m_hit_list.find_addr(addr, false, deadline))
+    {
+        return &m_cache_sys->m_hit_list;
+    }
+
+    //Or it is queued in the CacheSys of the lower cache
+    std::shared_ptr<Cache> lower_cache = find_lower_cache_in_core(addr, is_translation, is_large);
+
+    if(lower_cache != nullptr)
+    {
+        CacheSys *lower_cs = lower_cache->get_cache_sys();
+        if(lower_cs->m_wait_list.find_addr(addr, false, deadline) || lower_cs->m_hit_list.find_addr(addr, false, deadline))
+        {
+            return &lower_cs->m_wait_list;
+        }
+    }
+
+    //The shared level has no lower cache in the core, its misses may be queued in the hierarchy of any core,
+    //translations missing in the last level cache in the L3 TLB queues of the TLB hierarchy of the core that missed first
+    for(unsigned int i = 0; i < m_cache_sys->get_num_cores(); i++)
+    {
+        CacheSys *hiers[2] = {m_cache_sys->get_data_hier(i), m_cache_sys->get_tlb_hier(i)};
+
+        for(CacheSys *cs : hiers)
+        {
+            if(cs->m_wait_list.find_addr(addr, false, deadline) || cs->m_hit_list.find_addr(addr, false, deadline))
+            {
+                return &cs->m_wait_list;
+            }
+        }
+    }
+
+    //In a parallel run the shared levels have CacheSys of their own, see Simulator::run_parallel
+    CacheSys *shared[2] = {m_cache_sys->get_data_hier(0)->m_caches.back()->get_cache_sys(), m_cache_sys->get_tlb_hier(0)->m_caches.back()->get_cache_sys()};
+
+    for(CacheSys *cs : shared)
+    {
+        if(cs->m_core_id == -1 && (cs->m_wait_list.find_addr(addr, false, deadline) || cs->m_hit_list.find_addr(addr, false, deadline)))
+        {
+            return &cs->m_wait_list;
+        }
+    }
+
+    return nullptr;
+}
+
 std::shared_ptr<Cache> Cache::find_lower_cache_in_core(uint64_t addr, bool is_translation, bool is_large)
 {
     std::shared_ptr<Cache> lower_cache;
@@ -1112,20 +1187,7 @@ void Cache::initialize_callback()
 
 bool Cache::is_found_by_cotag(uint64_t pom_tlb_addr, uint64_t tid, unsigned int &index, unsigned int &hit_pos)
 {
-    for(int i = 0; i < m_num_sets; i++)
-    {
-        for(int j = 0; j < m_associativity; j++)
-        {
-            CacheLine &line = m_tagStore[i][j];
-            if(line.cotag == pom_tlb_addr && line.tid == tid)
-            {
-                index = i;
-                hit_pos = j;
-                return true; 
-            }
-        }
-    }
-    return false;
+    return m_tag_store.find_by_cotag(pom_tlb_addr, tid, index, hit_pos);
 }
 
 void Cache::add_traceprocessor(TraceProcessor *tp)
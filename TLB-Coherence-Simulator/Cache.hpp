@@ -17,12 +17,14 @@
 #include <memory>
 #include "utils.hpp"
 #include "ReplPolicy.hpp"
-#include "CacheLine.h"
+#include "TagStore.hpp"
+#include "MSHRFile.hpp"
 #include "Request.hpp"
 #include "Coherence.hpp"
 #include "TraceProcessor.hpp"
 
 class CacheSys;
+class RequestQueue;
 class Core;
 
 class Cache
@@ -48,22 +50,27 @@ private:
     std::vector<std::weak_ptr<Cache>> m_higher_caches;
     std::weak_ptr<Cache> m_lower_cache;
     
-    std::vector<std::vector<CacheLine>> m_tagStore;
+    TagStore m_tag_store;
     ReplPolicy *m_repl;
+
+    //Transitions of the coherence protocol, the state of every line is in m_tag_store
+    const CoherenceTable *m_coherence_table;
     
     CacheSys *m_cache_sys;
     
     std::shared_ptr<Core> m_core;
     
-    std::unordered_map<Request, QueueEntry*, RequestHasher> m_mshr_entries;
-
-    std::unordered_map<uint64_t, std::list<QueueEntry*>> m_mshr_addr;
+    //Sized on the first miss, once the cache knows its place in the hierarchy
+    MSHRFile m_mshr;
 
     std::unordered_map<Request, QueueEntry*, RequestHasher> m_wb_entries;
     
     unsigned int m_cache_level;
     unsigned int m_latency_cycles;
 
+    //0 sizes the MSHR by the level of the cache
+    unsigned int m_mshr_size = 0;
+
     std::function<void(std::shared_ptr<Request>)> m_callback;
     
     bool m_is_coherence_enabled;
@@ -79,6 +86,23 @@ private:
     bool m_is_callback_initialized;
 
     TraceProcessor* m_tp_ptr;
+
+    //Coherence handling for the translation coherence scheme in use, set once by set_coherence_scheme
+    bool (Cache::*m_handle_coherence_action)(CoherenceAction, Request&, unsigned int, bool) = &Cache::handle_coherence_action_scheme<false>;
+
+    template <bool cotag>
+    bool handle_coherence_action_scheme(CoherenceAction coh_action, Request& r, unsigned int curr_latency, bool same_cache_sys);
+
+    CoherenceAction update_coherence_state(TagStore::Line line, kind txn_kind, CoherenceState propagate_coh_state = INVALID);
+
+    //Entries of the MSHR file when mshr_size is left at 0
+    unsigned int default_mshr_size();
+
+    //Queue to wait in behind the in-flight request for addr, and the cycle that request is due, nullptr if it is queued nowhere
+    RequestQueue* find_in_flight(uint64_t addr, bool is_translation, bool is_large, uint64_t &deadline);
+
+    //Queues r, an MSHR hit, behind the in-flight request, from the serial phase of a parallel run, see ParallelSim
+    void wait_in_flight(std::shared_ptr<Request> r, bool is_translation, bool is_large);
     
 public:
     uint64_t num_data_hits = 0;
@@ -91,32 +115,35 @@ public:
     uint64_t num_tr_accesses = 0;
     uint64_t num_data_coh_msgs = 0;
     uint64_t num_tr_coh_msgs = 0;
+    //Misses turned away with REQUEST_RETRY because the MSHR file was full
+    uint64_t num_mshr_full_stalls = 0;
+    //Entries in use seen by each miss, for the average occupancy
+    uint64_t mshr_occupancy_sum = 0;
+    uint64_t num_mshr_lookups = 0;
 
     Cache(int num_sets, int associativity, int line_size, unsigned int latency_cycles, CacheType cache_type = DATA_ONLY, bool is_large_page_tlb = false, enum ReplPolicyEnum pol = LRU_POLICY, enum CoherenceProtocolEnum prot = MOESI_COHERENCE, bool inclusive = false):
-    m_num_sets(num_sets), m_associativity(associativity), m_line_size(line_size), m_latency_cycles(latency_cycles)
+    m_num_sets(num_sets), m_associativity(associativity), m_line_size(line_size), m_tag_store(num_sets, associativity), m_latency_cycles(latency_cycles)
     {
         
         m_num_line_offset_bits = log2(m_line_size);
         m_num_index_bits = log2(m_num_sets);
         m_num_tag_bits = ADDR_SIZE - m_num_line_offset_bits - m_num_index_bits;
         
-        m_tagStore.reserve(m_num_sets);
-        for(int i = 0; i < m_num_sets; i++)
-        {
-            std::vector<CacheLine> set;
-            for(int j = 0; j < m_associativity; j++)
-            {
-                set.emplace_back();
-                
-                //Want to associate a coherence protocol object with each cache line
-                CoherenceProtocol *coherence_prot = new MOESIProtocol();
-                set[j].set_coherence_prot(coherence_prot);
-                
-            }
-            m_tagStore.push_back(set);
-        }
+        m_coherence_table = &coherenceTable(prot);
         
         switch(pol) {
+            case PLRU_POLICY:
+                m_repl = new PLRURepl(m_num_sets, m_associativity);
+                break;
+            case SRRIP_POLICY:
+                m_repl = new RRIPRepl(m_num_sets, m_associativity, false);
+                break;
+            case BRRIP_POLICY:
+                m_repl = new RRIPRepl(m_num_sets, m_associativity, true);
+                break;
+            case RANDOM_POLICY:
+                m_repl = new RandomRepl(m_num_sets, m_associativity);
+                break;
             case LRU_POLICY:
             default:
                 m_repl = new LRURepl(m_num_sets, m_associativity);
@@ -129,6 +156,12 @@ public:
         
         m_cache_type = cache_type;
         
+        //Translation coherence finds TLB lines by co-tag
+        if(m_cache_type == TRANSLATION_ONLY)
+        {
+            m_tag_store.enable_cotag_index();
+        }
+        
         m_is_large_page_tlb = is_large_page_tlb;
         
         m_is_callback_initialized = false;
@@ -138,10 +171,10 @@ public:
     uint64_t get_index(const uint64_t addr);
     uint64_t get_tag(const uint64_t addr);
     uint64_t get_line_offset(const uint64_t addr);
-    bool is_found(const std::vector<CacheLine>& set, const uint64_t tag, bool is_translation, uint64_t tid, unsigned int &hit_pos);
-    bool is_hit(const std::vector<CacheLine> &set, const uint64_t tag, bool is_translation, uint64_t tid, unsigned int &hit_pos);
+    bool is_found(uint64_t index, const uint64_t tag, bool is_translation, uint64_t tid, unsigned int &hit_pos);
+    bool is_hit(uint64_t index, const uint64_t tag, bool is_translation, uint64_t tid, unsigned int &hit_pos);
     void invalidate(const uint64_t addr, uint64_t tid, bool is_translation);
-    void evict(uint64_t set_num, const CacheLine &line);
+    void evict(uint64_t set_num, unsigned int way);
     RequestStatus lookupAndFillCache(Request &r, unsigned int curr_latency = 0, CoherenceState propagate_coh_state = INVALID);
     bool lookupCache(Request &r);
     void add_lower_cache(const std::weak_ptr<Cache>& c);
@@ -151,8 +184,21 @@ public:
     void release_lock(std::shared_ptr<Request> r);
     void printContents();
     void set_cache_sys(CacheSys *cache_sys);
+    CacheSys* get_cache_sys();
     unsigned int get_latency_cycles();
-    bool handle_coherence_action(CoherenceAction coh_action, Request& r, unsigned int curr_latency, bool same_cache_sys);
+    unsigned int get_associativity();
+    void set_mshr_size(unsigned int mshr_size);
+    unsigned int get_mshr_capacity() const;
+    unsigned int get_mshr_peak_occupancy() const;
+    //Zeroes the counters, accesses from here on are counted
+    void reset_stats();
+    //Adds the counters of other, the same cache in another run
+    void merge_stats(const Cache &other);
+    void set_coherence_scheme(TranslationCoherenceScheme scheme);
+    bool handle_coherence_action(CoherenceAction coh_action, Request& r, unsigned int curr_latency, bool same_cache_sys)
+    {
+        return (this->*m_handle_coherence_action)(coh_action, r, curr_latency, same_cache_sys);
+    }
     void set_cache_type(CacheType cache_type);
     CacheType get_cache_type();
     void set_core(std::shared_ptr<Core>& coreptr);
@@ -9,6 +9,8 @@
 #include "CacheSys.hpp"
 #include "Core.hpp"
 #include "Cache.hpp"
+#include "ParallelSim.hpp"
+#include <algorithm>
 
 void CacheSys::add_cache_to_hier(std::shared_ptr<Cache> cache)
 {
@@ -68,13 +70,45 @@ void CacheSys::add_cachesys(std::shared_ptr<CacheSys> cs)
     m_other_cache_sys.push_back(cs);
 }
 
+void CacheSys::set_topology(const std::vector<std::shared_ptr<CacheSys>> &data_hiers, const std::vector<std::shared_ptr<CacheSys>> &tlb_hiers)
+{
+    assert(data_hiers.size() == tlb_hiers.size());
+
+    m_data_hiers.clear();
+    m_tlb_hiers.clear();
+
+    for(int i = 0; i < data_hiers.size(); i++)
+    {
+        assert(data_hiers[i]->get_core_id() == i && tlb_hiers[i]->get_core_id() == i);
+        m_data_hiers.push_back(data_hiers[i].get());
+        m_tlb_hiers.push_back(tlb_hiers[i].get());
+    }
+}
+
+CacheSys* CacheSys::get_data_hier(unsigned int core_id)
+{
+    assert(core_id < m_data_hiers.size());
+    return m_data_hiers[core_id];
+}
+
+CacheSys* CacheSys::get_tlb_hier(unsigned int core_id)
+{
+    assert(core_id < m_tlb_hiers.size());
+    return m_tlb_hiers[core_id];
+}
+
+unsigned int CacheSys::get_num_cores()
+{
+    return (unsigned int) m_data_hiers.size();
+}
+
 void CacheSys::tick()
 {
     //First, handle coherence actions in the current clock cycle
     bool needs_state_correction = false;
     bool state_corrected = false;
-    for(std::map<std::shared_ptr<Request>, CoherenceAction>::iterator it = m_coh_act_list.begin();
-        it != m_coh_act_list.end(); )
+    for(std::vector<std::pair<std::shared_ptr<Request>, CoherenceAction>>::iterator it = m_coh_act_list.begin();
+        it != m_coh_act_list.end(); it++)
     {
         int limit = (int) (m_is_translation_hier ? m_caches.size() - 2 : m_caches.size() - 1);
         for(int i = 0; i < limit; i++)
@@ -87,44 +121,41 @@ void CacheSys::tick()
                 state_corrected = true;
             }
         }
-        
-        it = m_coh_act_list.erase(it);
     }
     
-    assert(m_coh_act_list.empty());
+    m_coh_act_list.clear();
     
     //Retire elements from hit list
-    for(std::map<uint64_t, std::shared_ptr<Request>>::iterator it = m_hit_list.begin();
-        it != m_hit_list.end();
-        )
-    {
-        if(m_clk >= it->first)
-        {
-            it->second->m_callback(it->second);
-            it = m_hit_list.erase(it);
-        }
-        else
-        {
-            it++;
-        }
-    }
+    m_hit_list.retire(m_clk);
     
     //Then retire elements from wait list
-    for(std::map<uint64_t, std::shared_ptr<Request>>::iterator it = m_wait_list.begin();
-        it != m_wait_list.end();
-        )
+    m_wait_list.retire(m_clk);
+    m_clk++;
+}
+
+uint64_t CacheSys::cycles_to_next_event()
+{
+    if(!m_coh_act_list.empty())
     {
-        if(m_clk >= it->first)
-        {
-            it->second->m_callback(it->second);
-            it = m_wait_list.erase(it);
-        }
-        else
-        {
-            it++;
-        }
+        return 0;
     }
-    m_clk++;
+
+    uint64_t deadline = std::min(m_hit_list.next_deadline(), m_wait_list.next_deadline());
+    if(deadline == UINT64_MAX)
+    {
+        return UINT64_MAX;
+    }
+
+    return (deadline > m_clk) ? (deadline - m_clk) : 0;
+}
+
+void CacheSys::skip_cycles(uint64_t num_cycles)
+{
+    m_clk += num_cycles;
+
+    //Nothing is due in the skipped cycles, this only turns the queues to the current cycle
+    m_hit_list.retire(m_clk - 1);
+    m_wait_list.retire(m_clk - 1);
 }
 
 bool CacheSys::is_last_level(unsigned int cache_level)
@@ -211,7 +242,23 @@ void CacheSys::clflush(uint64_t addr, uint64_t tid, bool is_translation)
 {
     for(int i = 0; i < m_caches.size(); i++)
     {
-        m_caches[i]->invalidate(addr, tid, is_translation);
+        invalidate(m_caches[i], addr, tid, is_translation);
+    }
+}
+
+void CacheSys::invalidate(std::shared_ptr<Cache> &cache, uint64_t addr, uint64_t tid, bool is_translation)
+{
+    //Shared levels invalidate the caches of every core above them
+    if(ParallelSim::is_deferring() && cache->get_core_id() == -1)
+    {
+        std::shared_ptr<Cache> c = cache;
+        ParallelSim::defer([c, addr, tid, is_translation]() {
+            c->invalidate(addr, tid, is_translation);
+        });
+    }
+    else
+    {
+        cache->invalidate(addr, tid, is_translation);
     }
 }
 
@@ -223,7 +270,7 @@ void CacheSys::tlb_invalidate(uint64_t addr, uint64_t tid, bool is_large)
 
     for(int i = start; i < m_caches.size(); i += 2)
     {
-        m_caches[i]->invalidate(addr, tid, true);
+        invalidate(m_caches[i], addr, tid, true);
 
         //If penultimate level, remove entry from presence map 
         if(is_penultimate_level(m_caches[i]->get_level()))
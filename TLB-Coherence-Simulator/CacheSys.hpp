@@ -14,6 +14,7 @@
 #include <assert.h>
 #include <map>
 #include "Request.hpp"
+#include "RequestQueue.hpp"
 
 class Cache;
 class Core;
@@ -34,18 +35,22 @@ public:
     std::vector<std::shared_ptr<Cache>> m_caches;
     
     //This is where requests wait until they are served a memory access
-    std::map<uint64_t, std::shared_ptr<Request>> m_wait_list;
+    RequestQueue m_wait_list;
     
     //This is where requests wait until they are served by a hit
-    std::map<uint64_t, std::shared_ptr<Request>> m_hit_list;
+    RequestQueue m_hit_list;
     
-    //This is where coherence actions wait until they are served
-    std::map<std::shared_ptr<Request>, CoherenceAction> m_coh_act_list;
+    //This is where coherence actions wait until they are served, in the order they were queued
+    std::vector<std::pair<std::shared_ptr<Request>, CoherenceAction>> m_coh_act_list;
     
     uint64_t m_memory_latency;
     uint64_t m_cache_to_cache_latency;
     
     std::vector<std::shared_ptr<CacheSys>> m_other_cache_sys;
+
+    //Data and TLB hierarchies of every core by core id, this one included
+    std::vector<CacheSys*> m_data_hiers;
+    std::vector<CacheSys*> m_tlb_hiers;
     
     int m_core_id;
     
@@ -64,10 +69,24 @@ public:
     void add_cache_to_hier(std::shared_ptr<Cache> c);
     
     void add_cachesys(std::shared_ptr<CacheSys> cs);
+
+    void set_topology(const std::vector<std::shared_ptr<CacheSys>> &data_hiers, const std::vector<std::shared_ptr<CacheSys>> &tlb_hiers);
+
+    CacheSys* get_data_hier(unsigned int core_id);
+
+    CacheSys* get_tlb_hier(unsigned int core_id);
+
+    unsigned int get_num_cores();
     
     void set_core(std::shared_ptr<Core>& coreptr);
     
     void tick();
+
+    //Ticks from now until one serves a request or a coherence action, UINT64_MAX if nothing is queued
+    uint64_t cycles_to_next_event();
+
+    //Stands for num_cycles ticks that serve nothing
+    void skip_cycles(uint64_t num_cycles);
     
     bool is_last_level(unsigned int cache_level);
     
@@ -85,6 +104,9 @@ public:
 
     void clflush(const uint64_t addr, uint64_t tid, bool is_translation);
 
+    //Invalidates addr in cache, left to the serial phase for a shared level, see ParallelSim
+    void invalidate(std::shared_ptr<Cache> &cache, uint64_t addr, uint64_t tid, bool is_translation);
+
     void tlb_invalidate(uint64_t addr, uint64_t tid, bool is_large);
 
     bool is_done();
@@ -8,248 +8,59 @@
 
 #include "Coherence.hpp"
 
-CoherenceState CoherenceProtocol::getCoherenceState()
-{
-    return coh_state;
-}
+constexpr CoherenceTable CoherenceTables::moesi;
+constexpr CoherenceTable CoherenceTables::mesi;
+constexpr CoherenceTable CoherenceTables::msi;
 
-void CoherenceProtocol::forceCoherenceState(CoherenceState cs)
+const CoherenceTable& coherenceTable(CoherenceProtocolEnum prot)
 {
-    coh_state = cs;
+    switch(prot)
+    {
+        case MSI_COHERENCE:
+            return CoherenceTables::msi;
+        case MESI_COHERENCE:
+            return CoherenceTables::mesi;
+        case NO_COHERENCE:
+        case MOESI_COHERENCE:
+        default:
+            return CoherenceTables::moesi;
+    }
 }
 
-void CoherenceProtocol::set_level(unsigned int cache_level)
+bool parseCoherenceProtocol(const std::string& str, CoherenceProtocolEnum &prot)
 {
-    m_cache_level = cache_level;
-}
+    if(str == "msi")
+    {
+        prot = MSI_COHERENCE;
+    }
+    else if(str == "mesi")
+    {
+        prot = MESI_COHERENCE;
+    }
+    else if(str == "moesi")
+    {
+        prot = MOESI_COHERENCE;
+    }
+    else
+    {
+        return false;
+    }
 
-unsigned int CoherenceProtocol::get_level()
-{
-    return m_cache_level;
+    return true;
 }
 
-
-CoherenceAction MOESIProtocol::setNextCoherenceState(kind txn_kind, CoherenceState propagate_coh_state)
+std::string coherenceProtocolName(CoherenceProtocolEnum prot)
 {
-    //TODO: Need to handle writebacks here as well
-    CoherenceAction coh_action = NONE;
-    CoherenceState next_coh_state;
-    switch(coh_state)
+    switch(prot)
     {
-        case MODIFIED:
-            if(txn_kind == DIRECTORY_DATA_READ)
-            {
-                next_coh_state = OWNER;
-                coh_action =  MEMORY_DATA_WRITEBACK;
-            }
-            else if (txn_kind == DIRECTORY_TRANSLATION_READ)
-            {
-                next_coh_state = OWNER;
-                coh_action = MEMORY_TRANSLATION_WRITEBACK;
-            }
-            else if(txn_kind == DIRECTORY_DATA_WRITE)
-            {
-                next_coh_state = INVALID;
-                coh_action =  MEMORY_DATA_WRITEBACK;
-            }
-            else if(txn_kind == DIRECTORY_TRANSLATION_WRITE)
-            {
-                next_coh_state = INVALID;
-                coh_action = MEMORY_TRANSLATION_WRITEBACK;
-            }
-            else
-            {
-                next_coh_state = coh_state;
-                coh_action = NONE;
-            }
-            break;
-        case OWNER:
-            if(txn_kind == DIRECTORY_DATA_WRITE)
-            {
-                //Owner responsible for doing writeback of dirty data
-                next_coh_state = INVALID;
-                coh_action =  MEMORY_DATA_WRITEBACK;
-            }
-            else if(txn_kind == DIRECTORY_TRANSLATION_WRITE)
-            {
-                next_coh_state = INVALID;
-                coh_action = MEMORY_TRANSLATION_WRITEBACK;
-            }
-            else if (txn_kind == DATA_WRITE && m_cache_level == 1)
-            {
-                next_coh_state = MODIFIED;
-                coh_action = BROADCAST_DATA_WRITE;
-            }
-            else if (txn_kind == DATA_WRITE)
-            {
-                next_coh_state = EXCLUSIVE;
-                coh_action = NONE;
-            }
-            else if (txn_kind == DATA_WRITEBACK || txn_kind == TRANSLATION_WRITEBACK)
-            {
-                next_coh_state = propagate_coh_state;
-                coh_action = NONE;
-            }
-            else if(txn_kind == TRANSLATION_WRITE && m_cache_level == 1)
-            {
-                next_coh_state = MODIFIED;
-                coh_action = BROADCAST_TRANSLATION_WRITE;
-            }
-            else if(txn_kind == TRANSLATION_WRITE)
-            {
-                next_coh_state = EXCLUSIVE;
-                coh_action = NONE;
-            }
-            else
-            {
-                //Ideally, for txn_kind == DIRECTORY_DATA_READ, we will have to provide data with cache to cache transfer here
-                //We do not support cache to cache transfers.
-                //So, skip
-                next_coh_state = coh_state;
-                coh_action = NONE;
-            }
-            break;
-        case EXCLUSIVE:
-            if(txn_kind == DIRECTORY_DATA_READ)
-            {
-                next_coh_state = SHARED;
-                coh_action = NONE;
-            }
-            else if (txn_kind == DIRECTORY_TRANSLATION_READ)
-            {
-                next_coh_state = SHARED;
-                coh_action = NONE;
-            }
-            else if(txn_kind == DIRECTORY_DATA_WRITE)
-            {
-                next_coh_state = INVALID;
-                coh_action = NONE;
-            }
-            else if(txn_kind == DIRECTORY_TRANSLATION_WRITE)
-            {
-                next_coh_state = INVALID;
-                coh_action = NONE;
-            }
-            else if(txn_kind == DATA_WRITE && m_cache_level == 1)
-            {
-                next_coh_state = MODIFIED;
-                coh_action = NONE;
-            }
-            else if (txn_kind == DATA_WRITE)
-            {
-                next_coh_state = EXCLUSIVE;
-                coh_action = NONE;
-            }
-            else if(txn_kind == DATA_WRITEBACK || txn_kind == TRANSLATION_WRITEBACK)
-            {
-                next_coh_state = propagate_coh_state;
-                coh_action = NONE;
-            }
-            else if(txn_kind == TRANSLATION_WRITE && m_cache_level == 1)
-            {
-                next_coh_state = MODIFIED;
-                coh_action = NONE;
-            }
-            else if(txn_kind == TRANSLATION_WRITE)
-            {
-                next_coh_state = EXCLUSIVE;
-                coh_action = NONE;
-            }
-            else
-            {
-                next_coh_state = coh_state;
-                coh_action = NONE;
-            }
-            break;
-        case SHARED:
-            if (txn_kind == DIRECTORY_DATA_WRITE)
-            {
-                next_coh_state = INVALID;
-                coh_action = NONE;
-            }
-            else if (txn_kind == DIRECTORY_TRANSLATION_WRITE)
-            {
-                next_coh_state = INVALID;
-                coh_action = NONE;
-            }
-            else if (txn_kind == DATA_WRITE && m_cache_level == 1)
-            {
-                next_coh_state = MODIFIED;
-                coh_action = BROADCAST_DATA_WRITE;
-            }
-            else if (txn_kind == DATA_WRITE)
-            {
-                next_coh_state = EXCLUSIVE;
-                coh_action = NONE;
-            }
-            else if (txn_kind == DATA_WRITEBACK || txn_kind == TRANSLATION_WRITEBACK)
-            {
-                next_coh_state = propagate_coh_state;
-                coh_action = NONE;
-            }
-            else if (txn_kind == TRANSLATION_WRITE && m_cache_level == 1)
-            {
-                next_coh_state = MODIFIED;
-                coh_action = BROADCAST_TRANSLATION_WRITE;
-            }
-            else if(txn_kind == TRANSLATION_WRITE)
-            {
-                next_coh_state = EXCLUSIVE;
-                coh_action = NONE;
-            }
-            else
-            {
-                next_coh_state = coh_state;
-                coh_action = NONE;
-            }
-            break;
-        case INVALID:
-            if(txn_kind == DATA_READ)
-            {
-                next_coh_state = EXCLUSIVE;
-                coh_action = BROADCAST_DATA_READ;
-            }
-            else if (txn_kind == TRANSLATION_READ)
-            {
-                next_coh_state = EXCLUSIVE;
-                coh_action = BROADCAST_TRANSLATION_READ;
-            }
-            else if (txn_kind == DATA_WRITE && m_cache_level == 1)
-            {
-                next_coh_state = MODIFIED;
-                coh_action = BROADCAST_DATA_WRITE;
-            }
-            else if (txn_kind == DATA_WRITE)
-            {
-                next_coh_state = EXCLUSIVE;
-                coh_action = NONE;
-            }
-            else if (txn_kind == DATA_WRITEBACK || txn_kind == TRANSLATION_WRITEBACK)
-            {
-                next_coh_state = propagate_coh_state;
-                coh_action = NONE;
-            }
-            else if(txn_kind == TRANSLATION_WRITE && m_cache_level == 1)
-            {
-                next_coh_state = MODIFIED;
-                coh_action = BROADCAST_TRANSLATION_WRITE;
-            }
-            else if(txn_kind == TRANSLATION_WRITE)
-            {
-                next_coh_state = EXCLUSIVE;
-                coh_action = NONE;
-            }
-            else
-            {
-                next_coh_state = coh_state;
-                coh_action = NONE;
-            }
-            break;
+        case MSI_COHERENCE:
+            return "msi";
+        case MESI_COHERENCE:
+            return "mesi";
+        case NO_COHERENCE:
+            return "none";
+        case MOESI_COHERENCE:
         default:
-            break;
+            return "moesi";
     }
-    
-    coh_state = next_coh_state;
-    
-    return coh_action;
 }
@@ -8,53 +8,271 @@
 
 #ifndef Coherence_hpp
 #define Coherence_hpp
+#include <cstdint>
+#include <string>
 #include "utils.hpp"
 
 enum CoherenceProtocolEnum {
     NO_COHERENCE,
-    MSI_COHERENCE, //Placeholder, Not implemented
-    MESI_COHERENCE, //Placeholder, Not implemented
+    MSI_COHERENCE,
+    MESI_COHERENCE,
     MOESI_COHERENCE,
 };
 
-class CoherenceProtocol {
-protected:
-    CoherenceState coh_state = INVALID;
-    unsigned int m_cache_level = 0;
+const unsigned int NUM_COHERENCE_STATES = INVALID + 1;
+const unsigned int NUM_TXN_KINDS = DIRECTORY_TRANSLATION_READ + 1;
+
+//Next state of writebacks into a lower level: the state the line had in the upper level
+const uint8_t PROPAGATED = NUM_COHERENCE_STATES;
+
+class CoherenceTransition {
 public:
-    virtual CoherenceAction setNextCoherenceState(kind txn_kind, CoherenceState propagate_coh_state = INVALID) = 0;
-    CoherenceState getCoherenceState();
-    void forceCoherenceState(CoherenceState coh_state);
-    void set_level(unsigned int cache_level);
-    unsigned int get_level();
-    
-    friend std::ostream& operator << (std::ostream& out, CoherenceProtocol &c)
-    {
-        switch(c.coh_state)
-        {
-            case MODIFIED:
-                out << "|M|";
-                break;
-            case OWNER:
-                out << "|O|";
-                break;
-            case EXCLUSIVE:
-                out << "|E|";
-                break;
-            case SHARED:
-                out << "|S|";
-                break;
-            case INVALID:
-                out << "|I|";
-                break;
-        }
-        return out;
-    }
+    uint8_t next_state;
+    uint8_t action;
 };
 
-class MOESIProtocol : public CoherenceProtocol {
+//Protocol transition tables, indexed by [current state][txn kind][is L1]
+typedef CoherenceTransition CoherenceTable[NUM_COHERENCE_STATES][NUM_TXN_KINDS][2];
+
+class CoherenceTables {
 public:
-    virtual CoherenceAction setNextCoherenceState(kind txn_kind, CoherenceState propagate_coh_state = INVALID) final override;
+    //Columns are a lower level and L1, only L1 broadcasts writes and holds lines modified
+    static constexpr CoherenceTable moesi = {
+        //MODIFIED
+        {
+            {{MODIFIED, NONE}, {MODIFIED, NONE}}, //INVALID_TXN_KIND
+            {{MODIFIED, NONE}, {MODIFIED, NONE}}, //DATA_READ
+            {{MODIFIED, NONE}, {MODIFIED, NONE}}, //DATA_WRITE
+            {{MODIFIED, NONE}, {MODIFIED, NONE}}, //TRANSLATION_READ
+            {{MODIFIED, NONE}, {MODIFIED, NONE}}, //TRANSLATION_WRITE
+            {{MODIFIED, NONE}, {MODIFIED, NONE}}, //DATA_WRITEBACK
+            {{MODIFIED, NONE}, {MODIFIED, NONE}}, //TRANSLATION_WRITEBACK
+            {{INVALID, MEMORY_DATA_WRITEBACK}, {INVALID, MEMORY_DATA_WRITEBACK}}, //DIRECTORY_DATA_WRITE
+            {{OWNER, MEMORY_DATA_WRITEBACK}, {OWNER, MEMORY_DATA_WRITEBACK}}, //DIRECTORY_DATA_READ
+            {{INVALID, MEMORY_TRANSLATION_WRITEBACK}, {INVALID, MEMORY_TRANSLATION_WRITEBACK}}, //DIRECTORY_TRANSLATION_WRITE
+            {{OWNER, MEMORY_TRANSLATION_WRITEBACK}, {OWNER, MEMORY_TRANSLATION_WRITEBACK}} //DIRECTORY_TRANSLATION_READ
+        },
+        //OWNER
+        {
+            {{OWNER, NONE}, {OWNER, NONE}}, //INVALID_TXN_KIND
+            {{OWNER, NONE}, {OWNER, NONE}}, //DATA_READ
+            {{EXCLUSIVE, NONE}, {MODIFIED, BROADCAST_DATA_WRITE}}, //DATA_WRITE
+            {{OWNER, NONE}, {OWNER, NONE}}, //TRANSLATION_READ
+            {{EXCLUSIVE, NONE}, {MODIFIED, BROADCAST_TRANSLATION_WRITE}}, //TRANSLATION_WRITE
+            {{PROPAGATED, NONE}, {PROPAGATED, NONE}}, //DATA_WRITEBACK
+            {{PROPAGATED, NONE}, {PROPAGATED, NONE}}, //TRANSLATION_WRITEBACK
+            {{INVALID, MEMORY_DATA_WRITEBACK}, {INVALID, MEMORY_DATA_WRITEBACK}}, //DIRECTORY_DATA_WRITE
+            {{OWNER, NONE}, {OWNER, NONE}}, //DIRECTORY_DATA_READ
+            {{INVALID, MEMORY_TRANSLATION_WRITEBACK}, {INVALID, MEMORY_TRANSLATION_WRITEBACK}}, //DIRECTORY_TRANSLATION_WRITE
+            {{OWNER, NONE}, {OWNER, NONE}} //DIRECTORY_TRANSLATION_READ
+        },
+        //EXCLUSIVE
+        {
+            {{EXCLUSIVE, NONE}, {EXCLUSIVE, NONE}}, //INVALID_TXN_KIND
+            {{EXCLUSIVE, NONE}, {EXCLUSIVE, NONE}}, //DATA_READ
+            {{EXCLUSIVE, NONE}, {MODIFIED, NONE}}, //DATA_WRITE
+            {{EXCLUSIVE, NONE}, {EXCLUSIVE, NONE}}, //TRANSLATION_READ
+            {{EXCLUSIVE, NONE}, {MODIFIED, NONE}}, //TRANSLATION_WRITE
+            {{PROPAGATED, NONE}, {PROPAGATED, NONE}}, //DATA_WRITEBACK
+            {{PROPAGATED, NONE}, {PROPAGATED, NONE}}, //TRANSLATION_WRITEBACK
+            {{INVALID, NONE}, {INVALID, NONE}}, //DIRECTORY_DATA_WRITE
+            {{SHARED, NONE}, {SHARED, NONE}}, //DIRECTORY_DATA_READ
+            {{INVALID, NONE}, {INVALID, NONE}}, //DIRECTORY_TRANSLATION_WRITE
+            {{SHARED, NONE}, {SHARED, NONE}} //DIRECTORY_TRANSLATION_READ
+        },
+        //SHARED
+        {
+            {{SHARED, NONE}, {SHARED, NONE}}, //INVALID_TXN_KIND
+            {{SHARED, NONE}, {SHARED, NONE}}, //DATA_READ
+            {{EXCLUSIVE, NONE}, {MODIFIED, BROADCAST_DATA_WRITE}}, //DATA_WRITE
+            {{SHARED, NONE}, {SHARED, NONE}}, //TRANSLATION_READ
+            {{EXCLUSIVE, NONE}, {MODIFIED, BROADCAST_TRANSLATION_WRITE}}, //TRANSLATION_WRITE
+            {{PROPAGATED, NONE}, {PROPAGATED, NONE}}, //DATA_WRITEBACK
+            {{PROPAGATED, NONE}, {PROPAGATED, NONE}}, //TRANSLATION_WRITEBACK
+            {{INVALID, NONE}, {INVALID, NONE}}, //DIRECTORY_DATA_WRITE
+            {{SHARED, NONE}, {SHARED, NONE}}, //DIRECTORY_DATA_READ
+            {{INVALID, NONE}, {INVALID, NONE}}, //DIRECTORY_TRANSLATION_WRITE
+            {{SHARED, NONE}, {SHARED, NONE}} //DIRECTORY_TRANSLATION_READ
+        },
+        //INVALID
+        {
+            {{INVALID, NONE}, {INVALID, NONE}}, //INVALID_TXN_KIND
+            {{EXCLUSIVE, BROADCAST_DATA_READ}, {EXCLUSIVE, BROADCAST_DATA_READ}}, //DATA_READ
+            {{EXCLUSIVE, NONE}, {MODIFIED, BROADCAST_DATA_WRITE}}, //DATA_WRITE
+            {{EXCLUSIVE, BROADCAST_TRANSLATION_READ}, {EXCLUSIVE, BROADCAST_TRANSLATION_READ}}, //TRANSLATION_READ
+            {{EXCLUSIVE, NONE}, {MODIFIED, BROADCAST_TRANSLATION_WRITE}}, //TRANSLATION_WRITE
+            {{PROPAGATED, NONE}, {PROPAGATED, NONE}}, //DATA_WRITEBACK
+            {{PROPAGATED, NONE}, {PROPAGATED, NONE}}, //TRANSLATION_WRITEBACK
+            {{INVALID, NONE}, {INVALID, NONE}}, //DIRECTORY_DATA_WRITE
+            {{INVALID, NONE}, {INVALID, NONE}}, //DIRECTORY_DATA_READ
+            {{INVALID, NONE}, {INVALID, NONE}}, //DIRECTORY_TRANSLATION_WRITE
+            {{INVALID, NONE}, {INVALID, NONE}} //DIRECTORY_TRANSLATION_READ
+        }
+    };
+
+    //MOESI without OWNER: a modified line read by another core is written back and shared
+    static constexpr CoherenceTable mesi = {
+        //MODIFIED
+        {
+            {{MODIFIED, NONE}, {MODIFIED, NONE}}, //INVALID_TXN_KIND
+            {{MODIFIED, NONE}, {MODIFIED, NONE}}, //DATA_READ
+            {{MODIFIED, NONE}, {MODIFIED, NONE}}, //DATA_WRITE
+            {{MODIFIED, NONE}, {MODIFIED, NONE}}, //TRANSLATION_READ
+            {{MODIFIED, NONE}, {MODIFIED, NONE}}, //TRANSLATION_WRITE
+            {{MODIFIED, NONE}, {MODIFIED, NONE}}, //DATA_WRITEBACK
+            {{MODIFIED, NONE}, {MODIFIED, NONE}}, //TRANSLATION_WRITEBACK
+            {{INVALID, MEMORY_DATA_WRITEBACK}, {INVALID, MEMORY_DATA_WRITEBACK}}, //DIRECTORY_DATA_WRITE
+            {{SHARED, MEMORY_DATA_WRITEBACK}, {SHARED, MEMORY_DATA_WRITEBACK}}, //DIRECTORY_DATA_READ
+            {{INVALID, MEMORY_TRANSLATION_WRITEBACK}, {INVALID, MEMORY_TRANSLATION_WRITEBACK}}, //DIRECTORY_TRANSLATION_WRITE
+            {{SHARED, MEMORY_TRANSLATION_WRITEBACK}, {SHARED, MEMORY_TRANSLATION_WRITEBACK}} //DIRECTORY_TRANSLATION_READ
+        },
+        //OWNER
+        {
+            {{SHARED, NONE}, {SHARED, NONE}}, //INVALID_TXN_KIND
+            {{SHARED, NONE}, {SHARED, NONE}}, //DATA_READ
+            {{EXCLUSIVE, NONE}, {MODIFIED, BROADCAST_DATA_WRITE}}, //DATA_WRITE
+            {{SHARED, NONE}, {SHARED, NONE}}, //TRANSLATION_READ
+            {{EXCLUSIVE, NONE}, {MODIFIED, BROADCAST_TRANSLATION_WRITE}}, //TRANSLATION_WRITE
+            {{PROPAGATED, NONE}, {PROPAGATED, NONE}}, //DATA_WRITEBACK
+            {{PROPAGATED, NONE}, {PROPAGATED, NONE}}, //TRANSLATION_WRITEBACK
+            {{INVALID, NONE}, {INVALID, NONE}}, //DIRECTORY_DATA_WRITE
+            {{SHARED, NONE}, {SHARED, NONE}}, //DIRECTORY_DATA_READ
+            {{INVALID, NONE}, {INVALID, NONE}}, //DIRECTORY_TRANSLATION_WRITE
+            {{SHARED, NONE}, {SHARED, NONE}} //DIRECTORY_TRANSLATION_READ
+        },
+        //EXCLUSIVE
+        {
+            {{EXCLUSIVE, NONE}, {EXCLUSIVE, NONE}}, //INVALID_TXN_KIND
+            {{EXCLUSIVE, NONE}, {EXCLUSIVE, NONE}}, //DATA_READ
+            {{EXCLUSIVE, NONE}, {MODIFIED, NONE}}, //DATA_WRITE
+            {{EXCLUSIVE, NONE}, {EXCLUSIVE, NONE}}, //TRANSLATION_READ
+            {{EXCLUSIVE, NONE}, {MODIFIED, NONE}}, //TRANSLATION_WRITE
+            {{PROPAGATED, NONE}, {PROPAGATED, NONE}}, //DATA_WRITEBACK
+            {{PROPAGATED, NONE}, {PROPAGATED, NONE}}, //TRANSLATION_WRITEBACK
+            {{INVALID, NONE}, {INVALID, NONE}}, //DIRECTORY_DATA_WRITE
+            {{SHARED, NONE}, {SHARED, NONE}}, //DIRECTORY_DATA_READ
+            {{INVALID, NONE}, {INVALID, NONE}}, //DIRECTORY_TRANSLATION_WRITE
+            {{SHARED, NONE}, {SHARED, NONE}} //DIRECTORY_TRANSLATION_READ
+        },
+        //SHARED
+        {
+            {{SHARED, NONE}, {SHARED, NONE}}, //INVALID_TXN_KIND
+            {{SHARED, NONE}, {SHARED, NONE}}, //DATA_READ
+            {{EXCLUSIVE, NONE}, {MODIFIED, BROADCAST_DATA_WRITE}}, //DATA_WRITE
+            {{SHARED, NONE}, {SHARED, NONE}}, //TRANSLATION_READ
+            {{EXCLUSIVE, NONE}, {MODIFIED, BROADCAST_TRANSLATION_WRITE}}, //TRANSLATION_WRITE
+            {{PROPAGATED, NONE}, {PROPAGATED, NONE}}, //DATA_WRITEBACK
+            {{PROPAGATED, NONE}, {PROPAGATED, NONE}}, //TRANSLATION_WRITEBACK
+            {{INVALID, NONE}, {INVALID, NONE}}, //DIRECTORY_DATA_WRITE
+            {{SHARED, NONE}, {SHARED, NONE}}, //DIRECTORY_DATA_READ
+            {{INVALID, NONE}, {INVALID, NONE}}, //DIRECTORY_TRANSLATION_WRITE
+            {{SHARED, NONE}, {SHARED, NONE}} //DIRECTORY_TRANSLATION_READ
+        },
+        //INVALID
+        {
+            {{INVALID, NONE}, {INVALID, NONE}}, //INVALID_TXN_KIND
+            {{EXCLUSIVE, BROADCAST_DATA_READ}, {EXCLUSIVE, BROADCAST_DATA_READ}}, //DATA_READ
+            {{EXCLUSIVE, NONE}, {MODIFIED, BROADCAST_DATA_WRITE}}, //DATA_WRITE
+            {{EXCLUSIVE, BROADCAST_TRANSLATION_READ}, {EXCLUSIVE, BROADCAST_TRANSLATION_READ}}, //TRANSLATION_READ
+            {{EXCLUSIVE, NONE}, {MODIFIED, BROADCAST_TRANSLATION_WRITE}}, //TRANSLATION_WRITE
+            {{PROPAGATED, NONE}, {PROPAGATED, NONE}}, //DATA_WRITEBACK
+            {{PROPAGATED, NONE}, {PROPAGATED, NONE}}, //TRANSLATION_WRITEBACK
+            {{INVALID, NONE}, {INVALID, NONE}}, //DIRECTORY_DATA_WRITE
+            {{INVALID, NONE}, {INVALID, NONE}}, //DIRECTORY_DATA_READ
+            {{INVALID, NONE}, {INVALID, NONE}}, //DIRECTORY_TRANSLATION_WRITE
+            {{INVALID, NONE}, {INVALID, NONE}} //DIRECTORY_TRANSLATION_READ
+        }
+    };
+
+    //MESI without EXCLUSIVE: reads fill lines shared, lower levels keep written lines shared under the modified L1 copy
+    static constexpr CoherenceTable msi = {
+        //MODIFIED
+        {
+            {{MODIFIED, NONE}, {MODIFIED, NONE}}, //INVALID_TXN_KIND
+            {{MODIFIED, NONE}, {MODIFIED, NONE}}, //DATA_READ
+            {{MODIFIED, NONE}, {MODIFIED, NONE}}, //DATA_WRITE
+            {{MODIFIED, NONE}, {MODIFIED, NONE}}, //TRANSLATION_READ
+            {{MODIFIED, NONE}, {MODIFIED, NONE}}, //TRANSLATION_WRITE
+            {{MODIFIED, NONE}, {MODIFIED, NONE}}, //DATA_WRITEBACK
+            {{MODIFIED, NONE}, {MODIFIED, NONE}}, //TRANSLATION_WRITEBACK
+            {{INVALID, MEMORY_DATA_WRITEBACK}, {INVALID, MEMORY_DATA_WRITEBACK}}, //DIRECTORY_DATA_WRITE
+            {{SHARED, MEMORY_DATA_WRITEBACK}, {SHARED, MEMORY_DATA_WRITEBACK}}, //DIRECTORY_DATA_READ
+            {{INVALID, MEMORY_TRANSLATION_WRITEBACK}, {INVALID, MEMORY_TRANSLATION_WRITEBACK}}, //DIRECTORY_TRANSLATION_WRITE
+            {{SHARED, MEMORY_TRANSLATION_WRITEBACK}, {SHARED, MEMORY_TRANSLATION_WRITEBACK}} //DIRECTORY_TRANSLATION_READ
+        },
+        //OWNER
+        {
+            {{SHARED, NONE}, {SHARED, NONE}}, //INVALID_TXN_KIND
+            {{SHARED, NONE}, {SHARED, NONE}}, //DATA_READ
+            {{SHARED, NONE}, {MODIFIED, BROADCAST_DATA_WRITE}}, //DATA_WRITE
+            {{SHARED, NONE}, {SHARED, NONE}}, //TRANSLATION_READ
+            {{SHARED, NONE}, {MODIFIED, BROADCAST_TRANSLATION_WRITE}}, //TRANSLATION_WRITE
+            {{PROPAGATED, NONE}, {PROPAGATED, NONE}}, //DATA_WRITEBACK
+            {{PROPAGATED, NONE}, {PROPAGATED, NONE}}, //TRANSLATION_WRITEBACK
+            {{INVALID, NONE}, {INVALID, NONE}}, //DIRECTORY_DATA_WRITE
+            {{SHARED, NONE}, {SHARED, NONE}}, //DIRECTORY_DATA_READ
+            {{INVALID, NONE}, {INVALID, NONE}}, //DIRECTORY_TRANSLATION_WRITE
+            {{SHARED, NONE}, {SHARED, NONE}} //DIRECTORY_TRANSLATION_READ
+        },
+        //EXCLUSIVE
+        {
+            {{SHARED, NONE}, {SHARED, NONE}}, //INVALID_TXN_KIND
+            {{SHARED, NONE}, {SHARED, NONE}}, //DATA_READ
+            {{SHARED, NONE}, {MODIFIED, BROADCAST_DATA_WRITE}}, //DATA_WRITE
+            {{SHARED, NONE}, {SHARED, NONE}}, //TRANSLATION_READ
+            {{SHARED, NONE}, {MODIFIED, BROADCAST_TRANSLATION_WRITE}}, //TRANSLATION_WRITE
+            {{PROPAGATED, NONE}, {PROPAGATED, NONE}}, //DATA_WRITEBACK
+            {{PROPAGATED, NONE}, {PROPAGATED, NONE}}, //TRANSLATION_WRITEBACK
+            {{INVALID, NONE}, {INVALID, NONE}}, //DIRECTORY_DATA_WRITE
+            {{SHARED, NONE}, {SHARED, NONE}}, //DIRECTORY_DATA_READ
+            {{INVALID, NONE}, {INVALID, NONE}}, //DIRECTORY_TRANSLATION_WRITE
+            {{SHARED, NONE}, {SHARED, NONE}} //DIRECTORY_TRANSLATION_READ
+        },
+        //SHARED
+        {
+            {{SHARED, NONE}, {SHARED, NONE}}, //INVALID_TXN_KIND
+            {{SHARED, NONE}, {SHARED, NONE}}, //DATA_READ
+            {{SHARED, NONE}, {MODIFIED, BROADCAST_DATA_WRITE}}, //DATA_WRITE
+            {{SHARED, NONE}, {SHARED, NONE}}, //TRANSLATION_READ
+            {{SHARED, NONE}, {MODIFIED, BROADCAST_TRANSLATION_WRITE}}, //TRANSLATION_WRITE
+            {{PROPAGATED, NONE}, {PROPAGATED, NONE}}, //DATA_WRITEBACK
+            {{PROPAGATED, NONE}, {PROPAGATED, NONE}}, //TRANSLATION_WRITEBACK
+            {{INVALID, NONE}, {INVALID, NONE}}, //DIRECTORY_DATA_WRITE
+            {{SHARED, NONE}, {SHARED, NONE}}, //DIRECTORY_DATA_READ
+            {{INVALID, NONE}, {INVALID, NONE}}, //DIRECTORY_TRANSLATION_WRITE
+            {{SHARED, NONE}, {SHARED, NONE}} //DIRECTORY_TRANSLATION_READ
+        },
+        //INVALID
+        {
+            {{INVALID, NONE}, {INVALID, NONE}}, //INVALID_TXN_KIND
+            {{SHARED, BROADCAST_DATA_READ}, {SHARED, BROADCAST_DATA_READ}}, //DATA_READ
+            {{SHARED, NONE}, {MODIFIED, BROADCAST_DATA_WRITE}}, //DATA_WRITE
+            {{SHARED, BROADCAST_TRANSLATION_READ}, {SHARED, BROADCAST_TRANSLATION_READ}}, //TRANSLATION_READ
+            {{SHARED, NONE}, {MODIFIED, BROADCAST_TRANSLATION_WRITE}}, //TRANSLATION_WRITE
+            {{PROPAGATED, NONE}, {PROPAGATED, NONE}}, //DATA_WRITEBACK
+            {{PROPAGATED, NONE}, {PROPAGATED, NONE}}, //TRANSLATION_WRITEBACK
+            {{INVALID, NONE}, {INVALID, NONE}}, //DIRECTORY_DATA_WRITE
+            {{INVALID, NONE}, {INVALID, NONE}}, //DIRECTORY_DATA_READ
+            {{INVALID, NONE}, {INVALID, NONE}}, //DIRECTORY_TRANSLATION_WRITE
+            {{INVALID, NONE}, {INVALID, NONE}} //DIRECTORY_TRANSLATION_READ
+        }
+    };
+    
 };
 
+//Table of a protocol, NO_COHERENCE runs MOESI like it always did
+const CoherenceTable& coherenceTable(CoherenceProtocolEnum prot);
+
+bool parseCoherenceProtocol(const std::string& str, CoherenceProtocolEnum &prot);
+
+std::string coherenceProtocolName(CoherenceProtocolEnum prot);
+
+//Moves coh_state of a line on txn_kind and returns the action the cache has to take
+inline CoherenceAction nextCoherenceState(const CoherenceTable &table, CoherenceState &coh_state, kind txn_kind, bool is_l1, CoherenceState propagate_coh_state = INVALID)
+{
+    const CoherenceTransition &t = table[coh_state][txn_kind][is_l1];
+    coh_state = (t.next_state == PROPAGATED) ? propagate_coh_state : static_cast<CoherenceState>(t.next_state);
+    return static_cast<CoherenceAction>(t.action);
+}
+
 #endif /* Coherence_hpp */
@@ -8,6 +8,8 @@
 
 #include "Core.hpp"
 #include "Cache.hpp"
+#include "ParallelSim.hpp"
+#include <algorithm>
 
 bool Core::interfaceHier(bool ll_interface_complete)
 {
@@ -53,6 +55,18 @@ bool Core::interfaceHier(bool ll_interface_complete)
     return ll_interface_complete;
 }
 
+uint64_t Core::getL3TLBSetSize(bool is_large)
+{
+    unsigned long num_tlbs = m_tlb_hier->m_caches.size();
+    return (uint64_t) m_tlb_hier->m_caches[num_tlbs - (is_large ? 1 : 2)]->get_associativity() * L3_TLB_ENTRY_SIZE;
+}
+
+uint64_t Core::getL3TLBSetIndex(uint64_t l3tlbaddr, bool is_large)
+{
+    uint64_t l3_tlb_base_address = (is_large) ? (m_l3_small_tlb_base + m_l3_small_tlb_size) : m_l3_small_tlb_base;
+    return (l3tlbaddr - l3_tlb_base_address) / getL3TLBSetSize(is_large);
+}
+
 uint64_t Core::getL3TLBAddr(uint64_t va, kind type, uint64_t tid, bool is_large, bool insert)
 {
     // Convert virtual address to a TLB lookup address.
@@ -75,7 +89,7 @@ uint64_t Core::getL3TLBAddr(uint64_t va, kind type, uint64_t tid, bool is_large,
         l3_tlb_base_address = m_l3_small_tlb_base;
     }
     
-    uint64_t l3tlbaddr = l3_tlb_base_address + (set_index * 16 * 4);
+    uint64_t l3tlbaddr = l3_tlb_base_address + (set_index * getL3TLBSetSize(is_large));
     
     if(insert)
     {
@@ -176,13 +190,20 @@ std::shared_ptr<Cache> Core::get_lower_cache(uint64_t addr, bool is_translation,
     return nullptr;
 }
 
-void Core::tick()
+void Core::set_coherence_scheme(TranslationCoherenceScheme scheme, uint64_t shootdown_penalty)
+{
+    bool baseline = (scheme == BASELINE_SCHEME) || (scheme == IDEAL_SCHEME);
+    m_tick = baseline ? &Core::tick_scheme<true> : &Core::tick_scheme<false>;
+    m_shootdown_penalty = (scheme == IDEAL_SCHEME) ? 0 : shootdown_penalty;
+}
+
+template <bool baseline>
+void Core::tick_scheme()
 {
     m_tlb_hier->tick();
     m_cache_hier->tick();
     
-#ifdef BASELINE
-    if(stall)
+    if(baseline && stall)
     {
         //Till translation coherence is serviced, stall issue
         if(num_stall_cycles_per_shootdown == tlb_shootdown_penalty)
@@ -190,7 +211,18 @@ void Core::tick()
             //Invalidate from other cores
             for(int i = 0; i < m_other_cores.size(); i++)
             {
-                m_other_cores[i]->tlb_invalidate(tlb_shootdown_addr, tlb_shootdown_tid, tlb_shootdown_is_large);
+                if(ParallelSim::is_deferring())
+                {
+                    std::shared_ptr<Core> other_core = m_other_cores[i];
+                    uint64_t addr = tlb_shootdown_addr;
+                    uint64_t tid = tlb_shootdown_tid;
+                    bool is_large = tlb_shootdown_is_large;
+                    ParallelSim::defer([other_core, addr, tid, is_large]() { other_core->tlb_invalidate(addr, tid, is_large); });
+                }
+                else
+                {
+                    m_other_cores[i]->tlb_invalidate(tlb_shootdown_addr, tlb_shootdown_tid, tlb_shootdown_is_large);
+                }
             }
             stall = false;
             std::cout << "Unstalling core " << m_core_id << " at cycle = " << m_clk << "\n";
@@ -198,14 +230,14 @@ void Core::tick()
             std::cout << "Stall on core " << m_core_id << " = " << stall << "\n";
             std::cout << "Number of shootdowns on core = " << m_core_id << " = " << num_shootdown << "\n";
         }
-        else if(!m_rob->is_empty())
+        else
         {
+            //Counted even once the window drained: the shootdown entry may have retired on MAX_MEM_WAIT before the request queue reached it
             num_stall_cycles++;
             num_stall_cycles_per_shootdown++;
         }
     }
-#else
-    if(tr_wr_in_progress && m_rob->m_window[tr_coh_issue_ptr].done)
+    else if(!baseline && tr_wr_in_progress && m_rob->m_window[tr_coh_issue_ptr].done)
     {
         //If translation coherence request is serviced, issue CLFLUSH
         bool is_translation = true;
@@ -224,7 +256,6 @@ void Core::tick()
         std::cout << "Number of stall cycles = " << num_stall_cycles << " on core " << m_core_id << "\n";
         std::cout << "Number of shootdowns on core = " << m_core_id << " = " << num_shootdown << "\n";
     }
-#endif
     
     if(!stall)
     {
@@ -272,9 +303,8 @@ void Core::tick()
                     m_rob->request_queue.pop_front();
                 }
             }
-            else if(req.m_type == TRANSLATION_WRITE)
+            else if(req.m_type == TRANSLATION_WRITE && baseline)
             {
-#ifdef BASELINE
                 rr_iter->second.num_occ_in_req_queue--;
                 if(rr_iter->second.num_occ_in_req_queue == 0)
                 {
@@ -286,19 +316,13 @@ void Core::tick()
                 tlb_shootdown_addr = req.m_addr;
                 tlb_shootdown_tid = req.m_tid;
                 tlb_shootdown_is_large = req.m_is_large;
-                #ifdef IDEAL
-                tlb_shootdown_penalty = 0;
-                #else
-                #ifdef SHOOTDOWN_PENALTY
-                tlb_shootdown_penalty = SHOOTDOWN_PENALTY;
-                #else
-                tlb_shootdown_penalty = 0;
-                #endif
-                #endif
+                tlb_shootdown_penalty = m_shootdown_penalty;
                 num_stall_cycles_per_shootdown = 0;
                 num_shootdown++;
                 std::cout << "Stalling core " << m_core_id << " at cycle = " << m_clk << " until translation coherence is complete\n";
-#else
+            }
+            else if(req.m_type == TRANSLATION_WRITE)
+            {
                 std::cout << "Issuing translation coherence write to data hierarchy\n";
                 RequestStatus data_req_status = m_cache_hier->lookupAndFillCache(req);
                 if(data_req_status != REQUEST_RETRY)
@@ -317,7 +341,6 @@ void Core::tick()
                     num_shootdown++;
                     std::cout << "Stalling core " << m_core_id << " at cycle = " << m_clk << " until translation coherence is complete\n";
                 }
-#endif
             }
         }
     }
@@ -365,8 +388,23 @@ void Core::tick()
         }
         else
         {
-            m_rob->issue(req->m_is_memory_acc, req, m_clk);
-            traceVec.pop_front();
+            //Rest of the burst has not been handed to the core yet
+            if(req->m_num_avail == 0)
+            {
+                break;
+            }
+
+            //Issue as much of the burst as issue width and window allow, all in one entry
+            unsigned int num_instr = std::min((uint64_t) std::min(m_rob->m_issue_width - i, m_rob->num_free_slots()), req->m_num_avail);
+            req->m_num_instr -= num_instr;
+            req->m_num_avail -= num_instr;
+            m_rob->issue(req->m_is_memory_acc, (req->m_num_instr == 0) ? req : nullptr, m_clk, num_instr);
+            i += num_instr - 1;
+
+            if(req->m_num_instr == 0)
+            {
+                traceVec.pop_front();
+            }
         }
     }
 
@@ -399,6 +437,69 @@ bool Core::must_add_trace()
     return (traceVec.size() < 1000000);
 }
 
+uint64_t Core::cycles_to_next_event(bool is_input_pending)
+{
+    uint64_t num_cycles = UINT64_MAX;
+
+    if(stall)
+    {
+        num_cycles = tlb_shootdown_penalty - num_stall_cycles_per_shootdown;
+    }
+    else
+    {
+        if(tr_wr_in_progress && m_rob->m_window[tr_coh_issue_ptr].done)
+        {
+            return 0;
+        }
+
+        if(m_rob->request_queue.size() > 0)
+        {
+            auto rr_iter = m_rob->is_request_ready.find(m_rob->request_queue.front());
+            assert(rr_iter != m_rob->is_request_ready.end());
+            if(rr_iter->second.ready)
+            {
+                return 0;
+            }
+        }
+
+        if(!traceVec.empty() && m_rob->can_issue() && (traceVec.front()->m_is_memory_acc || traceVec.front()->m_num_avail > 0))
+        {
+            return 0;
+        }
+
+        //A request handed out in the next cycle, or the rest of the burst in front, would issue right away
+        if(is_input_pending && m_rob->can_issue() && (traceVec.empty() || traceVec.front()->m_num_avail == 0))
+        {
+            return 0;
+        }
+
+        //The clock only runs while the window holds instructions, and then the oldest one retires in time
+        uint64_t retire_clk = m_rob->get_next_retire_clk();
+        if(retire_clk != UINT64_MAX)
+        {
+            num_cycles = (retire_clk > m_clk) ? (retire_clk - m_clk) : 0;
+        }
+    }
+
+    return std::min(num_cycles, std::min(m_tlb_hier->cycles_to_next_event(), m_cache_hier->cycles_to_next_event()));
+}
+
+void Core::skip_cycles(uint64_t num_cycles)
+{
+    m_tlb_hier->skip_cycles(num_cycles);
+    m_cache_hier->skip_cycles(num_cycles);
+
+    if(stall)
+    {
+        num_stall_cycles += num_cycles;
+        num_stall_cycles_per_shootdown += num_cycles;
+    }
+    else if(!m_rob->is_empty())
+    {
+        m_clk += num_cycles;
+    }
+}
+
 void Core::tlb_invalidate(uint64_t addr, uint64_t tid, bool is_large)
 {
     m_tlb_hier->tlb_invalidate(addr, tid, is_large);
@@ -408,3 +509,22 @@ void Core::add_core(std::shared_ptr<Core> other_core)
 {
     m_other_cores.push_back(other_core);
 }
+
+void Core::reset_stats()
+{
+    m_stats_clk = m_clk;
+    num_merged_cycles = 0;
+    m_num_issued = 0;
+    m_num_retired = 0;
+    num_stall_cycles = 0;
+    num_shootdown = 0;
+}
+
+void Core::merge_stats(const Core &other)
+{
+    num_merged_cycles += other.get_num_cycles();
+    m_num_issued += other.m_num_issued;
+    m_num_retired += other.m_num_retired;
+    num_stall_cycles += other.num_stall_cycles;
+    num_shootdown += other.num_shootdown;
+}
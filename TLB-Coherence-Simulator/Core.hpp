@@ -64,6 +64,16 @@ private:
 
     std::vector<std::shared_ptr<Core>> m_other_cores;
 
+    //Per cycle work for the translation coherence scheme in use, set once by set_coherence_scheme
+    void (Core::*m_tick)() = &Core::tick_scheme<false>;
+    uint64_t m_shootdown_penalty = 0;
+
+    template <bool baseline>
+    void tick_scheme();
+
+    //Bytes of memory a set of the small or large L3 TLB takes
+    uint64_t getL3TLBSetSize(bool is_large);
+
 public:
     uint64_t m_l3_small_tlb_base = 0x0;
     uint64_t m_l3_small_tlb_size = 16 * 1024 * 1024;
@@ -81,6 +91,9 @@ public:
     bool tlb_shootdown_is_large;
     uint64_t num_stall_cycles_per_shootdown = 0;
     uint64_t num_shootdown = 0;
+    //Clock when the counters were reset last, and cycles of other runs merged in, see get_num_cycles
+    uint64_t m_stats_clk = 0;
+    uint64_t num_merged_cycles = 0;
 
     Core(std::shared_ptr<CacheSys> cache_hier, std::shared_ptr<CacheSys> tlb_hier, std::shared_ptr<ROB> rob, uint64_t l3_small_tlb_base = 0x0, uint64_t l3_small_tlb_size = 1024 * 1024) :
         m_cache_hier(cache_hier),
@@ -101,12 +114,20 @@ public:
     void set_core_id(unsigned int core_id);
     
     uint64_t getL3TLBAddr(uint64_t va, kind type, uint64_t pid, bool is_large, bool insert = true);
+
+    //Set of the L3 TLB that l3tlbaddr, an address from getL3TLBAddr, belongs to
+    uint64_t getL3TLBSetIndex(uint64_t l3tlbaddr, bool is_large);
     
     std::vector<uint64_t> retrieveAddr(uint64_t l3tlbaddr, kind type, uint64_t pid, bool is_large, bool is_higher_cache_small_tlb);
     
     std::shared_ptr<Cache> get_lower_cache(uint64_t addr, bool is_translation, bool is_large, unsigned int cache_level, CacheType cache_type);
     
-    void tick();
+    void set_coherence_scheme(TranslationCoherenceScheme scheme, uint64_t shootdown_penalty);
+
+    void tick()
+    {
+        (this->*m_tick)();
+    }
 
     void add_trace(Request *req);
 
@@ -114,9 +135,28 @@ public:
 
     bool must_add_trace();
 
+    //Ticks from now until one can change anything but the clocks and stall counters, UINT64_MAX if none will.
+    //is_input_pending: requests may still be handed to the core in the meantime
+    uint64_t cycles_to_next_event(bool is_input_pending);
+
+    //Stands for num_cycles ticks in which the core cannot make progress, see cycles_to_next_event
+    void skip_cycles(uint64_t num_cycles);
+
     void tlb_invalidate(uint64_t addr, uint64_t tid, bool is_large);
 
     void add_core(std::shared_ptr<Core> other_core);
+
+    //Cycles counted since the last reset_stats, plus those of the runs merged in
+    uint64_t get_num_cycles() const
+    {
+        return m_clk - m_stats_clk + num_merged_cycles;
+    }
+
+    //Zeroes the counters, instructions and cycles from here on are counted
+    void reset_stats();
+
+    //Adds the counters of other, the same core in another run
+    void merge_stats(const Core &other);
 };
 
 #endif /* Core_hpp */
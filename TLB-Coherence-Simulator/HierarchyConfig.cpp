@@ -0,0 +1,243 @@
+//
+//  HierarchyConfig.cpp
+//  TLB-Coherence-Simulator
+//
+//  Copyright © 2018 Yashwant Marathe. All rights reserved.
+//
+
+#include "HierarchyConfig.hpp"
+#include "Cache.hpp"
+#include <sstream>
+#include <cstdlib>
+
+static void setLevel(CacheConfig &c, const char *name, unsigned int num_sets, unsigned int associativity, unsigned int line_size, unsigned int latency_cycles, CacheType cache_type, bool is_large_page_tlb = false)
+{
+    c.name = name;
+    c.num_sets = num_sets;
+    c.associativity = associativity;
+    c.line_size = line_size;
+    c.latency_cycles = latency_cycles;
+    c.mshr_size = 0;
+    c.cache_type = cache_type;
+    c.is_large_page_tlb = is_large_page_tlb;
+    c.inclusive = false;
+    c.policy = LRU_POLICY;
+}
+
+static bool isPowerOfTwo(unsigned int num)
+{
+    return (num != 0) && ((num & (num - 1)) == 0);
+}
+
+static unsigned int parseUnsigned(const std::string &level, const std::string &field, const std::string &val)
+{
+    char *end;
+    unsigned long num = strtoul(val.c_str(), &end, 10);
+    if(val.empty() || *end != '\0')
+    {
+        std::cout << "[Error] " << level << "." << field << " expects a number, got " << val << std::endl;
+        exit(0);
+    }
+    return (unsigned int) num;
+}
+
+static void setField(CacheConfig &c, const std::string &field, const std::string &val)
+{
+    if(field == "sets")
+    {
+        c.num_sets = parseUnsigned(c.name, field, val);
+    }
+    else if(field == "ways")
+    {
+        c.associativity = parseUnsigned(c.name, field, val);
+    }
+    else if(field == "line" || field == "page")
+    {
+        c.line_size = parseUnsigned(c.name, field, val);
+    }
+    else if(field == "lat")
+    {
+        c.latency_cycles = parseUnsigned(c.name, field, val);
+    }
+    else if(field == "mshr")
+    {
+        c.mshr_size = parseUnsigned(c.name, field, val);
+    }
+    else if(field == "inclusive")
+    {
+        c.inclusive = (parseUnsigned(c.name, field, val) != 0);
+    }
+    else if(field == "type")
+    {
+        if(val == "data")
+            c.cache_type = DATA_ONLY;
+        else if(val == "translation")
+            c.cache_type = TRANSLATION_ONLY;
+        else if(val == "data_and_translation")
+            c.cache_type = DATA_AND_TRANSLATION;
+        else
+        {
+            std::cout << "[Error] Unknown cache type " << val << " for " << c.name << std::endl;
+            exit(0);
+        }
+    }
+    else if(field == "policy")
+    {
+        if(!parseReplPolicy(val, c.policy))
+        {
+            std::cout << "[Error] Unknown replacement policy " << val << " for " << c.name << std::endl;
+            exit(0);
+        }
+    }
+    else
+    {
+        std::cout << "[Error] Unknown field " << field << " for " << c.name << std::endl;
+        exit(0);
+    }
+
+    if((field == "sets" && !isPowerOfTwo(c.num_sets)) || ((field == "line" || field == "page") && !isPowerOfTwo(c.line_size)))
+    {
+        std::cout << "[Error] " << c.name << "." << field << " must be a power of two" << std::endl;
+        exit(0);
+    }
+
+    if(field == "ways" && c.associativity == 0)
+    {
+        std::cout << "[Error] " << c.name << " needs at least one way" << std::endl;
+        exit(0);
+    }
+
+    //The tree of a set is kept in one 64 bit word
+    if((field == "ways" || field == "policy") && c.policy == PLRU_POLICY && c.associativity > 64)
+    {
+        std::cout << "[Error] " << c.name << ".policy = plru supports at most 64 ways" << std::endl;
+        exit(0);
+    }
+}
+
+HierarchyConfig::HierarchyConfig()
+{
+    setLevel(levels[L1D_LEVEL], "l1d", 64, 8, 64, 4, DATA_ONLY);
+    setLevel(levels[L2D_LEVEL], "l2d", 1024, 4, 64, 12, DATA_AND_TRANSLATION);
+    setLevel(levels[LLC_LEVEL], "llc", 8192, 16, 64, 38, DATA_AND_TRANSLATION);
+    setLevel(levels[L1_SMALL_TLB_LEVEL], "l1tlb_small", 16, 4, 4096, 1, TRANSLATION_ONLY);
+    setLevel(levels[L1_LARGE_TLB_LEVEL], "l1tlb_large", 8, 4, 2 * 1024 * 1024, 1, TRANSLATION_ONLY, true);
+    setLevel(levels[L2_SMALL_TLB_LEVEL], "l2tlb_small", 64, 16, 4096, 14, TRANSLATION_ONLY);
+    setLevel(levels[L2_LARGE_TLB_LEVEL], "l2tlb_large", 32, 16, 2 * 1024 * 1024, 14, TRANSLATION_ONLY, true);
+    setLevel(levels[L3_SMALL_TLB_LEVEL], "l3tlb_small", 16384, 4, 4096, 75, TRANSLATION_ONLY);
+    setLevel(levels[L3_LARGE_TLB_LEVEL], "l3tlb_large", 4096, 4, 2 * 1024 * 1024, 75, TRANSLATION_ONLY, true);
+}
+
+bool HierarchyConfig::processPair(const std::string &name, const std::string &val)
+{
+    //Latency shorthands of older configs
+    if(name == "l2d_lat")
+    {
+        setField(levels[L2D_LEVEL], "lat", val);
+        return true;
+    }
+    if(name == "l3d_lat")
+    {
+        setField(levels[LLC_LEVEL], "lat", val);
+        return true;
+    }
+    if(name == "vl_lat")
+    {
+        setField(levels[L3_SMALL_TLB_LEVEL], "lat", val);
+        setField(levels[L3_LARGE_TLB_LEVEL], "lat", val);
+        return true;
+    }
+    if(name == "dram_lat")
+    {
+        memory_latency = parseUnsigned("memory", "lat", val);
+        return true;
+    }
+    if(name == "c2c_lat")
+    {
+        cache_to_cache_latency = parseUnsigned("cache_to_cache", "lat", val);
+        return true;
+    }
+
+    if(name == "coherence")
+    {
+        if(!parseCoherenceProtocol(val, coherence_protocol))
+        {
+            std::cout << "[Error] Unknown coherence protocol " << val << ", expected moesi, mesi or msi" << std::endl;
+            exit(0);
+        }
+        return true;
+    }
+
+    //L3 TLB sizes in bytes of backing memory
+    if(name == "vl_small_size" || name == "vl_large_size")
+    {
+        CacheConfig &c = levels[(name == "vl_small_size") ? L3_SMALL_TLB_LEVEL : L3_LARGE_TLB_LEVEL];
+        uint64_t size = strtoull(val.c_str(), NULL, 10);
+        setField(c, "sets", std::to_string(size / (L3_TLB_ENTRY_SIZE * c.associativity)));
+        return true;
+    }
+
+    std::size_t dot = name.find(".");
+    std::string level_name = name.substr(0, dot);
+
+    for(int i = 0; i < NUM_HIER_LEVELS; i++)
+    {
+        if(levels[i].name != level_name)
+        {
+            continue;
+        }
+
+        if(dot != std::string::npos)
+        {
+            setField(levels[i], name.substr(dot + 1), val);
+            return true;
+        }
+
+        //Whitespace separated field=value list
+        std::istringstream fields(val);
+        std::string field;
+        while(fields >> field)
+        {
+            std::size_t eq = field.find("=");
+            if(eq == std::string::npos)
+            {
+                std::cout << "[Error] Expected field=value for " << level_name << ", got " << field << std::endl;
+                exit(0);
+            }
+            setField(levels[i], field.substr(0, eq), field.substr(eq + 1));
+        }
+        return true;
+    }
+
+    return false;
+}
+
+std::shared_ptr<Cache> HierarchyConfig::create(HierLevel level) const
+{
+    const CacheConfig &c = levels[level];
+    std::shared_ptr<Cache> cache = std::make_shared<Cache>(Cache(c.num_sets, c.associativity, c.line_size, c.latency_cycles, c.cache_type, c.is_large_page_tlb, c.policy, coherence_protocol, c.inclusive));
+    cache->set_mshr_size(c.mshr_size);
+    return cache;
+}
+
+uint64_t HierarchyConfig::get_l3_small_tlb_size() const
+{
+    const CacheConfig &c = levels[L3_SMALL_TLB_LEVEL];
+    return (uint64_t) c.num_sets * c.associativity * L3_TLB_ENTRY_SIZE;
+}
+
+void HierarchyConfig::print(std::ostream &out) const
+{
+    static const char *type_names[] = {"data", "translation", "data_and_translation"};
+
+    for(int i = 0; i < NUM_HIER_LEVELS; i++)
+    {
+        const CacheConfig &c = levels[i];
+        out << "[HIERARCHY] " << c.name << ": sets = " << c.num_sets << ", ways = " << c.associativity;
+        out << ", " << (c.cache_type == TRANSLATION_ONLY ? "page" : "line") << " = " << c.line_size;
+        out << ", lat = " << c.latency_cycles << ", mshr = " << c.mshr_size << ", type = " << type_names[c.cache_type];
+        out << ", inclusive = " << c.inclusive << ", policy = " << replPolicyName(c.policy) << "\n";
+    }
+    out << "[HIERARCHY] memory: lat = " << memory_latency << ", cache to cache lat = " << cache_to_cache_latency << "\n";
+    out << "[HIERARCHY] coherence = " << coherenceProtocolName(coherence_protocol) << "\n";
+}
@@ -0,0 +1,82 @@
+//
+//  HierarchyConfig.hpp
+//  TLB-Coherence-Simulator
+//
+//  Copyright © 2018 Yashwant Marathe. All rights reserved.
+//
+
+#ifndef HierarchyConfig_hpp
+#define HierarchyConfig_hpp
+
+#include <iostream>
+#include <string>
+#include <memory>
+#include "utils.hpp"
+#include "ReplPolicy.hpp"
+#include "Coherence.hpp"
+
+class Cache;
+
+//Levels of the simulated hierarchy, every core gets its own L1/L2 data caches and L1/L2 TLBs,
+//the LLC and the L3 TLBs are shared
+enum HierLevel {
+    L1D_LEVEL,
+    L2D_LEVEL,
+    LLC_LEVEL,
+    L1_SMALL_TLB_LEVEL,
+    L1_LARGE_TLB_LEVEL,
+    L2_SMALL_TLB_LEVEL,
+    L2_LARGE_TLB_LEVEL,
+    L3_SMALL_TLB_LEVEL,
+    L3_LARGE_TLB_LEVEL,
+    NUM_HIER_LEVELS
+};
+
+class CacheConfig {
+public:
+    std::string name;
+    unsigned int num_sets;
+    unsigned int associativity;
+    //Page size for TLBs
+    unsigned int line_size;
+    unsigned int latency_cycles;
+    //0 keeps the built-in MSHR sizing of Cache
+    unsigned int mshr_size;
+    CacheType cache_type;
+    bool is_large_page_tlb;
+    bool inclusive;
+    ReplPolicyEnum policy;
+};
+
+//Cache and TLB geometry, read from the config file.
+//A level is set on one line, fields left out keep their current value:
+//    l2tlb_small = sets=64 ways=16 page=4096 lat=14 mshr=16 type=translation inclusive=0 policy=lru
+//or one field at a time, which is handy for sweeps:
+//    l2tlb_small.sets = 128
+//Level names are l1d, l2d, llc, l1tlb_small, l1tlb_large, l2tlb_small, l2tlb_large, l3tlb_small and l3tlb_large.
+//Defaults are the geometry the simulator always had.
+//Replacement policy is per level: policy = lru (default), plru (up to 64 ways), srrip, brrip or random.
+//All levels run the same coherence protocol: coherence = moesi (default), mesi or msi.
+//Requests that find a full MSHR retry until it drains, so a shared level needs room for the misses of every core:
+//an LLC MSHR much smaller than its default of 32 per core can stall the run for good.
+class HierarchyConfig {
+public:
+    CacheConfig levels[NUM_HIER_LEVELS];
+    uint64_t memory_latency = 200;
+    uint64_t cache_to_cache_latency = 50;
+    CoherenceProtocolEnum coherence_protocol = MOESI_COHERENCE;
+
+    HierarchyConfig();
+
+    //Applies a config pair if it describes the hierarchy, returns false otherwise
+    bool processPair(const std::string &name, const std::string &val);
+
+    std::shared_ptr<Cache> create(HierLevel level) const;
+
+    //Bytes of memory backing the small L3 TLB, the large L3 TLB sits right above it
+    uint64_t get_l3_small_tlb_size() const;
+
+    void print(std::ostream &out) const;
+};
+
+#endif /* HierarchyConfig_hpp */
@@ -0,0 +1,117 @@
+//
+//  MSHRFile.cpp
+//  TLB-Coherence-Simulator
+//
+//  Copyright © 2018 Yashwant Marathe. All rights reserved.
+//
+
+#include "MSHRFile.hpp"
+#include <algorithm>
+
+const uint32_t MSHRFile::NO_ENTRY;
+const unsigned int MSHRFile::KEY_SHIFT;
+
+void MSHRFile::set_capacity(unsigned int capacity)
+{
+    assert(m_size == 0);
+
+    m_entries.assign(capacity, Entry());
+    m_free.clear();
+    m_free.reserve(capacity);
+
+    //Lowest entries are handed out first
+    for(uint32_t e = capacity; e > 0; e--)
+    {
+        m_free.push_back(e - 1);
+    }
+
+    AddrSlot empty = {0, NO_ENTRY};
+    m_addr_index.reset(2 * (size_t) capacity, empty);
+}
+
+uint32_t MSHRFile::find(const Request &r) const
+{
+    uint64_t key = pack_key(r.m_addr, r.m_type, r.m_is_large);
+
+    for(uint32_t e = find_addr(r.m_addr); e != NO_ENTRY; e = m_entries[e].m_next)
+    {
+        const Entry &entry = m_entries[e];
+        if(entry.m_key == key && entry.m_tid == r.m_tid && ((!entry.m_key_core_agnostic && !r.m_is_core_agnostic) ? (entry.m_core_id == r.m_core_id) : true))
+        {
+            return e;
+        }
+    }
+
+    return NO_ENTRY;
+}
+
+uint32_t MSHRFile::allocate(const Request &r)
+{
+    if(m_free.empty())
+    {
+        return NO_ENTRY;
+    }
+
+    uint32_t e = m_free.back();
+    m_free.pop_back();
+
+    Entry &entry = m_entries[e];
+    entry.m_key = pack_key(r.m_addr, r.m_type, r.m_is_large);
+    entry.m_tid = r.m_tid;
+    entry.m_core_id = r.m_core_id;
+    entry.m_key_core_agnostic = r.m_is_core_agnostic;
+    entry.m_is_core_agnostic = false;
+    entry.m_dirty = false;
+    entry.m_coh_state = INVALID;
+    entry.m_next = NO_ENTRY;
+
+    //Appended to the chain of its address, so entries of an address are kept in allocation order
+    size_t slot = find_slot(r.m_addr);
+    if(m_addr_index[slot].head == NO_ENTRY)
+    {
+        m_addr_index[slot].addr = r.m_addr;
+        m_addr_index[slot].head = e;
+    }
+    else
+    {
+        uint32_t tail = m_addr_index[slot].head;
+        while(m_entries[tail].m_next != NO_ENTRY)
+        {
+            tail = m_entries[tail].m_next;
+        }
+        m_entries[tail].m_next = e;
+    }
+
+    m_size++;
+    m_peak_size = std::max(m_peak_size, m_size);
+    return e;
+}
+
+void MSHRFile::release(uint32_t e)
+{
+    uint64_t addr = m_entries[e].m_key >> KEY_SHIFT;
+    size_t slot = find_slot(addr);
+    assert(m_addr_index[slot].head != NO_ENTRY);
+
+    if(m_addr_index[slot].head == e)
+    {
+        m_addr_index[slot].head = m_entries[e].m_next;
+        if(m_addr_index[slot].head == NO_ENTRY)
+        {
+            m_addr_index.erase(slot);
+        }
+    }
+    else
+    {
+        uint32_t prev = m_addr_index[slot].head;
+        while(m_entries[prev].m_next != e)
+        {
+            prev = m_entries[prev].m_next;
+            assert(prev != NO_ENTRY);
+        }
+        m_entries[prev].m_next = m_entries[e].m_next;
+    }
+
+    m_free.push_back(e);
+    m_size--;
+}
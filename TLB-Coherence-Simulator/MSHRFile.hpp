@@ -0,0 +1,149 @@
+//
+//  MSHRFile.hpp
+//  TLB-Coherence-Simulator
+//
+//  Copyright © 2018 Yashwant Marathe. All rights reserved.
+//
+
+#ifndef MSHRFile_hpp
+#define MSHRFile_hpp
+
+#include <iostream>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <cassert>
+#include "utils.hpp"
+#include "Request.hpp"
+#include "OpenAddressTable.hpp"
+
+//Misses in flight at one cache, in a fixed number of entries allocated once.
+//Entries are found by address through an OpenAddressTable that points to the first entry of the address, later entries of the same address are chained from it.
+//An entry matches a Request the way Request::operator == compares two requests.
+class MSHRFile {
+public:
+    static const uint32_t NO_ENTRY = 0xffffffff;
+
+    class Entry {
+    public:
+        //Address, kind and is_large of the request that allocated the entry, see pack_key
+        uint64_t m_key;
+        uint64_t m_tid;
+        unsigned int m_core_id;
+        bool m_key_core_agnostic;
+
+        //State of the miss, updated by the cache while it is in flight
+        bool m_is_core_agnostic;
+        bool m_dirty;
+        CoherenceState m_coh_state;
+
+        uint32_t m_next;
+    };
+
+private:
+    static const unsigned int KEY_SHIFT = 5;
+
+    class AddrSlot {
+    public:
+        uint64_t addr;
+        uint32_t head;
+    };
+
+    class AddrHash {
+    public:
+        size_t operator () (const AddrSlot &slot) const { return (size_t) mix_hash(slot.addr); }
+    };
+
+    class AddrIsFree {
+    public:
+        bool operator () (const AddrSlot &slot) const { return slot.head == NO_ENTRY; }
+    };
+
+    std::vector<Entry> m_entries;
+    std::vector<uint32_t> m_free;
+
+    OpenAddressTable<AddrSlot, AddrHash, AddrIsFree> m_addr_index;
+
+    uint32_t m_size;
+    uint32_t m_peak_size;
+
+    static uint64_t pack_key(uint64_t addr, kind type, bool is_large)
+    {
+        assert((addr >> (64 - KEY_SHIFT)) == 0);
+        return (addr << KEY_SHIFT) | (type << 1) | is_large;
+    }
+
+    size_t find_slot(uint64_t addr) const
+    {
+        return m_addr_index.find((size_t) mix_hash(addr), [addr](const AddrSlot &slot) { return slot.addr == addr; });
+    }
+
+public:
+    MSHRFile() : m_size(0), m_peak_size(0) {}
+
+    //Sizes the file, only while it holds no entries
+    void set_capacity(unsigned int capacity);
+
+    unsigned int get_capacity() const
+    {
+        return (unsigned int) m_entries.size();
+    }
+
+    unsigned int size() const
+    {
+        return m_size;
+    }
+
+    bool full() const
+    {
+        return m_free.empty();
+    }
+
+    //Most entries ever in use at once
+    unsigned int get_peak_size() const
+    {
+        return m_peak_size;
+    }
+
+    //Starts the peak over from the entries in use now
+    void reset_peak_size()
+    {
+        m_peak_size = m_size;
+    }
+
+    //Raises the peak to peak_size, seen by another run of the same cache
+    void merge_peak_size(unsigned int peak_size)
+    {
+        m_peak_size = std::max(m_peak_size, (uint32_t) peak_size);
+    }
+
+    //First entry for the address, NO_ENTRY if none
+    uint32_t find_addr(uint64_t addr) const
+    {
+        if(m_addr_index.capacity() == 0)
+        {
+            return NO_ENTRY;
+        }
+        return m_addr_index[find_slot(addr)].head;
+    }
+
+    uint32_t next(uint32_t e) const
+    {
+        return m_entries[e].m_next;
+    }
+
+    //Entry allocated by a request equal to r, NO_ENTRY if none
+    uint32_t find(const Request &r) const;
+
+    //Takes a free entry for r with a clean miss state, NO_ENTRY if the file is full
+    uint32_t allocate(const Request &r);
+
+    void release(uint32_t e);
+
+    Entry& operator [] (uint32_t e)
+    {
+        return m_entries[e];
+    }
+};
+
+#endif /* MSHRFile_hpp */
@@ -0,0 +1,163 @@
+//
+//  OpenAddressTable.hpp
+//  TLB-Coherence-Simulator
+//
+//  Copyright © 2018 Yashwant Marathe. All rights reserved.
+//
+
+#ifndef OpenAddressTable_hpp
+#define OpenAddressTable_hpp
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+//Spreads the bits of a key over the whole word, so the low bits make a good slot number
+inline uint64_t mix_hash(uint64_t h)
+{
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return h;
+}
+
+//Open-addressing table (linear probing, backward-shift deletion) of Slots, with a power of two capacity.
+//Hash gives the hash of the key of a used slot, IsFree tells free slots apart from used ones.
+//The table does not know the keys: callers find a slot by the hash of its key and a match on the slot,
+//and keep any data indexed by slot number in step through the moved and placed callbacks.
+template <class Slot, class Hash, class IsFree>
+class OpenAddressTable {
+private:
+    std::vector<Slot> m_slots;
+    size_t m_mask;
+
+    //What a free slot holds
+    Slot m_free_slot;
+
+    Hash m_hash;
+    IsFree m_is_free;
+
+public:
+    OpenAddressTable() : m_mask(0) {}
+
+    //Frees every slot, the capacity becomes the smallest power of two of at least 16 slots and min_capacity.
+    //IsFree must hold for free_slot.
+    void reset(size_t min_capacity, const Slot &free_slot)
+    {
+        size_t capacity = 16;
+        while(capacity < min_capacity)
+        {
+            capacity <<= 1;
+        }
+
+        m_free_slot = free_slot;
+        m_slots.assign(capacity, m_free_slot);
+        m_mask = capacity - 1;
+    }
+
+    //0 until reset
+    size_t capacity() const
+    {
+        return m_slots.size();
+    }
+
+    size_t get_memory_usage() const
+    {
+        return m_slots.capacity() * sizeof(Slot);
+    }
+
+    bool is_free(size_t i) const
+    {
+        return m_is_free(m_slots[i]);
+    }
+
+    size_t next(size_t i) const
+    {
+        return (i + 1) & m_mask;
+    }
+
+    //First slot of the probe run of a key with this hash
+    size_t home(size_t hash) const
+    {
+        return hash & m_mask;
+    }
+
+    Slot& operator [] (size_t i)
+    {
+        return m_slots[i];
+    }
+
+    const Slot& operator [] (size_t i) const
+    {
+        return m_slots[i];
+    }
+
+    //First slot of the probe run of hash that match holds for, the free slot ending the run if there is none
+    template <class Match>
+    size_t find(size_t hash, Match match) const
+    {
+        size_t i = home(hash);
+        while(!m_is_free(m_slots[i]) && !match(m_slots[i]))
+        {
+            i = next(i);
+        }
+        return i;
+    }
+
+    //Frees slot hole, returns the slot freed in the end.
+    //Backward shift: pull later slots of the probe run into the hole when their home allows it, moved(from, to) is called after each move
+    template <class Moved>
+    size_t erase(size_t hole, Moved moved)
+    {
+        for(size_t i = next(hole); !m_is_free(m_slots[i]); i = next(i))
+        {
+            size_t slot_home = home(m_hash(m_slots[i]));
+            if(((i - slot_home) & m_mask) >= ((i - hole) & m_mask))
+            {
+                m_slots[hole] = m_slots[i];
+                moved(i, hole);
+                hole = i;
+            }
+        }
+
+        m_slots[hole] = m_free_slot;
+        return hole;
+    }
+
+    size_t erase(size_t hole)
+    {
+        return erase(hole, [](size_t, size_t) {});
+    }
+
+    //Doubles the capacity. Used slots are placed again in slot order, each in the first free slot of its probe run,
+    //placed(old slot, new slot) is called for each
+    template <class Placed>
+    void grow(Placed placed)
+    {
+        std::vector<Slot> old_slots(2 * m_slots.size(), m_free_slot);
+        old_slots.swap(m_slots);
+        m_mask = m_slots.size() - 1;
+
+        for(size_t i = 0; i < old_slots.size(); i++)
+        {
+            if(!m_is_free(old_slots[i]))
+            {
+                size_t slot = home(m_hash(old_slots[i]));
+                while(!m_is_free(m_slots[slot]))
+                {
+                    slot = next(slot);
+                }
+
+                m_slots[slot] = old_slots[i];
+                placed(i, slot);
+            }
+        }
+    }
+
+    void grow()
+    {
+        grow([](size_t, size_t) {});
+    }
+};
+
+#endif /* OpenAddressTable_hpp */
@@ -0,0 +1,186 @@
+//
+//  ParallelSim.cpp
+//  TLB-Coherence-Simulator
+//
+//  Copyright © 2018 Yashwant Marathe. All rights reserved.
+//
+
+#include "ParallelSim.hpp"
+#include "Core.hpp"
+#include "CacheSys.hpp"
+#include <assert.h>
+#include <time.h>
+
+thread_local ParallelSim::CoreContext *ParallelSim::t_context = nullptr;
+
+void ParallelSim::Barrier::wait()
+{
+    unsigned int generation = m_generation.load(std::memory_order_acquire);
+
+    if(m_num_waiting.fetch_add(1, std::memory_order_acq_rel) + 1 == m_num_threads)
+    {
+        m_num_waiting.store(0, std::memory_order_relaxed);
+        m_generation.fetch_add(1, std::memory_order_release);
+        return;
+    }
+
+    while(m_generation.load(std::memory_order_acquire) == generation)
+    {
+        std::this_thread::yield();
+    }
+}
+
+ParallelSim::ParallelSim(const std::vector<std::shared_ptr<Core>> &cores, CacheSys *uncore_data, CacheSys *uncore_tlb, unsigned int num_threads, unsigned int quantum) :
+m_cores(cores), m_uncore_data(uncore_data), m_uncore_tlb(uncore_tlb), m_wait(0), m_barrier(std::min(num_threads, (unsigned int) cores.size())), m_stop(false), m_quantum(quantum)
+{
+    assert(num_threads > 0 && quantum > 0);
+
+    unsigned int num_cores = (unsigned int) m_cores.size();
+    num_threads = std::min(num_threads, num_cores);
+
+    //Cores tick in lock step, the shared levels catch up from the same cycle
+    m_clk = m_uncore_data->m_clk;
+
+    for(int i = 0; i < num_cores; i++)
+    {
+        m_contexts.emplace_back(new CoreContext());
+    }
+
+    //Every thread gets a contiguous run of cores
+    m_first_cores_end = num_cores / num_threads;
+    m_busy.resize(num_threads - 1, 0);
+
+    for(int i = 1; i < num_threads; i++)
+    {
+        m_workers.emplace_back(&ParallelSim::work, this, i - 1, i * num_cores / num_threads, (i + 1) * num_cores / num_threads);
+    }
+}
+
+ParallelSim::~ParallelSim()
+{
+    m_stop = true;
+    m_barrier.wait();
+
+    for(int i = 0; i < m_workers.size(); i++)
+    {
+        m_workers[i].join();
+    }
+}
+
+void ParallelSim::tick_cores(unsigned int first_core, unsigned int last_core)
+{
+    for(uint64_t clk = m_clk; clk < m_clk + m_quantum; clk++)
+    {
+        for(unsigned int i = first_core; i < last_core; i++)
+        {
+            t_context = m_contexts[i].get();
+            t_context->clk = clk;
+            m_cores[i]->tick();
+        }
+    }
+
+    t_context = nullptr;
+}
+
+void ParallelSim::work(unsigned int worker, unsigned int first_core, unsigned int last_core)
+{
+    while(true)
+    {
+        m_barrier.wait();
+
+        if(m_stop)
+        {
+            return;
+        }
+
+        double start = thread_seconds();
+        tick_cores(first_core, last_core);
+        m_busy[worker] += thread_seconds() - start;
+
+        m_barrier.wait();
+    }
+}
+
+void ParallelSim::run_quantum()
+{
+    //Start the workers, tick the first run of cores, and wait for the workers to finish the quantum
+    double start = thread_seconds();
+    m_barrier.wait();
+    m_wait += thread_seconds() - start;
+
+    tick_cores(0, m_first_cores_end);
+
+    start = thread_seconds();
+    m_barrier.wait();
+    m_wait += thread_seconds() - start;
+
+    weave();
+}
+
+void ParallelSim::weave()
+{
+    for(uint64_t clk = m_clk; clk < m_clk + m_quantum; clk++)
+    {
+        //Shared levels see the accesses of a cycle as the last core did in a serial run: before it ticks them
+        m_uncore_data->m_clk = clk;
+        m_uncore_tlb->m_clk = clk;
+
+        for(int i = 0; i < m_contexts.size(); i++)
+        {
+            SPSCQueue<Message> &outbox = m_contexts[i]->outbox;
+
+            for(Message *msg = outbox.front(); msg != nullptr && msg->clk == clk; msg = outbox.front())
+            {
+                std::function<void()> fn = std::move(msg->fn);
+                outbox.pop();
+                fn();
+            }
+        }
+
+        m_uncore_tlb->tick();
+        m_uncore_data->tick();
+    }
+
+    m_clk += m_quantum;
+
+    for(int i = 0; i < m_contexts.size(); i++)
+    {
+        assert(m_contexts[i]->outbox.front() == nullptr);
+    }
+}
+
+bool ParallelSim::is_done()
+{
+    return m_uncore_data->is_done() && m_uncore_tlb->is_done();
+}
+
+uint64_t ParallelSim::cycles_to_next_event()
+{
+    return std::min(m_uncore_data->cycles_to_next_event(), m_uncore_tlb->cycles_to_next_event());
+}
+
+void ParallelSim::skip_cycles(uint64_t num_cycles)
+{
+    m_uncore_data->skip_cycles(num_cycles);
+    m_uncore_tlb->skip_cycles(num_cycles);
+    m_clk += num_cycles;
+}
+
+double ParallelSim::get_worker_seconds()
+{
+    double seconds = 0;
+
+    for(int i = 0; i < m_busy.size(); i++)
+    {
+        seconds += m_busy[i];
+    }
+
+    return seconds;
+}
+
+double ParallelSim::thread_seconds()
+{
+    timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
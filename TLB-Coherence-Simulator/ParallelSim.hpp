@@ -0,0 +1,149 @@
+//
+//  ParallelSim.hpp
+//  TLB-Coherence-Simulator
+//
+//  Copyright © 2018 Yashwant Marathe. All rights reserved.
+//
+
+#ifndef ParallelSim_hpp
+#define ParallelSim_hpp
+
+#include <iostream>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include "SPSCQueue.hpp"
+
+class Core;
+class CacheSys;
+
+//Ticks the cores on worker threads, quantum cycles at a time, see main.cpp -threads.
+//A worker owns its cores, their CacheSys and their private caches. Everything else, i.e. the LLC, the L3 TLBs,
+//the coherence lists and the TLBs of the other cores and the presence trackers of the TraceProcessor, is only touched
+//while the workers wait at a barrier. Inside a quantum a worker hands such work to defer(): it is queued, stamped with
+//the cycle, in the outbox of the core, and applied by the calling thread after the quantum in cycle order, core by core,
+//interleaved with the ticks of the shared levels.
+//The default quantum is the lookahead, the fewest cycles a request needs to get from a core to the shared levels,
+//see Simulator::default_quantum. Results of the shared levels, i.e. fills, coherence updates, shootdowns, reach a core
+//at the next quantum boundary, up to one quantum late, so the IPC differs slightly from a serial run, see -bench parallel.
+//The results do not depend on the number of threads.
+class ParallelSim {
+private:
+    class Message {
+    public:
+        uint64_t clk;
+        std::function<void()> fn;
+    };
+
+    //Per core state of a quantum
+    class CoreContext {
+    public:
+        SPSCQueue<Message> outbox;
+        uint64_t clk;
+    };
+
+    //Spins until every thread arrived, yielding so it also copes with more threads than host cores
+    class Barrier {
+    private:
+        unsigned int m_num_threads;
+        std::atomic<unsigned int> m_num_waiting;
+        std::atomic<unsigned int> m_generation;
+
+    public:
+        Barrier(unsigned int num_threads) : m_num_threads(num_threads), m_num_waiting(0), m_generation(0) {}
+
+        void wait();
+    };
+
+    //Context of the core the calling worker is ticking, nullptr outside of a worker
+    static thread_local CoreContext *t_context;
+
+    std::vector<std::shared_ptr<Core>> m_cores;
+    CacheSys *m_uncore_data;
+    CacheSys *m_uncore_tlb;
+
+    std::vector<std::unique_ptr<CoreContext>> m_contexts;
+    //The calling thread ticks the first run of cores, the workers the others
+    std::vector<std::thread> m_workers;
+    //CPU time each worker spent ticking
+    std::vector<double> m_busy;
+    //CPU time the calling thread spent at the barrier
+    double m_wait;
+    unsigned int m_first_cores_end;
+    Barrier m_barrier;
+    bool m_stop;
+
+    unsigned int m_quantum;
+    //First cycle of the next quantum
+    uint64_t m_clk;
+
+    void work(unsigned int worker, unsigned int first_core, unsigned int last_core);
+
+    //Ticks cores first_core to last_core through the quantum
+    void tick_cores(unsigned int first_core, unsigned int last_core);
+
+    //Applies the messages of the last quantum and ticks the shared levels through it
+    void weave();
+
+public:
+    //uncore_data and uncore_tlb hold the LLC and the L3 TLBs, the shared levels must have been attached to them
+    ParallelSim(const std::vector<std::shared_ptr<Core>> &cores, CacheSys *uncore_data, CacheSys *uncore_tlb, unsigned int num_threads, unsigned int quantum);
+
+    ParallelSim(const ParallelSim&) = delete;
+    ParallelSim& operator = (const ParallelSim&) = delete;
+
+    ~ParallelSim();
+
+    //Ticks every core quantum times, then catches the shared levels up
+    void run_quantum();
+
+    unsigned int get_quantum()
+    {
+        return m_quantum;
+    }
+
+    //Whether the shared levels have nothing queued
+    bool is_done();
+
+    //Ticks from now until the shared levels serve a request, UINT64_MAX if nothing is queued, see Simulator::run_parallel
+    uint64_t cycles_to_next_event();
+
+    //Stands for num_cycles ticks of the shared levels that serve nothing, the cores skip them on their own
+    void skip_cycles(uint64_t num_cycles);
+
+    //Threads ticking cores, the calling thread included
+    unsigned int get_num_threads()
+    {
+        return (unsigned int) m_workers.size() + 1;
+    }
+
+    //CPU time the workers spent ticking, summed, and CPU time the calling thread spent at the barrier, see Simulator::run_parallel
+    double get_worker_seconds();
+
+    double get_wait_seconds()
+    {
+        return m_wait;
+    }
+
+    //CPU time of the calling thread, as the host counts it
+    static double thread_seconds();
+
+    //Whether the calling thread is a worker in a quantum, and must defer() work on state it does not own
+    static bool is_deferring()
+    {
+        return t_context != nullptr;
+    }
+
+    //Queues fn to run after the quantum, in the cycle of the current tick
+    static void defer(std::function<void()> fn)
+    {
+        Message msg;
+        msg.clk = t_context->clk;
+        msg.fn = std::move(fn);
+        t_context->outbox.push(std::move(msg));
+    }
+};
+
+#endif /* ParallelSim_hpp */
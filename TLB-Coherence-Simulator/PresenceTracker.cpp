@@ -0,0 +1,282 @@
+//
+//  PresenceTracker.cpp
+//  TLB-Coherence-Simulator
+//
+//  Copyright © 2018 Yashwant Marathe. All rights reserved.
+//
+
+#include "PresenceTracker.hpp"
+#include <assert.h>
+#include <algorithm>
+
+const uint32_t PresenceTracker::NO_SLOT;
+const uint64_t PresenceTracker::NO_KEY;
+
+PresenceTracker::PresenceTracker(unsigned int num_cores, size_t initial_capacity) : m_num_cores(num_cores), m_num_words((num_cores + 63) / 64), m_size(0), m_num_pos(0)
+{
+    m_slots.reset(initial_capacity, Slot());
+
+    size_t capacity = m_slots.capacity();
+    m_sharers.assign(capacity * m_num_words, 0);
+
+    PosSlot empty = {NO_KEY, 0};
+    m_pos.reset(capacity, empty);
+    m_buckets.resize((m_num_cores + 1) * m_num_cores);
+}
+
+uint32_t PresenceTracker::probe(const RequestDesc &rdesc, bool insert)
+{
+    size_t i = m_slots.find(hash(rdesc), [&](const Slot &slot) { return slot.key == rdesc; });
+    Slot &slot = m_slots[i];
+
+    if(!slot.used)
+    {
+        if(!insert)
+        {
+            return NO_SLOT;
+        }
+
+        slot.key = rdesc;
+        slot.num_sharers = 0;
+        slot.used = true;
+        m_size++;
+    }
+
+    return (uint32_t) i;
+}
+
+void PresenceTracker::set_pos(uint32_t slot, unsigned int core, uint32_t pos)
+{
+    //Kept at most half full
+    if(2 * (m_num_pos + 1) > m_pos.capacity())
+    {
+        m_pos.grow();
+    }
+
+    size_t i = find_pos(slot, core);
+    if(m_pos.is_free(i))
+    {
+        m_pos[i].key = (uint64_t) slot * m_num_cores + core;
+        m_num_pos++;
+    }
+    m_pos[i].pos = pos;
+}
+
+void PresenceTracker::erase_pos(uint32_t slot, unsigned int core)
+{
+    size_t i = find_pos(slot, core);
+    assert(!m_pos.is_free(i));
+
+    m_pos.erase(i);
+    m_num_pos--;
+}
+
+void PresenceTracker::bucket_insert(uint32_t slot)
+{
+    uint64_t *sharers = sharers_of(slot);
+
+    for(unsigned int w = 0; w < m_num_words; w++)
+    {
+        for(uint64_t mask = sharers[w]; mask != 0; mask &= (mask - 1))
+        {
+            unsigned int core = w * 64 + __builtin_ctzll(mask);
+            std::vector<uint32_t> &b = bucket(m_slots[slot].num_sharers, core);
+            set_pos(slot, core, b.size());
+            b.push_back(slot);
+        }
+    }
+}
+
+void PresenceTracker::bucket_erase(uint32_t slot)
+{
+    uint64_t *sharers = sharers_of(slot);
+
+    for(unsigned int w = 0; w < m_num_words; w++)
+    {
+        for(uint64_t mask = sharers[w]; mask != 0; mask &= (mask - 1))
+        {
+            unsigned int core = w * 64 + __builtin_ctzll(mask);
+            std::vector<uint32_t> &b = bucket(m_slots[slot].num_sharers, core);
+
+            //Move the last page of the bucket into the hole
+            uint32_t pos = get_pos(slot, core);
+            uint32_t last = b.back();
+            b[pos] = last;
+            set_pos(last, core, pos);
+            b.pop_back();
+            erase_pos(slot, core);
+        }
+    }
+}
+
+void PresenceTracker::move_slot(uint32_t from, uint32_t to)
+{
+    std::copy(sharers_of(from), sharers_of(from) + m_num_words, sharers_of(to));
+
+    //Buckets keep their order, only the slot number changes
+    uint64_t *sharers = sharers_of(to);
+    for(unsigned int w = 0; w < m_num_words; w++)
+    {
+        for(uint64_t mask = sharers[w]; mask != 0; mask &= (mask - 1))
+        {
+            unsigned int core = w * 64 + __builtin_ctzll(mask);
+            uint32_t pos = get_pos(from, core);
+            erase_pos(from, core);
+            set_pos(to, core, pos);
+            bucket(m_slots[to].num_sharers, core)[pos] = to;
+        }
+    }
+}
+
+void PresenceTracker::grow()
+{
+    std::vector<uint64_t> old_sharers;
+    old_sharers.swap(m_sharers);
+
+    std::vector<uint32_t> new_slot(m_slots.capacity(), NO_SLOT);
+    m_slots.grow([&](size_t from, size_t to) { new_slot[from] = (uint32_t) to; });
+
+    size_t capacity = m_slots.capacity();
+    m_sharers.assign(capacity * m_num_words, 0);
+
+    PosSlot empty = {NO_KEY, 0};
+    m_pos.reset(m_pos.capacity(), empty);
+    m_num_pos = 0;
+
+    for(size_t i = 0; i < new_slot.size(); i++)
+    {
+        if(new_slot[i] != NO_SLOT)
+        {
+            std::copy(&old_sharers[i * m_num_words], &old_sharers[i * m_num_words] + m_num_words, sharers_of(new_slot[i]));
+        }
+    }
+
+    //Rebuilt in old slot order, so every bucket keeps the relative order of its pages
+    std::vector<std::vector<uint32_t>> old_buckets(m_buckets.size());
+    old_buckets.swap(m_buckets);
+
+    for(size_t b = 0; b < old_buckets.size(); b++)
+    {
+        unsigned int core = b % m_num_cores;
+        for(size_t j = 0; j < old_buckets[b].size(); j++)
+        {
+            uint32_t slot = new_slot[old_buckets[b][j]];
+            set_pos(slot, core, m_buckets[b].size());
+            m_buckets[b].push_back(slot);
+        }
+    }
+}
+
+void PresenceTracker::add(const RequestDesc &rdesc, unsigned int core_id)
+{
+    assert(core_id < m_num_cores);
+
+    //Keep the load factor at or below 1/2
+    if(2 * (m_size + 1) > m_slots.capacity())
+    {
+        grow();
+    }
+
+    uint32_t slot = probe(rdesc, true);
+    uint64_t &word = sharers_of(slot)[core_id / 64];
+    uint64_t bit = 1ULL << (core_id % 64);
+
+    if(word & bit)
+    {
+        return;
+    }
+
+    bucket_erase(slot);
+    word |= bit;
+    m_slots[slot].num_sharers++;
+    bucket_insert(slot);
+}
+
+void PresenceTracker::remove(const RequestDesc &rdesc, unsigned int core_id)
+{
+    if(core_id >= m_num_cores)
+    {
+        return;
+    }
+
+    uint32_t slot = probe(rdesc, false);
+    if(slot == NO_SLOT || !is_sharer(slot, core_id))
+    {
+        return;
+    }
+
+    bucket_erase(slot);
+    sharers_of(slot)[core_id / 64] &= ~(1ULL << (core_id % 64));
+    m_slots[slot].num_sharers--;
+
+    if(m_slots[slot].num_sharers == 0)
+    {
+        size_t hole = m_slots.erase(slot, [this](size_t from, size_t to) { move_slot((uint32_t) from, (uint32_t) to); });
+        std::fill(sharers_of(hole), sharers_of(hole) + m_num_words, 0);
+        m_size--;
+    }
+    else
+    {
+        bucket_insert(slot);
+    }
+}
+
+const RequestDesc* PresenceTracker::find(unsigned int core_id, unsigned int num_cores)
+{
+    if(core_id >= m_num_cores || num_cores == 0 || num_cores > m_num_cores)
+    {
+        return nullptr;
+    }
+
+    std::vector<uint32_t> &b = bucket(num_cores, core_id);
+    return b.empty() ? nullptr : &m_slots[b.back()].key;
+}
+
+const RequestDesc* PresenceTracker::find_any(unsigned int core_id)
+{
+    for(unsigned int num_cores = 1; num_cores <= m_num_cores; num_cores++)
+    {
+        const RequestDesc *rdesc = find(core_id, num_cores);
+        if(rdesc != nullptr)
+        {
+            return rdesc;
+        }
+    }
+
+    return nullptr;
+}
+
+std::vector<unsigned int> PresenceTracker::get_sharers(const RequestDesc &rdesc)
+{
+    std::vector<unsigned int> cores;
+
+    uint32_t slot = probe(rdesc, false);
+    if(slot == NO_SLOT)
+    {
+        return cores;
+    }
+
+    uint64_t *sharers = sharers_of(slot);
+    for(unsigned int w = 0; w < m_num_words; w++)
+    {
+        for(uint64_t mask = sharers[w]; mask != 0; mask &= (mask - 1))
+        {
+            cores.push_back(w * 64 + __builtin_ctzll(mask));
+        }
+    }
+
+    return cores;
+}
+
+size_t PresenceTracker::get_memory_usage()
+{
+    size_t bytes = m_slots.get_memory_usage() + m_sharers.capacity() * sizeof(uint64_t) + m_pos.get_memory_usage();
+    bytes += m_buckets.capacity() * sizeof(std::vector<uint32_t>);
+
+    for(size_t i = 0; i < m_buckets.size(); i++)
+    {
+        bytes += m_buckets[i].capacity() * sizeof(uint32_t);
+    }
+
+    return bytes;
+}
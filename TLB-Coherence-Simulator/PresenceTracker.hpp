@@ -0,0 +1,185 @@
+//
+//  PresenceTracker.hpp
+//  TLB-Coherence-Simulator
+//
+//  Copyright © 2018 Yashwant Marathe. All rights reserved.
+//
+
+#ifndef PresenceTracker_hpp
+#define PresenceTracker_hpp
+
+#include <iostream>
+#include <vector>
+#include <functional>
+#include <cstdint>
+#include "utils.hpp"
+#include "OpenAddressTable.hpp"
+
+class RequestDesc {
+    public:
+        uint64_t m_addr;
+        uint64_t m_tid;
+        bool m_is_large;
+
+        RequestDesc(uint64_t addr, uint64_t tid, bool is_large) : m_addr(addr), m_tid(tid), m_is_large(is_large) { }
+
+        bool operator == (const RequestDesc &other) const
+        {
+            return ((other.m_addr == m_addr) && (other.m_is_large == m_is_large) && (other.m_tid == m_tid));
+        }
+
+        friend std::ostream& operator << (std::ostream& out, const RequestDesc &rdesc)
+        {
+            out << std::hex << rdesc.m_addr << std::dec << "|" << rdesc.m_tid << "|" << rdesc.m_is_large << "|";
+            return out;
+        }
+};
+
+class RequestDescHasher {
+    public:
+	std::size_t operator () (const RequestDesc &r) const
+	{
+		using std::size_t;
+		using std::hash;
+
+		size_t res = 42;
+		res = res * 31 + hash<uint64_t>() (r.m_addr);
+	    res = res * 31 + hash<uint64_t>() (r.m_tid);
+		res = res * 31 + hash<bool>() (r.m_is_large);
+		return res;
+	}
+};
+
+//Tracks which cores hold a translation for each page.
+//Pages live in an OpenAddressTable keyed by (page, tid, is_large),
+//each with a sharer bitmap of as many 64 bit words as the core count needs.
+//Pages are also bucketed by number of sharers and by sharing core,
+//so a shootdown victim shared by exactly n cores including a given core is found in constant time.
+class PresenceTracker {
+private:
+    class Slot {
+    public:
+        RequestDesc key;
+        unsigned int num_sharers;
+        bool used;
+
+        Slot() : key(0, 0, false), num_sharers(0), used(false) {}
+    };
+
+    static size_t hash(const RequestDesc &rdesc)
+    {
+        return (size_t) mix_hash(rdesc.m_addr ^ (rdesc.m_tid * 0x9e3779b97f4a7c15ULL) ^ (rdesc.m_is_large ? 0xc2b2ae3d27d4eb4fULL : 0));
+    }
+
+    class SlotHash {
+    public:
+        size_t operator () (const Slot &slot) const { return hash(slot.key); }
+    };
+
+    class SlotIsFree {
+    public:
+        bool operator () (const Slot &slot) const { return !slot.used; }
+    };
+
+    //Position of a page in the bucket of one of its sharers, keyed by slot * m_num_cores + core
+    class PosSlot {
+    public:
+        uint64_t key;
+        uint32_t pos;
+    };
+
+    class PosHash {
+    public:
+        size_t operator () (const PosSlot &slot) const { return (size_t) mix_hash(slot.key); }
+    };
+
+    class PosIsFree {
+    public:
+        bool operator () (const PosSlot &slot) const { return slot.key == NO_KEY; }
+    };
+
+    static const uint32_t NO_SLOT = 0xffffffff;
+    static const uint64_t NO_KEY = 0xffffffffffffffffULL;
+
+    unsigned int m_num_cores;
+    unsigned int m_num_words;
+
+    OpenAddressTable<Slot, SlotHash, SlotIsFree> m_slots;
+    size_t m_size;
+
+    //Per slot: m_num_words words of sharer bitmap
+    std::vector<uint64_t> m_sharers;
+
+    //Bucket positions exist only for the sharers of a page, most pages have few
+    OpenAddressTable<PosSlot, PosHash, PosIsFree> m_pos;
+    size_t m_num_pos;
+
+    //m_buckets[n * m_num_cores + i] lists the slots of pages present on core i and on n cores in total
+    std::vector<std::vector<uint32_t>> m_buckets;
+
+    uint64_t* sharers_of(size_t slot)
+    {
+        return &m_sharers[slot * m_num_words];
+    }
+
+    bool is_sharer(size_t slot, unsigned int core_id)
+    {
+        return (sharers_of(slot)[core_id / 64] >> (core_id % 64)) & 1;
+    }
+
+    std::vector<uint32_t>& bucket(unsigned int num_sharers, unsigned int core_id)
+    {
+        return m_buckets[num_sharers * m_num_cores + core_id];
+    }
+
+    //Slot holding rdesc, claimed for it if absent and insert is set, NO_SLOT otherwise
+    uint32_t probe(const RequestDesc &rdesc, bool insert);
+
+    //Slot of m_pos for the page in slot and core, the free one it would go to if absent
+    size_t find_pos(uint32_t slot, unsigned int core) const
+    {
+        uint64_t key = (uint64_t) slot * m_num_cores + core;
+        return m_pos.find((size_t) mix_hash(key), [key](const PosSlot &pos_slot) { return pos_slot.key == key; });
+    }
+
+    uint32_t get_pos(uint32_t slot, unsigned int core) const
+    {
+        return m_pos[find_pos(slot, core)].pos;
+    }
+
+    void set_pos(uint32_t slot, unsigned int core, uint32_t pos);
+    void erase_pos(uint32_t slot, unsigned int core);
+
+    void bucket_insert(uint32_t slot);
+    void bucket_erase(uint32_t slot);
+    //Moves the sharers and bucket positions of slot from to slot to, which the table already moved the page to
+    void move_slot(uint32_t from, uint32_t to);
+    void grow();
+
+public:
+    PresenceTracker(unsigned int num_cores, size_t initial_capacity = 1024);
+
+    void add(const RequestDesc &rdesc, unsigned int core_id);
+
+    void remove(const RequestDesc &rdesc, unsigned int core_id);
+
+    //Some page present on core_id and on num_cores cores in total, nullptr if there is none
+    //Valid until the next add() or remove()
+    const RequestDesc* find(unsigned int core_id, unsigned int num_cores);
+
+    //Some page present on core_id, nullptr if there is none
+    const RequestDesc* find_any(unsigned int core_id);
+
+    //Cores holding the page, in increasing order
+    std::vector<unsigned int> get_sharers(const RequestDesc &rdesc);
+
+    size_t size()
+    {
+        return m_size;
+    }
+
+    //Bytes held by the table, the sharer bitmaps, the bucket positions and the buckets
+    size_t get_memory_usage();
+};
+
+#endif /* PresenceTracker_hpp */
@@ -7,13 +7,20 @@
 //
 
 #include "ROB.hpp"
+#include "RequestPool.hpp"
 #include <assert.h>
 #include <algorithm>
 
-bool ROB::issue(bool is_memory_access, Request *r, uint64_t clk)
+const uint64_t ROB::MAX_MEM_WAIT;
+
+//Non-memory bursts issue num_instr instructions into one entry.
+//Only the entry issuing the last of a burst owns the request, earlier ones get nullptr.
+bool ROB::issue(bool is_memory_access, Request *r, uint64_t clk, unsigned int num_instr)
 {
+    assert(!is_memory_access || (num_instr == 1));
+
     //Could not issue
-    if(m_num_waiting_instr >= m_window_size)
+    if(m_num_waiting_instr + num_instr > m_window_size)
         return false;
     
     //Can issue
@@ -22,6 +29,7 @@ bool ROB::issue(bool is_memory_access, Request *r, uint64_t clk)
     m_window[m_issue_ptr].req = r;
     m_window[m_issue_ptr].is_memory_access = is_memory_access;
     m_window[m_issue_ptr].clk = clk;
+    m_window[m_issue_ptr].num_instr = num_instr;
     
     if(is_memory_access)
     {
@@ -48,7 +56,7 @@ bool ROB::issue(bool is_memory_access, Request *r, uint64_t clk)
     }
 
     m_issue_ptr = (m_issue_ptr + 1) % m_window_size;
-    m_num_waiting_instr++;
+    m_num_waiting_instr += num_instr;
 
     return true;
 }
@@ -63,15 +71,25 @@ unsigned int ROB::retire(uint64_t clk)
     }
     
     //while(m_window[m_commit_ptr].valid && ((m_window[m_commit_ptr].done) || ((m_window[m_commit_ptr].clk < clk) && (!m_window[m_commit_ptr].is_memory_access))) && (num_retired < m_retire_width))
-    while(m_window[m_commit_ptr].valid && ((m_window[m_commit_ptr].done) || ((m_window[m_commit_ptr].clk + 394) < clk) || ((m_window[m_commit_ptr].clk < clk) && (!m_window[m_commit_ptr].is_memory_access))) && (num_retired < m_retire_width))
+    while(m_window[m_commit_ptr].valid && ((m_window[m_commit_ptr].done) || ((m_window[m_commit_ptr].clk + MAX_MEM_WAIT) <= clk) || ((m_window[m_commit_ptr].clk < clk) && (!m_window[m_commit_ptr].is_memory_access))) && (num_retired < m_retire_width))
     {
+        //Retire as much of the entry as the retire width allows
+        ROBEntry &entry = m_window[m_commit_ptr];
+        unsigned int num_instr = std::min(entry.num_instr, m_retire_width - num_retired);
+        entry.num_instr -= num_instr;
+        m_num_waiting_instr -= num_instr;
+        num_retired += num_instr;
+
+        if(entry.num_instr > 0)
+        {
+            break;
+        }
+
         //Advance commit ptr
-        m_window[m_commit_ptr].valid = false;
-	    delete m_window[m_commit_ptr].req;
-        m_window[m_commit_ptr].req = nullptr;
+        entry.valid = false;
+        RequestPool::release(entry.req);
+        entry.req = nullptr;
         m_commit_ptr = (m_commit_ptr + 1) % m_window_size;
-        m_num_waiting_instr--;
-        num_retired++;
     }
     
     return num_retired;
@@ -81,7 +99,7 @@ void ROB::mem_mark_done(Request &r)
 {
     for(std::vector<ROBEntry>::iterator it = m_window.begin(); it != m_window.end();)
     {
-        if(it->valid && r == *(it->req))
+        if(it->valid && (it->req != nullptr) && r == *(it->req))
         {
             it->done = true;
             it++;
@@ -102,7 +120,7 @@ void ROB::mem_mark_done(Request &r)
 
     for(std::vector<ROBEntry>::iterator it = m_window.begin(); it != m_window.end();)
     {
-        if(it->valid && r == *(it->req))
+        if(it->valid && (it->req != nullptr) && r == *(it->req))
         {
             it->done = true;
             it++;
@@ -132,6 +150,11 @@ bool ROB::can_issue()
     return (m_num_waiting_instr < m_window_size);
 }
 
+unsigned int ROB::num_free_slots()
+{
+    return (m_window_size - m_num_waiting_instr);
+}
+
 void ROB::mem_mark_translation_done(Request &r)
 {
     auto entry = is_request_ready.find(r);
@@ -163,12 +186,40 @@ bool ROB::is_empty()
 	return (m_num_waiting_instr == 0);
 }
 
+//Clock from which the oldest entry retires without any request completing, 0 if it can retire now
+//and UINT64_MAX if the window is empty
+uint64_t ROB::get_next_retire_clk()
+{
+    if(m_num_waiting_instr == 0)
+    {
+        return UINT64_MAX;
+    }
+
+    ROBEntry &entry = m_window[m_commit_ptr];
+    if(entry.done)
+    {
+        return 0;
+    }
+
+    return entry.clk + (entry.is_memory_access ? MAX_MEM_WAIT : 1);
+}
+
 void ROB::peek_commit_ptr()
 {
+	if(m_window[m_commit_ptr].req == nullptr)
+	{
+		std::cout << "Burst at commit ptr, " << m_window[m_commit_ptr].num_instr << " instructions\n";
+		return;
+	}
 	std::cout << "[" << m_window[m_commit_ptr].req << "] Request at commit ptr = " << std::hex << *(m_window[m_commit_ptr].req) << std::dec;
 }
 
 void ROB::peek(unsigned int ptr)
 {
+	if(m_window[ptr].req == nullptr)
+	{
+		std::cout << "Burst at ptr, " << m_window[ptr].num_instr << " instructions\n";
+		return;
+	}
 	std::cout << "[" << m_window[ptr].req << "] Request at ptr = " << std::hex << *(m_window[ptr].req) << std::dec;
 }
@@ -27,12 +27,14 @@ public:
         Request *req;
         bool done;
         uint64_t clk;
+        //Non-memory instructions issued in the same cycle share one entry
+        unsigned int num_instr;
         
-        ROBEntry() : valid(false), is_memory_access(false), done(false), req(nullptr), clk(0) {}
+        ROBEntry() : valid(false), is_memory_access(false), done(false), req(nullptr), clk(0), num_instr(0) {}
         
         friend std::ostream& operator << (std::ostream& out, ROBEntry &r)
         {
-            out << "|" << r.valid << "|" << r.is_memory_access << "|" << r.req << std::dec << "|" << r.done << "|" << std::dec << r.clk << "|" << std::dec << std::endl;
+            out << "|" << r.valid << "|" << r.is_memory_access << "|" << r.req << std::dec << "|" << r.done << "|" << std::dec << r.clk << "|" << r.num_instr << "|" << std::dec << std::endl;
             return out;
         }
     };
@@ -45,6 +47,9 @@ public:
         ReqQueueMetaData() : ready(false), num_occ_in_req_queue(1) {}
     };
     
+    //Cycles after its issue a memory access retires at even if it has not completed
+    static const uint64_t MAX_MEM_WAIT = 395;
+
     std::vector<ROBEntry> m_window;
     unsigned int m_issue_width = 4;
     unsigned int m_retire_width = 4;
@@ -70,14 +75,16 @@ public:
         m_num_waiting_instr = 0;
     }
     
-    bool issue(bool is_memory_access, Request *r, uint64_t clk);
+    bool issue(bool is_memory_access, Request *r, uint64_t clk, unsigned int num_instr = 1);
     bool transfer_to_data_hier(Request &r);
     unsigned int retire(uint64_t clk);
     void mem_mark_done(Request &r);
     void mem_mark_translation_done(Request &r);
     void printContents();
     bool can_issue();
+    unsigned int num_free_slots();
     bool is_empty();
+    uint64_t get_next_retire_clk();
     void peek_commit_ptr();
     void peek(unsigned int ptr);
 };
@@ -9,25 +9,189 @@
 #include "ReplPolicy.hpp"
 #include <assert.h>
 
-unsigned int LRURepl::getVictim(std::vector<CacheLine>& set, uint64_t set_num)
+const uint64_t RRIPRepl::MAX_RRPV;
+const unsigned int RRIPRepl::BRRIP_LONG_INTERVAL;
+
+LRURepl::LRURepl(int num_sets, int associativity) : ReplPolicy(num_sets, associativity)
+{
+    assert(associativity < 0xffff);
+    m_next.resize((size_t) m_num_sets * (m_associativity + 1));
+    m_prev.resize((size_t) m_num_sets * (m_associativity + 1));
+    
+    //Way associativity - 1 starts as MRU and way 0 as LRU
+    for(int i = 0; i < m_num_sets; i++)
+    {
+        size_t base = node(i, 0);
+        for(int j = 0; j <= m_associativity; j++)
+        {
+            m_next[base + j] = (j == 0) ? m_associativity : j - 1;
+            m_prev[base + j] = (j == m_associativity) ? 0 : j + 1;
+        }
+    }
+}
+
+unsigned int LRURepl::getVictim(const TagStore &tags, uint64_t set_num)
+{
+    assert(set_num < m_num_sets);
+    unsigned int not_valid = tags.find_invalid(set_num);
+    
+    if(not_valid != m_associativity)
+    {
+        return not_valid;
+    }
+    
+    return m_prev[node(set_num, m_associativity)];
+}
+
+void LRURepl::updateReplState(uint64_t set_num, int way)
+{
+    assert(set_num < m_num_sets);
+    assert(way < m_associativity);
+    size_t base = node(set_num, 0);
+    size_t sentinel = base + m_associativity;
+    size_t pos = base + way;
+    
+    if(m_next[sentinel] == way)
+    {
+        return;
+    }
+    
+    m_next[base + m_prev[pos]] = m_next[pos];
+    m_prev[base + m_next[pos]] = m_prev[pos];
+    
+    m_next[pos] = m_next[sentinel];
+    m_prev[pos] = m_associativity;
+    m_prev[base + m_next[sentinel]] = way;
+    m_next[sentinel] = way;
+}
+
+void LRURepl::printReplStateArr(uint64_t set_num)
+{
+    size_t base = node(set_num, 0);
+    for(unsigned int way = m_next[base + m_associativity]; way != m_associativity; way = m_next[base + way])
+    {
+        std::cout << way << ", ";
+    }
+    std::cout << std::endl;
+}
+
+size_t LRURepl::get_memory_usage()
+{
+    return m_next.capacity() * sizeof(uint16_t) + m_prev.capacity() * sizeof(uint16_t);
+}
+
+PLRURepl::PLRURepl(int num_sets, int associativity) :
+    ReplPolicy(num_sets, associativity), m_num_leaves(1), m_depth(0), m_tree_bits(num_sets, 1)
+{
+    assert(associativity <= 64);
+    while(m_num_leaves < m_associativity)
+    {
+        m_num_leaves <<= 1;
+        m_depth++;
+    }
+
+    //Inner node n (root 1, children 2n and 2n + 1) is bit n - 1 of the set's field
+    if(m_num_leaves > 1)
+    {
+        m_tree_bits = PackedBitArray(num_sets, m_num_leaves - 1);
+    }
+}
+
+unsigned int PLRURepl::getVictim(const TagStore &tags, uint64_t set_num)
 {
     assert(set_num < m_num_sets);
-    auto it_not_valid = std::find_if(set.begin(), set.end(), [](const CacheLine &l) { return !l.valid;});
+    unsigned int not_valid = tags.find_invalid(set_num);
     
-    if(it_not_valid != set.end())
+    if(not_valid != m_associativity)
     {
-        return (unsigned int)(it_not_valid - set.begin());
+        return not_valid;
     }
     
-    std::vector<ReplState> setReplState = replStateArr[set_num];
+    uint64_t bits = m_tree_bits.get(set_num);
+    unsigned int node = 1;
+    unsigned int first_leaf = 0;
+    
+    for(unsigned int level = 0; level < m_depth; level++)
+    {
+        unsigned int half = m_num_leaves >> (level + 1);
+        //A right subtree past the last way holds no lines
+        bool right = ((bits >> (node - 1)) & 1) && (first_leaf + half < m_associativity);
+        node = 2 * node + right;
+        first_leaf += right ? half : 0;
+    }
+    
+    assert(first_leaf < m_associativity);
+    return first_leaf;
+}
+
+void PLRURepl::updateReplState(uint64_t set_num, int way)
+{
+    assert(set_num < m_num_sets);
+    assert(way < m_associativity);
+    
+    if(m_depth == 0)
+    {
+        return;
+    }
+    
+    uint64_t bits = m_tree_bits.get(set_num);
+    unsigned int node = 1;
+    
+    //Every node on the path points away from the accessed way
+    for(int level = m_depth - 1; level >= 0; level--)
+    {
+        uint64_t went_right = (way >> level) & 1;
+        bits = (bits & ~(1ULL << (node - 1))) | ((went_right ^ 1) << (node - 1));
+        node = 2 * node + went_right;
+    }
+    
+    m_tree_bits.set(set_num, bits);
+}
+
+void PLRURepl::printReplStateArr(uint64_t set_num)
+{
+    uint64_t bits = m_tree_bits.get(set_num);
+    for(unsigned int node = 1; node < m_num_leaves; node++)
+    {
+        std::cout << ((bits >> (node - 1)) & 1);
+    }
+    std::cout << std::endl;
+}
+
+size_t PLRURepl::get_memory_usage()
+{
+    return m_tree_bits.get_memory_usage();
+}
+
+unsigned int RRIPRepl::getVictim(const TagStore &tags, uint64_t set_num)
+{
+    assert(set_num < m_num_sets);
+    unsigned int not_valid = tags.find_invalid(set_num);
+    
+    if(not_valid != m_associativity)
+    {
+        return not_valid;
+    }
+    
+    size_t base = set_num * m_associativity;
+    uint64_t max_rrpv = 0;
+    
+    for(int i = 0; i < m_associativity; i++)
+    {
+        max_rrpv = std::max(max_rrpv, m_rrpv.get(base + i));
+    }
+    
+    //Aging every way until one reaches distant is the same as adding the shortfall of the oldest once
+    uint64_t shortfall = MAX_RRPV - max_rrpv;
     int victim = -1;
     
-    for(int i = 0; i < setReplState.size(); i++)
+    for(int i = 0; i < m_associativity; i++)
     {
-        if(setReplState[i].m_lru_stack_position == (m_associativity - 1))
+        uint64_t rrpv = m_rrpv.get(base + i) + shortfall;
+        m_rrpv.set(base + i, rrpv);
+        if(victim == -1 && rrpv == MAX_RRPV)
         {
             victim = i;
-            break;
         }
     }
     
@@ -35,21 +199,96 @@ unsigned int LRURepl::getVictim(std::vector<CacheLine>& set, uint64_t set_num)
     return victim;
 }
 
-void LRURepl::updateReplState(uint64_t set_num, int way)
+void RRIPRepl::updateReplState(uint64_t set_num, int way)
+{
+    assert(set_num < m_num_sets);
+    assert(way < m_associativity);
+    m_rrpv.set(set_num * m_associativity + way, 0);
+}
+
+void RRIPRepl::insertReplState(uint64_t set_num, int way)
 {
     assert(set_num < m_num_sets);
     assert(way < m_associativity);
-    std::vector<ReplState>& setReplState = replStateArr[set_num];
-    int pivot = setReplState[way].m_lru_stack_position;
     
-    for(int i = 0; i < setReplState.size(); i++)
+    bool distant = m_bimodal && (m_num_fills++ % BRRIP_LONG_INTERVAL != 0);
+    m_rrpv.set(set_num * m_associativity + way, distant ? MAX_RRPV : MAX_RRPV - 1);
+}
+
+void RRIPRepl::printReplStateArr(uint64_t set_num)
+{
+    for(int i = 0; i < m_associativity; i++)
     {
-        if(setReplState[i].m_lru_stack_position < pivot)
-        {
-            setReplState[i].m_lru_stack_position += 1;
-            assert(setReplState[i].m_lru_stack_position <= m_associativity);
-        }
+        std::cout << m_rrpv.get(set_num * m_associativity + i) << ", ";
     }
+    std::cout << std::endl;
+}
+
+size_t RRIPRepl::get_memory_usage()
+{
+    return m_rrpv.get_memory_usage();
+}
+
+unsigned int RandomRepl::getVictim(const TagStore &tags, uint64_t set_num)
+{
+    assert(set_num < m_num_sets);
+    unsigned int not_valid = tags.find_invalid(set_num);
     
-    setReplState[way].m_lru_stack_position = 0;
+    if(not_valid != m_associativity)
+    {
+        return not_valid;
+    }
+    
+    m_rng_state ^= m_rng_state << 13;
+    m_rng_state ^= m_rng_state >> 7;
+    m_rng_state ^= m_rng_state << 17;
+    return (unsigned int) (m_rng_state % m_associativity);
+}
+
+bool parseReplPolicy(const std::string& str, ReplPolicyEnum &pol)
+{
+    if(str == "lru")
+    {
+        pol = LRU_POLICY;
+    }
+    else if(str == "plru")
+    {
+        pol = PLRU_POLICY;
+    }
+    else if(str == "srrip")
+    {
+        pol = SRRIP_POLICY;
+    }
+    else if(str == "brrip")
+    {
+        pol = BRRIP_POLICY;
+    }
+    else if(str == "random")
+    {
+        pol = RANDOM_POLICY;
+    }
+    else
+    {
+        return false;
+    }
+
+    return true;
+}
+
+std::string replPolicyName(ReplPolicyEnum pol)
+{
+    switch(pol)
+    {
+        case PLRU_POLICY:
+            return "plru";
+        case SRRIP_POLICY:
+            return "srrip";
+        case BRRIP_POLICY:
+            return "brrip";
+        case RANDOM_POLICY:
+            return "random";
+        case LRU_POLICY:
+        default:
+            return "lru";
+    }
 }
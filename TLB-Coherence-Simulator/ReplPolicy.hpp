@@ -13,77 +13,171 @@
 #include <vector>
 #include <iterator>
 #include <algorithm>
-#include "CacheLine.h"
+#include <string>
+#include <cstdint>
+#include "TagStore.hpp"
 
-//Placeholder class for replacement state
-//Currently tracks LRU stack position
-//In future, may track more
 enum ReplPolicyEnum {
     LRU_POLICY = 0,
+    PLRU_POLICY,
+    SRRIP_POLICY,
+    BRRIP_POLICY,
+    RANDOM_POLICY,
 };
 
-class ReplState {
+bool parseReplPolicy(const std::string& str, ReplPolicyEnum &pol);
+
+std::string replPolicyName(ReplPolicyEnum pol);
+
+//Fixed width fields of up to 64 bits packed back to back in 64 bit words
+class PackedBitArray {
+private:
+    unsigned int m_width;
+    uint64_t m_mask;
+    std::vector<uint64_t> m_words;
+
 public:
-    int m_lru_stack_position;
-    
-    friend std::ostream& operator << (std::ostream &out, const ReplState &r)
+    PackedBitArray(size_t num_fields, unsigned int width) :
+        m_width(width), m_mask((width == 64) ? ~0ULL : ((1ULL << width) - 1)), m_words((num_fields * width + 63) / 64 + 1, 0) {}
+
+    uint64_t get(size_t i) const
     {
-        out << r.m_lru_stack_position << ", ";
-        return out;
+        size_t bit = i * m_width;
+        size_t word = bit / 64;
+        unsigned int offset = bit % 64;
+        uint64_t val = m_words[word] >> offset;
+        if(offset + m_width > 64)
+        {
+            val |= m_words[word + 1] << (64 - offset);
+        }
+        return val & m_mask;
+    }
+
+    void set(size_t i, uint64_t val)
+    {
+        size_t bit = i * m_width;
+        size_t word = bit / 64;
+        unsigned int offset = bit % 64;
+        val &= m_mask;
+        m_words[word] = (m_words[word] & ~(m_mask << offset)) | (val << offset);
+        if(offset + m_width > 64)
+        {
+            unsigned int spill = 64 - offset;
+            m_words[word + 1] = (m_words[word + 1] & ~(m_mask >> spill)) | (val >> spill);
+        }
+    }
+
+    size_t get_memory_usage() const
+    {
+        return m_words.capacity() * sizeof(uint64_t);
     }
 };
 
 //Interface class for replacement policy
+//Every policy fills invalid ways first, lowest way first
 class ReplPolicy {
 protected:
     int m_num_sets;
     int m_associativity;
-    std::vector<std::vector<ReplState>> replStateArr;
     
 public:
     
     ReplPolicy(int num_sets, int associativity) :
-        m_num_sets(num_sets), m_associativity(associativity)
-    {
-        replStateArr.reserve(m_num_sets);
-        
-        for(int i = 0; i < m_num_sets; i++)
-        {
-            std::vector<ReplState> setReplState;
-            for(int j = 0; j < m_associativity; j++)
-            {
-                setReplState.push_back(ReplState());
-            }
-            replStateArr.push_back(setReplState);
-        }
-    }
+        m_num_sets(num_sets), m_associativity(associativity) {}
     
-    virtual unsigned int getVictim(std::vector<CacheLine>& set, uint64_t set_num) = 0;
+    virtual unsigned int getVictim(const TagStore &tags, uint64_t set_num) = 0;
+    //Called on a hit
     virtual void updateReplState(uint64_t set_num, int way) = 0;
+    //Called when a line is filled into way, policies that insert differently from a hit override it
+    virtual void insertReplState(uint64_t set_num, int way)
+    {
+        updateReplState(set_num, way);
+    }
     virtual void printReplStateArr(uint64_t set_num) = 0;
+    //Bytes of replacement state
+    virtual size_t get_memory_usage() = 0;
     virtual ~ReplPolicy() {}
     
 };
 
 //LRU replacement class
+//Each set keeps its ways in a doubly linked list from MRU to LRU, in flat arrays with one sentinel node per set,
+//so a hit moves a way to the front and a victim is read off the back in constant time.
 class LRURepl : public ReplPolicy {
+private:
+    //Node of way w of set s is s * (associativity + 1) + w, the sentinel is the node after the last way
+    std::vector<uint16_t> m_next;
+    std::vector<uint16_t> m_prev;
+
+    size_t node(uint64_t set_num, unsigned int way) const
+    {
+        return set_num * (m_associativity + 1) + way;
+    }
+
 public:
-    LRURepl(int num_sets, int associativity) : ReplPolicy(num_sets, associativity) {
-        for(auto &elem: replStateArr)
+    LRURepl(int num_sets, int associativity);
+    virtual unsigned int getVictim(const TagStore &tags, uint64_t set_num) override final;
+    virtual void updateReplState(uint64_t set_num, int way) override final;
+    virtual void printReplStateArr(uint64_t set_num) override final;
+    virtual size_t get_memory_usage() override final;
+};
+
+//Tree pseudo-LRU: one bit per inner node of a binary tree over the ways, pointing to the half to evict from.
+//Non power of two associativities use the tree of the next power of two and never walk off the last way.
+class PLRURepl : public ReplPolicy {
+private:
+    unsigned int m_num_leaves;
+    unsigned int m_depth;
+    PackedBitArray m_tree_bits;
+
+public:
+    PLRURepl(int num_sets, int associativity);
+    virtual unsigned int getVictim(const TagStore &tags, uint64_t set_num) override final;
+    virtual void updateReplState(uint64_t set_num, int way) override final;
+    virtual void printReplStateArr(uint64_t set_num) override final;
+    virtual size_t get_memory_usage() override final;
+};
+
+//Re-reference interval prediction with a 2 bit RRPV per way (Jaleel et al., ISCA 2010)
+//Hits predict near re-reference. SRRIP inserts at long, BRRIP at distant and only one fill in 32 at long.
+class RRIPRepl : public ReplPolicy {
+private:
+    static const uint64_t MAX_RRPV = 3;
+    static const unsigned int BRRIP_LONG_INTERVAL = 32;
+
+    bool m_bimodal;
+    unsigned int m_num_fills;
+    PackedBitArray m_rrpv;
+
+public:
+    RRIPRepl(int num_sets, int associativity, bool bimodal) :
+        ReplPolicy(num_sets, associativity), m_bimodal(bimodal), m_num_fills(0), m_rrpv((size_t) num_sets * associativity, 2)
+    {
+        for(size_t i = 0; i < (size_t) num_sets * associativity; i++)
         {
-            for(int i = 0; i < m_associativity; i++)
-            {
-                elem[i].m_lru_stack_position = m_associativity - i - 1;
-            }
+            m_rrpv.set(i, MAX_RRPV);
         }
     }
-    virtual unsigned int getVictim(std::vector<CacheLine>& set, uint64_t set_num) override final;
+    virtual unsigned int getVictim(const TagStore &tags, uint64_t set_num) override final;
     virtual void updateReplState(uint64_t set_num, int way) override final;
-    
-    virtual void printReplStateArr(uint64_t set_num) override final
+    virtual void insertReplState(uint64_t set_num, int way) override final;
+    virtual void printReplStateArr(uint64_t set_num) override final;
+    virtual size_t get_memory_usage() override final;
+};
+
+//Uniformly random victim from a per-cache xorshift generator, so runs stay reproducible
+class RandomRepl : public ReplPolicy {
+private:
+    uint64_t m_rng_state;
+
+public:
+    RandomRepl(int num_sets, int associativity) : ReplPolicy(num_sets, associativity), m_rng_state(0x2545f4914f6cdd1dULL) {}
+    virtual unsigned int getVictim(const TagStore &tags, uint64_t set_num) override final;
+    virtual void updateReplState(uint64_t /*set_num*/, int /*way*/) override final {}
+    virtual void printReplStateArr(uint64_t /*set_num*/) override final {}
+    virtual size_t get_memory_usage() override final
     {
-        std::copy(replStateArr[set_num].begin(), replStateArr[set_num].end(), std::ostream_iterator<ReplState>(std::cout, " "));
-        std::cout << std::endl;
+        return 0;
     }
 };
 
@@ -34,6 +34,10 @@ public:
     bool m_is_large;
     bool m_is_core_agnostic;
     bool m_is_memory_acc;
+    //Non-memory requests stand for a burst of m_num_instr instructions still to be issued.
+    //m_num_avail of them have been handed to the core so far, see TraceProcessor::generateRequest.
+    uint64_t m_num_instr;
+    uint64_t m_num_avail;
     std::function<void(std::shared_ptr<Request>)> m_callback;
     
     
@@ -45,7 +49,9 @@ public:
     m_tid(tid),
     m_is_large(is_large),
     m_is_core_agnostic(false),
-    m_is_memory_acc(is_memory_acc)
+    m_is_memory_acc(is_memory_acc),
+    m_num_instr(1),
+    m_num_avail(1)
     {
         update_request_type(m_type);
     }
@@ -0,0 +1,31 @@
+//
+//  RequestPool.cpp
+//  TLB-Coherence-Simulator
+//
+//  Copyright © 2018 Yashwant Marathe. All rights reserved.
+//
+
+#include "RequestPool.hpp"
+
+RequestPool::~RequestPool()
+{
+    //Requests still queued in cores or ROBs at the end of the run go away with their slab
+    for(int i = 0; i < m_slabs.size(); i++)
+    {
+        delete [] m_slabs[i];
+    }
+}
+
+void RequestPool::grow()
+{
+    Slot *slab = new Slot[SLAB_SIZE];
+    m_slabs.push_back(slab);
+
+    for(int i = 0; i < SLAB_SIZE; i++)
+    {
+        slab[i].owner = this;
+        slab[i].next = (i + 1 < SLAB_SIZE) ? &slab[i + 1] : nullptr;
+    }
+
+    m_free = slab;
+}
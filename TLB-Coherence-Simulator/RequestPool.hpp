@@ -0,0 +1,99 @@
+//
+//  RequestPool.hpp
+//  TLB-Coherence-Simulator
+//
+//  Copyright © 2018 Yashwant Marathe. All rights reserved.
+//
+
+#ifndef RequestPool_hpp
+#define RequestPool_hpp
+
+#include <iostream>
+#include <vector>
+#include <atomic>
+#include <type_traits>
+#include <utility>
+#include "Request.hpp"
+
+//Slab allocator for the Requests handed from TraceProcessor to a core.
+//One pool per core, requests for that core are created from its pool.
+//create() is called by the thread generating requests only and uses a private free list.
+//release() may be called from any thread: it pushes onto a lock-free stack of the owning pool,
+//which create() takes over in one go once the private free list runs dry.
+class RequestPool {
+private:
+    //Request storage comes first, so a Request* is also its Slot*
+    class Slot {
+    public:
+        typename std::aligned_storage<sizeof(Request), alignof(Request)>::type storage;
+        RequestPool *owner;
+        Slot *next;
+    };
+
+    static const size_t SLAB_SIZE = 4096;
+
+    std::vector<Slot*> m_slabs;
+    Slot *m_free;
+    std::atomic<Slot*> m_remote_free;
+
+    void grow();
+
+    Slot* pop()
+    {
+        if(m_free == nullptr)
+        {
+            m_free = m_remote_free.exchange(nullptr, std::memory_order_acquire);
+            if(m_free == nullptr)
+            {
+                grow();
+            }
+        }
+
+        Slot *slot = m_free;
+        m_free = slot->next;
+        return slot;
+    }
+
+    void push_remote(Slot *slot)
+    {
+        Slot *head = m_remote_free.load(std::memory_order_relaxed);
+        do
+        {
+            slot->next = head;
+        } while(!m_remote_free.compare_exchange_weak(head, slot, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+public:
+    RequestPool() : m_free(nullptr), m_remote_free(nullptr) {}
+
+    RequestPool(const RequestPool&) = delete;
+    RequestPool& operator = (const RequestPool&) = delete;
+
+    ~RequestPool();
+
+    template <typename... Args>
+    Request* create(Args&&... args)
+    {
+        return new (&pop()->storage) Request(std::forward<Args>(args)...);
+    }
+
+    //Returns r to the pool it was created from, nullptr is ignored like delete
+    static void release(Request *r)
+    {
+        if(r == nullptr)
+        {
+            return;
+        }
+
+        r->~Request();
+        Slot *slot = reinterpret_cast<Slot*>(r);
+        slot->owner->push_remote(slot);
+    }
+
+    size_t get_num_slabs()
+    {
+        return m_slabs.size();
+    }
+};
+
+#endif /* RequestPool_hpp */
@@ -0,0 +1,207 @@
+//
+//  RequestQueue.cpp
+//  TLB-Coherence-Simulator
+//
+//  Copyright © 2018 Yashwant Marathe. All rights reserved.
+//
+
+#include "RequestQueue.hpp"
+#include <algorithm>
+#include <functional>
+#include <assert.h>
+
+const unsigned int RequestQueue::WHEEL_BITS;
+const uint64_t RequestQueue::WHEEL_SIZE;
+const uint32_t RequestQueue::NO_NODE;
+
+RequestQueue::RequestQueue() : m_cursor(0), m_seq(0), m_size(0), m_num_addrs(0)
+{
+    Slot empty = {NO_NODE, NO_NODE};
+    m_wheel.assign(WHEEL_SIZE, empty);
+
+    AddrSlot empty_addr = {0, NO_NODE};
+    m_addr_index.reset(16, empty_addr);
+}
+
+uint32_t RequestQueue::alloc_node()
+{
+    if(m_free.empty())
+    {
+        m_nodes.push_back(Node());
+        return (uint32_t) (m_nodes.size() - 1);
+    }
+
+    uint32_t n = m_free.back();
+    m_free.pop_back();
+    return n;
+}
+
+void RequestQueue::append(uint32_t n)
+{
+    Slot &slot = m_wheel[m_nodes[n].deadline & (WHEEL_SIZE - 1)];
+    m_nodes[n].next = NO_NODE;
+
+    if(slot.head == NO_NODE)
+    {
+        slot.head = n;
+    }
+    else
+    {
+        m_nodes[slot.tail].next = n;
+    }
+    slot.tail = n;
+}
+
+void RequestQueue::insert(uint64_t deadline, std::shared_ptr<Request> r)
+{
+    uint32_t n = alloc_node();
+    Node &node = m_nodes[n];
+    node.deadline = std::max(deadline, m_cursor);
+    node.seq = m_seq++;
+    node.addr = r->m_addr;
+    node.r = std::move(r);
+
+    if(node.deadline < m_cursor + WHEEL_SIZE)
+    {
+        append(n);
+    }
+    else
+    {
+        m_overflow.push_back(n);
+        std::push_heap(m_overflow.begin(), m_overflow.end(), std::bind(&RequestQueue::overflow_later, this, std::placeholders::_1, std::placeholders::_2));
+    }
+
+    index(n);
+
+    m_size++;
+}
+
+void RequestQueue::index(uint32_t n)
+{
+    //Kept at most half full
+    if(2 * (m_num_addrs + 1) > m_addr_index.capacity())
+    {
+        m_addr_index.grow();
+    }
+
+    Node &node = m_nodes[n];
+    size_t slot = find_slot(node.addr);
+
+    if(m_addr_index[slot].head == NO_NODE)
+    {
+        m_addr_index[slot].addr = node.addr;
+        m_addr_index[slot].head = n;
+        node.addr_next = NO_NODE;
+        m_num_addrs++;
+        return;
+    }
+
+    //Sequence numbers only grow, so the node goes after every node of its address with the same deadline
+    uint32_t *link = &m_addr_index[slot].head;
+    while(*link != NO_NODE && m_nodes[*link].deadline <= node.deadline)
+    {
+        link = &m_nodes[*link].addr_next;
+    }
+
+    node.addr_next = *link;
+    *link = n;
+}
+
+void RequestQueue::unindex(uint32_t n)
+{
+    size_t slot = find_slot(m_nodes[n].addr);
+    assert(m_addr_index[slot].head != NO_NODE);
+
+    uint32_t *link = &m_addr_index[slot].head;
+    while(*link != n)
+    {
+        assert(*link != NO_NODE);
+        link = &m_nodes[*link].addr_next;
+    }
+    *link = m_nodes[n].addr_next;
+
+    if(m_addr_index[slot].head == NO_NODE)
+    {
+        m_addr_index.erase(slot);
+        m_num_addrs--;
+    }
+}
+
+bool RequestQueue::find_addr(uint64_t addr, bool core_agnostic_only, uint64_t &deadline) const
+{
+    for(uint32_t n = m_addr_index[find_slot(addr)].head; n != NO_NODE; n = m_nodes[n].addr_next)
+    {
+        //A request being served may have had its address rewritten on the way up, it no longer counts for addr
+        const Request &r = *m_nodes[n].r;
+        if(r.m_addr == addr && (!core_agnostic_only || r.m_is_core_agnostic))
+        {
+            deadline = m_nodes[n].deadline;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+uint64_t RequestQueue::next_deadline() const
+{
+    //Overflow nodes are all due past the wheel, so the first busy slot holds the earliest request
+    if(m_size > m_overflow.size())
+    {
+        for(uint64_t clk = m_cursor; ; clk++)
+        {
+            if(m_wheel[clk & (WHEEL_SIZE - 1)].head != NO_NODE)
+            {
+                return clk;
+            }
+        }
+    }
+
+    return m_overflow.empty() ? UINT64_MAX : m_nodes[m_overflow.front()].deadline;
+}
+
+void RequestQueue::retire(uint64_t clk)
+{
+    auto later = std::bind(&RequestQueue::overflow_later, this, std::placeholders::_1, std::placeholders::_2);
+
+    while(m_cursor <= clk)
+    {
+        if(m_size == 0)
+        {
+            m_cursor = clk + 1;
+            break;
+        }
+
+        Slot &slot = m_wheel[m_cursor & (WHEEL_SIZE - 1)];
+
+        //Callbacks may queue more requests for this cycle, they are appended and served in this loop
+        while(slot.head != NO_NODE)
+        {
+            uint32_t n = slot.head;
+            slot.head = m_nodes[n].next;
+            if(slot.head == NO_NODE)
+            {
+                slot.tail = NO_NODE;
+            }
+
+            //The node stays indexed while it is served, as the request stays in flight until its callback returns
+            std::shared_ptr<Request> r = m_nodes[n].r;
+            r->m_callback(r);
+
+            unindex(n);
+            m_nodes[n].r.reset();
+            m_free.push_back(n);
+            m_size--;
+        }
+
+        m_cursor++;
+
+        //The slot the wheel turned past now stands for cycle m_cursor + WHEEL_SIZE - 1
+        while(!m_overflow.empty() && m_nodes[m_overflow.front()].deadline < m_cursor + WHEEL_SIZE)
+        {
+            std::pop_heap(m_overflow.begin(), m_overflow.end(), later);
+            append(m_overflow.back());
+            m_overflow.pop_back();
+        }
+    }
+}
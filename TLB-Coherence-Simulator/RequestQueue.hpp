@@ -0,0 +1,119 @@
+//
+//  RequestQueue.hpp
+//  TLB-Coherence-Simulator
+//
+//  Copyright © 2018 Yashwant Marathe. All rights reserved.
+//
+
+#ifndef RequestQueue_hpp
+#define RequestQueue_hpp
+
+#include <iostream>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include "Request.hpp"
+#include "OpenAddressTable.hpp"
+
+//Requests of a CacheSys waiting to be served, by the cycle they are served in.
+//A timing wheel of WHEEL_SIZE one cycle slots holds the requests due within WHEEL_SIZE cycles,
+//later ones wait in an overflow heap and move onto the wheel as it turns.
+//Any number of requests may share a cycle, they are served in the order they were queued.
+//Nodes come from a pool and are reused, so queueing a request allocates nothing in the steady state.
+//Requests are also indexed by address, so a secondary miss finds the in-flight request it waits on
+//without walking the queue. The index is an OpenAddressTable pointing to the first node of each address, the other nodes of the address are chained from it.
+//The table only grows when more addresses are queued at once than ever before.
+class RequestQueue {
+private:
+    static const unsigned int WHEEL_BITS = 10;
+    static const uint64_t WHEEL_SIZE = 1ULL << WHEEL_BITS;
+    static const uint32_t NO_NODE = 0xffffffff;
+
+    class Node {
+    public:
+        std::shared_ptr<Request> r;
+        uint64_t deadline;
+        uint64_t seq;
+        //Address the request was queued with, the index is keyed by it
+        uint64_t addr;
+        uint32_t next;
+        //Next node of the same address, by deadline and then queueing order
+        uint32_t addr_next;
+    };
+
+    class AddrSlot {
+    public:
+        uint64_t addr;
+        uint32_t head;
+    };
+
+    class AddrHash {
+    public:
+        size_t operator () (const AddrSlot &slot) const { return (size_t) mix_hash(slot.addr); }
+    };
+
+    class AddrIsFree {
+    public:
+        bool operator () (const AddrSlot &slot) const { return slot.head == NO_NODE; }
+    };
+
+    class Slot {
+    public:
+        uint32_t head;
+        uint32_t tail;
+    };
+
+    std::vector<Node> m_nodes;
+    std::vector<uint32_t> m_free;
+
+    std::vector<Slot> m_wheel;
+
+    //Min-heap on (deadline, seq) of the nodes due past the wheel
+    std::vector<uint32_t> m_overflow;
+
+    //First cycle not served yet, the wheel covers [m_cursor, m_cursor + WHEEL_SIZE)
+    uint64_t m_cursor;
+    uint64_t m_seq;
+    size_t m_size;
+
+    //First node of every queued address
+    OpenAddressTable<AddrSlot, AddrHash, AddrIsFree> m_addr_index;
+    size_t m_num_addrs;
+
+    uint32_t alloc_node();
+    void append(uint32_t n);
+    void index(uint32_t n);
+    void unindex(uint32_t n);
+
+    size_t find_slot(uint64_t addr) const
+    {
+        return m_addr_index.find((size_t) mix_hash(addr), [addr](const AddrSlot &slot) { return slot.addr == addr; });
+    }
+
+    bool overflow_later(uint32_t a, uint32_t b) const
+    {
+        return (m_nodes[a].deadline != m_nodes[b].deadline) ? (m_nodes[a].deadline > m_nodes[b].deadline) : (m_nodes[a].seq > m_nodes[b].seq);
+    }
+
+public:
+    RequestQueue();
+
+    //Queues r to be served in cycle deadline, or in the next cycle served if deadline has passed
+    void insert(uint64_t deadline, std::shared_ptr<Request> r);
+
+    //Cycle of the earliest queued request for addr, core agnostic ones only if asked
+    bool find_addr(uint64_t addr, bool core_agnostic_only, uint64_t &deadline) const;
+
+    //Serves every request due by clk, cycle by cycle, including ones queued by the callbacks
+    void retire(uint64_t clk);
+
+    //Cycle of the earliest queued request, UINT64_MAX if the queue is empty
+    uint64_t next_deadline() const;
+
+    size_t size() const
+    {
+        return m_size;
+    }
+};
+
+#endif /* RequestQueue_hpp */
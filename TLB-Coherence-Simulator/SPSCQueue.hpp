@@ -0,0 +1,112 @@
+//
+//  SPSCQueue.hpp
+//  TLB-Coherence-Simulator
+//
+//  Copyright © 2018 Yashwant Marathe. All rights reserved.
+//
+
+#ifndef SPSCQueue_hpp
+#define SPSCQueue_hpp
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+//Unbounded lock-free queue for one producer thread and one consumer thread.
+//Items live in fixed size chunks linked in a list, the producer publishes each item by bumping the count of its chunk
+//and links a new chunk when the current one is full. The consumer frees a chunk once it has read past its end,
+//by which time the producer has moved on to the next one.
+template <typename T>
+class SPSCQueue {
+private:
+    static const size_t CHUNK_SIZE = 256;
+
+    class Chunk {
+    public:
+        T items[CHUNK_SIZE];
+        std::atomic<size_t> count;
+        std::atomic<Chunk*> next;
+
+        Chunk() : count(0), next(nullptr) {}
+    };
+
+    //Consumer side
+    Chunk *m_head;
+    size_t m_head_pos;
+
+    //Producer side
+    Chunk *m_tail;
+
+    //Chunk holding the next item to read, nullptr if the queue is empty
+    Chunk* head_chunk()
+    {
+        if(m_head_pos == CHUNK_SIZE)
+        {
+            Chunk *next = m_head->next.load(std::memory_order_acquire);
+            if(next == nullptr)
+            {
+                return nullptr;
+            }
+
+            delete m_head;
+            m_head = next;
+            m_head_pos = 0;
+        }
+
+        return (m_head_pos < m_head->count.load(std::memory_order_acquire)) ? m_head : nullptr;
+    }
+
+public:
+    SPSCQueue() : m_head(new Chunk()), m_head_pos(0)
+    {
+        m_tail = m_head;
+    }
+
+    SPSCQueue(const SPSCQueue&) = delete;
+    SPSCQueue& operator = (const SPSCQueue&) = delete;
+
+    ~SPSCQueue()
+    {
+        while(m_head != nullptr)
+        {
+            Chunk *next = m_head->next.load(std::memory_order_relaxed);
+            delete m_head;
+            m_head = next;
+        }
+    }
+
+    //Producer only
+    void push(T item)
+    {
+        size_t pos = m_tail->count.load(std::memory_order_relaxed);
+
+        if(pos == CHUNK_SIZE)
+        {
+            Chunk *chunk = new Chunk();
+            m_tail->next.store(chunk, std::memory_order_release);
+            m_tail = chunk;
+            pos = 0;
+        }
+
+        m_tail->items[pos] = std::move(item);
+        m_tail->count.store(pos + 1, std::memory_order_release);
+    }
+
+    //Consumer only: oldest item, nullptr if the queue is empty
+    T* front()
+    {
+        Chunk *chunk = head_chunk();
+        return (chunk != nullptr) ? &chunk->items[m_head_pos] : nullptr;
+    }
+
+    //Consumer only: drops the item returned by front()
+    void pop()
+    {
+        m_head->items[m_head_pos++] = T();
+    }
+};
+
+template <typename T>
+const size_t SPSCQueue<T>::CHUNK_SIZE;
+
+#endif /* SPSCQueue_hpp */
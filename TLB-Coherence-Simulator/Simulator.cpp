@@ -0,0 +1,636 @@
+//
+//  Simulator.cpp
+//  TLB-Coherence-Simulator
+//
+//  Copyright © 2018 Yashwant Marathe. All rights reserved.
+//
+
+#include "Simulator.hpp"
+#include "Cache.hpp"
+#include "ParallelSim.hpp"
+#include <algorithm>
+#include <chrono>
+#include <assert.h>
+
+#ifndef NUM_TRACES_PER_CORE
+    #define NUM_TRACES_PER_CORE 1660000000L
+#endif
+#define NUM_INITIAL_FILL 100 
+
+static void printMSHRStats(std::ostream &outFile, const char *name, const Cache &c)
+{
+    outFile << name << " MSHR entries = " << c.get_mshr_capacity() << "\n";
+    outFile << name << " MSHR peak occupancy = " << c.get_mshr_peak_occupancy() << "\n";
+    outFile << name << " MSHR average occupancy = " << ((c.num_mshr_lookups) ? (double) c.mshr_occupancy_sum / c.num_mshr_lookups : 0) << "\n";
+    outFile << name << " MSHR full stalls = " << c.num_mshr_full_stalls << "\n";
+}
+
+//Jumps every core to the first cycle in which one of them can make progress, stopping short of a timeout.
+//Returns the number of cycles skipped, 0 if some core can make progress now.
+//is_input_pending: the main loop still hands out requests, see TraceProcessor::is_pending for the cores they may go to.
+//max_cycles: cycles until something else than the cores has work, e.g. the shared levels of a parallel run.
+static uint64_t skipIdleCycles(std::vector<std::shared_ptr<Core>> &cores, TraceProcessor &tp, bool is_input_pending, uint64_t max_cycles = UINT64_MAX)
+{
+    uint64_t num_cycles = max_cycles;
+
+    for(int i = 0; i < cores.size() && num_cycles > 0; i++)
+    {
+        num_cycles = std::min(num_cycles, cores[i]->cycles_to_next_event(is_input_pending && tp.is_pending(i)));
+
+        //Clock or stall count of a core with a non-empty window grows every cycle
+        if(!cores[i]->m_rob->is_empty())
+        {
+            num_cycles = std::min(num_cycles, (uint64_t) (NUM_TRACES_PER_CORE * 5) - (cores[i]->m_clk + cores[i]->num_stall_cycles));
+        }
+    }
+
+    //Nothing will ever happen, leave it to the main loop
+    if(num_cycles == 0 || num_cycles == UINT64_MAX)
+    {
+        return 0;
+    }
+
+    for(int i = 0; i < cores.size(); i++)
+    {
+        cores[i]->skip_cycles(num_cycles);
+    }
+
+    return num_cycles;
+}
+
+void Simulator::build()
+{
+    unsigned int num_cores = tp.get_num_cores();
+    const HierarchyConfig &hier = tp.hier_config;
+
+    if(tp.is_multicore)
+    {
+        num_total_traces = NUM_TRACES_PER_CORE * num_cores;
+    }
+    else
+    {
+        num_total_traces = NUM_TRACES_PER_CORE;
+    }
+
+    llc = hier.create(LLC_LEVEL);
+    
+    bool ll_interface_complete = false;
+    
+    l3_tlb_small = hier.create(L3_SMALL_TLB_LEVEL);
+    l3_tlb_large = hier.create(L3_LARGE_TLB_LEVEL);
+
+    for(int i = 0; i < num_cores; i++)
+    {
+        data_hier.push_back(std::make_shared<CacheSys>(CacheSys(false, hier.memory_latency, hier.cache_to_cache_latency)));
+        l1_data_caches.push_back(hier.create(L1D_LEVEL));
+        l2_data_caches.push_back(hier.create(L2D_LEVEL));
+        
+        data_hier[i]->add_cache_to_hier(l1_data_caches[i]);
+        data_hier[i]->add_cache_to_hier(l2_data_caches[i]);
+        data_hier[i]->add_cache_to_hier(llc);
+        
+        tlb_hier.push_back(std::make_shared<CacheSys>(CacheSys(true, hier.memory_latency, hier.cache_to_cache_latency)));
+        
+        l1_tlb.push_back(hier.create(L1_SMALL_TLB_LEVEL));
+        l1_tlb.push_back(hier.create(L1_LARGE_TLB_LEVEL));
+        l2_tlb.push_back(hier.create(L2_SMALL_TLB_LEVEL));
+        l2_tlb.push_back(hier.create(L2_LARGE_TLB_LEVEL));
+
+        l1_tlb[2 * i]->add_traceprocessor(&tp);
+        l1_tlb[2 * i + 1]->add_traceprocessor(&tp);
+        l2_tlb[2 * i]->add_traceprocessor(&tp);
+        l2_tlb[2 * i + 1]->add_traceprocessor(&tp);
+       
+        tlb_hier[i]->add_cache_to_hier(l1_tlb[2 * i]);
+        tlb_hier[i]->add_cache_to_hier(l1_tlb[2 * i + 1]);
+        tlb_hier[i]->add_cache_to_hier(l2_tlb[2 * i]);
+        tlb_hier[i]->add_cache_to_hier(l2_tlb[2 * i + 1]);
+        tlb_hier[i]->add_cache_to_hier(l3_tlb_small);
+        tlb_hier[i]->add_cache_to_hier(l3_tlb_large);
+        
+        rob_arr.push_back(std::make_shared<ROB>(ROB()));
+        
+        cores.push_back(std::make_shared<Core>(Core(data_hier[i], tlb_hier[i], rob_arr[i], 0x0, hier.get_l3_small_tlb_size())));
+
+        data_hier[i]->set_core(cores[i]);
+        tlb_hier[i]->set_core(cores[i]);
+        
+        cores[i]->set_core_id(i);
+        cores[i]->set_coherence_scheme(tp.scheme, tp.shootdown_penalty);
+
+        for(int j = 0; j < data_hier[i]->m_caches.size(); j++)
+        {
+            data_hier[i]->m_caches[j]->set_coherence_scheme(tp.scheme);
+        }
+        for(int j = 0; j < tlb_hier[i]->m_caches.size(); j++)
+        {
+            tlb_hier[i]->m_caches[j]->set_coherence_scheme(tp.scheme);
+        }
+        
+        ll_interface_complete = cores[i]->interfaceHier(ll_interface_complete);
+    }
+
+    //Make cores aware of each other
+    for(int i = 0; i < num_cores; i++)
+    {
+        for(int j = 0; j < num_cores; j++)
+        {
+            if(i != j)
+            {
+                cores[i]->add_core(cores[j]);
+            }
+        }
+    }
+    
+    //Make cache hierarchies aware of each other
+    for(int i = 0; i < num_cores; i++)
+    {
+        for(int j = 0; j < num_cores; j++)
+        {
+            if(i != j)
+            {
+                //Data caches see other data caches
+                data_hier[i]->add_cachesys(data_hier[j]);
+
+                //TLB see other data caches
+                tlb_hier[i]->add_cachesys(data_hier[j]);
+            }
+        }
+    }
+
+    for(int i = 0; i < num_cores; i++)
+    {
+        for(int j = 0; j < num_cores; j++)
+        {
+            if(i != j)
+            {
+                //Data caches see other TLBs 
+                data_hier[i]->add_cachesys(tlb_hier[j]);
+            }
+        }
+    }
+
+    for(int i = 0; i < num_cores; i++)
+    {
+        data_hier[i]->set_topology(data_hier, tlb_hier);
+        tlb_hier[i]->set_topology(data_hier, tlb_hier);
+    }
+}
+
+void Simulator::initial_fill()
+{
+    unsigned int num_cores = tp.get_num_cores();
+
+    std::cout << "Initial fill\n";
+    for(int i = 0; i < NUM_INITIAL_FILL; i++)
+    {
+        Request *r = tp.generateRequest();
+
+        //std::cout << "Request = " << std::hex << (*r) << std::dec;
+
+        if((r != nullptr) && r->m_core_id >=0 && r->m_core_id < num_cores)
+        {
+                cores[r->m_core_id]->add_trace(r);
+                num_traces_added += int(r->m_is_memory_acc);
+        } 
+    }
+    std::cout << "Initial fill done\n";
+}
+
+void Simulator::add_trace()
+{
+    unsigned int num_cores = tp.get_num_cores();
+
+    if(is_input_pending())
+    {
+        Request *r = tp.generateRequest();
+
+        //std::cout << "Request = " << std::hex << (*r) << std::dec;
+
+        if((r != nullptr) && r->m_core_id >= 0 && r->m_core_id < num_cores)
+        {
+            if(cores[r->m_core_id]->must_add_trace())
+            {
+                 num_traces_added +=  int(r->m_is_memory_acc);
+
+                 if(r->m_is_memory_acc && (num_traces_added % 1000000 == 0))
+                 {
+                     std::cout << "[NUM_TRACES_ADDED] Count = " << num_traces_added << "\n";
+                 }
+
+                 cores[r->m_core_id]->add_trace(r);
+            }
+            else
+            {
+                 tp.used_up[0] = false;
+            }
+        }
+
+        //if(r != nullptr)
+        //{
+        //    num_traces_added +=  int(r->m_is_memory_acc);
+        //}
+    }
+}
+
+bool Simulator::is_timed_out(int i)
+{
+    if((cores[i]->m_clk + cores[i]->num_stall_cycles) > NUM_TRACES_PER_CORE * 5)
+    {
+        //std::cout << "Core " << i << " timed out " << std::endl;
+        //std::cout << "Blocking request = " ; cores[i]->m_rob->peek_commit_ptr();
+        for(int j = 0; j < cores.size(); j++)
+        {
+            if(cores[j]->traceVec.size())
+            {
+                std::cout << "Core " << j << " has unserviced requests = " << cores[j]->traceVec.size() << "\n";
+            }
+
+            if(!cores[j]->is_done())
+            {
+                std::cout << "Core " << j << " NOT done\n";
+                std::cout << "Blocking request = " ; cores[j]->m_rob->peek_commit_ptr();
+                std::cout << "Core clk = " << cores[j]->m_clk << "\n";
+            }
+
+            if(cores[j]->stall)
+            {
+                std::cout << "Core " << j << " STALLED\n";
+            }
+
+            if(!cores[j]->m_rob->can_issue())
+            {
+                std::cout << "Core " << j << " can't issue\n";
+            }
+        }
+        return true;
+    }
+
+    return false;
+}
+
+void Simulator::run()
+{
+    unsigned int num_cores = tp.get_num_cores();
+    bool done = false;
+    bool timeout = false;
+
+    while(!done && !timeout)
+    {
+        //Cycles in which no core can make progress are not ticked one by one.
+        //Requests are still handed out as the skipped ticks would have, they only queue up behind cores that cannot issue
+        uint64_t num_cycles = skip_idle_cycles ? skipIdleCycles(cores, tp, is_input_pending()) : 0;
+        num_skipped_cycles += num_cycles;
+
+        for(uint64_t k = 0; k < num_cycles * num_cores && is_input_pending(); k++)
+        {
+            add_trace();
+        }
+
+        done = true;
+        for(int i = 0; i < num_cores; i++)
+        {
+            cores[i]->tick();
+
+            add_trace();
+
+            done = done & cores[i]->is_done() && (cores[i]->traceVec.size() == 0);
+            timeout = is_timed_out(i) || timeout;
+        }
+    }
+}
+
+unsigned int Simulator::default_quantum()
+{
+    const HierarchyConfig &hier = tp.hier_config;
+
+    unsigned int data_latency = hier.levels[L1D_LEVEL].latency_cycles + hier.levels[L2D_LEVEL].latency_cycles;
+    unsigned int tlb_latency = std::min(hier.levels[L1_SMALL_TLB_LEVEL].latency_cycles + hier.levels[L2_SMALL_TLB_LEVEL].latency_cycles,
+                                        hier.levels[L1_LARGE_TLB_LEVEL].latency_cycles + hier.levels[L2_LARGE_TLB_LEVEL].latency_cycles) + hier.levels[L2D_LEVEL].latency_cycles;
+
+    return std::max(1U, std::min(data_latency, tlb_latency));
+}
+
+void Simulator::run_parallel(unsigned int num_threads, unsigned int quantum)
+{
+    unsigned int num_cores = tp.get_num_cores();
+    const HierarchyConfig &hier = tp.hier_config;
+
+    //The shared levels get a CacheSys of their own, instead of the one of the last core, which a worker owns
+    m_uncore_data = std::make_shared<CacheSys>(false, hier.memory_latency, hier.cache_to_cache_latency);
+    m_uncore_tlb = std::make_shared<CacheSys>(true, hier.memory_latency, hier.cache_to_cache_latency);
+    m_uncore_data->m_caches = data_hier.back()->m_caches;
+    m_uncore_tlb->m_caches = tlb_hier.back()->m_caches;
+    m_uncore_data->m_core_id = -1;
+    m_uncore_tlb->m_core_id = -1;
+    m_uncore_data->set_topology(data_hier, tlb_hier);
+    m_uncore_tlb->set_topology(data_hier, tlb_hier);
+    m_uncore_data->m_clk = data_hier.back()->m_clk;
+    m_uncore_tlb->m_clk = tlb_hier.back()->m_clk;
+
+    llc->set_cache_sys(m_uncore_data.get());
+    l3_tlb_small->set_cache_sys(m_uncore_tlb.get());
+    l3_tlb_large->set_cache_sys(m_uncore_tlb.get());
+
+    ParallelSim psim(cores, m_uncore_data.get(), m_uncore_tlb.get(), num_threads, quantum);
+
+    auto start = std::chrono::steady_clock::now();
+    double start_cpu = ParallelSim::thread_seconds();
+    bool done = false;
+    bool timeout = false;
+
+    while(!done && !timeout)
+    {
+        //Idle cycles are skipped between quanta, the shared levels have nothing queued at their deadline yet
+        uint64_t num_cycles = skip_idle_cycles ? skipIdleCycles(cores, tp, is_input_pending(), psim.cycles_to_next_event()) : 0;
+        psim.skip_cycles(num_cycles);
+        num_skipped_cycles += num_cycles;
+
+        for(uint64_t k = 0; k < num_cycles * num_cores && is_input_pending(); k++)
+        {
+            add_trace();
+        }
+
+        //Requests of the quantum are handed out up front, as many as the serial loop hands out in as many cycles
+        for(int c = 0; c < quantum; c++)
+        {
+            for(int i = 0; i < num_cores; i++)
+            {
+                add_trace();
+            }
+        }
+
+        psim.run_quantum();
+
+        done = psim.is_done();
+        for(int i = 0; i < num_cores; i++)
+        {
+            done = done & cores[i]->is_done() && (cores[i]->traceVec.size() == 0);
+            timeout = is_timed_out(i) || timeout;
+        }
+    }
+
+    parallel_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    parallel_busy_seconds = (ParallelSim::thread_seconds() - start_cpu) - psim.get_wait_seconds() + psim.get_worker_seconds();
+    parallel_threads = psim.get_num_threads();
+}
+
+void Simulator::reset_stats()
+{
+    for(int i = 0; i < cores.size(); i++)
+    {
+        cores[i]->reset_stats();
+        l1_data_caches[i]->reset_stats();
+        l2_data_caches[i]->reset_stats();
+    }
+
+    for(int i = 0; i < l1_tlb.size(); i++)
+    {
+        l1_tlb[i]->reset_stats();
+        l2_tlb[i]->reset_stats();
+    }
+
+    llc->reset_stats();
+    l3_tlb_small->reset_stats();
+    l3_tlb_large->reset_stats();
+
+    num_skipped_cycles = 0;
+}
+
+void Simulator::merge_stats(const Simulator &other)
+{
+    assert(other.cores.size() == cores.size());
+
+    for(int i = 0; i < cores.size(); i++)
+    {
+        cores[i]->merge_stats(*other.cores[i]);
+        l1_data_caches[i]->merge_stats(*other.l1_data_caches[i]);
+        l2_data_caches[i]->merge_stats(*other.l2_data_caches[i]);
+    }
+
+    for(int i = 0; i < l1_tlb.size(); i++)
+    {
+        l1_tlb[i]->merge_stats(*other.l1_tlb[i]);
+        l2_tlb[i]->merge_stats(*other.l2_tlb[i]);
+    }
+
+    llc->merge_stats(*other.llc);
+    l3_tlb_small->merge_stats(*other.l3_tlb_small);
+    l3_tlb_large->merge_stats(*other.l3_tlb_large);
+
+    num_skipped_cycles += other.num_skipped_cycles;
+}
+
+void Simulator::print_stats(std::ostream &outFile)
+{
+    unsigned int num_cores = tp.get_num_cores();
+
+    uint64_t total_num_cycles = 0;
+    uint64_t total_stall_cycles = 0;
+    uint64_t total_shootdowns = 0;
+    uint64_t total_instructions = 0;
+    uint64_t total_num_data_coh_msgs = 0;
+    uint64_t total_num_tr_coh_msgs = 0;
+    double l1d_agg_mpki = 0;
+    double l2d_agg_mpki = 0;
+    double l1ts_agg_mpki = 0;
+    double l1tl_agg_mpki = 0;
+    double l2ts_agg_mpki = 0;
+    double l2tl_agg_mpki = 0;
+
+    for(int i = 0; i < num_cores;i++)
+    {
+        //cores[i]->m_rob->printContents();
+        //
+        outFile << "--------Core " << i << " -------------" << "\n";
+        if(tp.is_multicore)
+        {
+            outFile << "Cycles = " << cores[i]->get_num_cycles() << "\n";
+            outFile << "Instructions = " << (cores[i]->m_num_retired) << "\n";
+            if(cores[i]->get_num_cycles() > 0)
+            {
+                outFile << "IPC = " << (double) (cores[i]->m_num_retired)/(cores[i]->get_num_cycles()) << "\n";
+            }
+            outFile << "Stall cycles = " << cores[i]->num_stall_cycles << "\n";
+            outFile << "Num shootdowns = " << cores[i]->num_shootdown << "\n";
+            total_instructions = cores[i]->m_num_retired;
+        }
+        else
+        {
+            outFile << "Cycles = " << cores[i]->get_num_cycles() << "\n";
+            outFile << "Instructions = " << (cores[i]->m_num_retired) << "\n";
+            outFile << "Stall cycles = " << cores[i]->num_stall_cycles << "\n";
+            outFile << "Num shootdowns = " << cores[i]->num_shootdown << "\n";
+            total_num_cycles += cores[i]->get_num_cycles();
+            total_stall_cycles += cores[i]->num_stall_cycles;
+            total_shootdowns += cores[i]->num_shootdown;
+            total_instructions += cores[i]->m_num_retired;
+        }
+
+        outFile << "[L1 D$] data hits = " << l1_data_caches[i]->num_data_hits << "\n";
+        outFile << "[L1 D$] translation hits = " << l1_data_caches[i]->num_tr_hits << "\n";
+        outFile << "[L1 D$] data misses = " << l1_data_caches[i]->num_data_misses << "\n";
+        outFile << "[L1 D$] translation misses = " << l1_data_caches[i]->num_tr_misses << "\n";
+        outFile << "[L1 D$] MSHR data hits = " << l1_data_caches[i]->num_mshr_data_hits << "\n";
+        outFile << "[L1 D$] MSHR translation hits = " << l1_data_caches[i]->num_mshr_tr_hits << "\n";
+        printMSHRStats(outFile, "[L1 D$]", *l1_data_caches[i]);
+        outFile << "[L1 D$] data accesses = " << l1_data_caches[i]->num_data_accesses << "\n";
+        outFile << "[L1 D$] translation accesses = " << l1_data_caches[i]->num_tr_accesses << "\n";
+        if(cores[i]->m_num_retired)
+        {
+            double l1d_mpki = (double) (l1_data_caches[i]->num_data_misses * 1000.0)/(cores[i]->m_num_retired);
+            outFile << "[L1 D$] MPKI = " << l1d_mpki << "\n";
+            if(!tp.is_multicore) l1d_agg_mpki += l1d_mpki;
+        }
+
+        outFile << "[L2 D$] data hits = " << l2_data_caches[i]->num_data_hits << "\n";
+        outFile << "[L2 D$] translation hits = " << l2_data_caches[i]->num_tr_hits << "\n";
+        outFile << "[L2 D$] data misses = " << l2_data_caches[i]->num_data_misses << "\n";
+        outFile << "[L2 D$] translation misses = " << l2_data_caches[i]->num_tr_misses << "\n";
+        outFile << "[L2 D$] MSHR data hits = " << l2_data_caches[i]->num_mshr_data_hits << "\n";
+        outFile << "[L2 D$] MSHR translation hits = " << l2_data_caches[i]->num_mshr_tr_hits << "\n";
+        printMSHRStats(outFile, "[L2 D$]", *l2_data_caches[i]);
+        outFile << "[L2 D$] data accesses = " << l2_data_caches[i]->num_data_accesses << "\n";
+        outFile << "[L2 D$] translation accesses = " << l2_data_caches[i]->num_tr_accesses << "\n";
+        if(cores[i]->m_num_retired)
+        {
+            double l2d_mpki = (double) ((l2_data_caches[i]->num_data_misses  + l2_data_caches[i]->num_tr_misses)* 1000.0)/(cores[i]->m_num_retired);
+            outFile << "[L2 D$] MPKI = " << l2d_mpki << "\n";
+            if(!tp.is_multicore) l2d_agg_mpki += l2d_mpki;
+        }
+
+        outFile << "[L1 SMALL TLB] data hits = " << l1_tlb[2 * i]->num_data_hits << "\n";
+        outFile << "[L1 SMALL TLB] translation hits = " << l1_tlb[2 * i]->num_tr_hits << "\n";
+        outFile << "[L1 SMALL TLB] data misses = " << l1_tlb[2 * i]->num_data_misses << "\n";
+        outFile << "[L1 SMALL TLB] translation misses = " << l1_tlb[2 * i]->num_tr_misses << "\n";
+        outFile << "[L1 SMALL TLB] MSHR data hits = " << l1_tlb[2 * i]->num_mshr_data_hits << "\n";
+        outFile << "[L1 SMALL TLB] MSHR translation hits = " << l1_tlb[2 * i]->num_mshr_tr_hits << "\n";
+        printMSHRStats(outFile, "[L1 SMALL TLB]", *l1_tlb[2 * i]);
+        outFile << "[L1 SMALL TLB] data accesses = " << l1_tlb[2 * i]->num_data_accesses << "\n";
+        outFile << "[L1 SMALL TLB] translation accesses = " << l1_tlb[2 * i]->num_tr_accesses << "\n";
+        if(cores[i]->m_num_retired)
+        {
+            double l1ts_mpki = (double) ((l1_tlb[2 * i]->num_data_misses  + l1_tlb[2 * i]->num_tr_misses)* 1000.0)/(cores[i]->m_num_retired);
+            outFile << "[L1 SMALL TLB] MPKI = " << l1ts_mpki << "\n";
+            if(!tp.is_multicore) l1ts_agg_mpki += l1ts_mpki;
+        }
+
+        total_num_data_coh_msgs += l1_tlb[2 * i]->num_data_coh_msgs;
+        total_num_tr_coh_msgs += l1_tlb[2 * i]->num_tr_coh_msgs;
+
+        outFile << "[L1 LARGE TLB] data hits = " << l1_tlb[2 * i + 1]->num_data_hits << "\n";
+        outFile << "[L1 LARGE TLB] translation hits = " << l1_tlb[2 * i + 1]->num_tr_hits << "\n";
+        outFile << "[L1 LARGE TLB] data misses = " << l1_tlb[2 * i + 1]->num_data_misses << "\n";
+        outFile << "[L1 LARGE TLB] translation misses = " << l1_tlb[2 * i + 1]->num_tr_misses << "\n";
+        outFile << "[L1 LARGE TLB] MSHR data hits = " << l1_tlb[2 * i + 1]->num_mshr_data_hits << "\n";
+        outFile << "[L1 LARGE TLB] MSHR translation hits = " << l1_tlb[2 * i + 1]->num_mshr_tr_hits << "\n";
+        printMSHRStats(outFile, "[L1 LARGE TLB]", *l1_tlb[2 * i + 1]);
+        outFile << "[L1 LARGE TLB] data accesses = " << l1_tlb[2 * i + 1]->num_data_accesses << "\n";
+        outFile << "[L1 LARGE TLB] translation accesses = " << l1_tlb[2 * i + 1]->num_tr_accesses << "\n";
+        if(cores[i]->m_num_retired)
+        {
+            double l1tl_mpki = (double) ((l1_tlb[2 * i + 1]->num_data_misses  + l1_tlb[2 * i + 1]->num_tr_misses)* 1000.0)/(cores[i]->m_num_retired);
+            outFile << "[L1 LARGE TLB] MPKI = " << l1tl_mpki << "\n";
+            if(!tp.is_multicore) l1tl_agg_mpki += l1tl_mpki;
+        }
+
+        outFile << "[L2 SMALL TLB] data hits = " << l2_tlb[2 * i]->num_data_hits << "\n";
+        outFile << "[L2 SMALL TLB] translation hits = " << l2_tlb[2 * i]->num_tr_hits << "\n";
+        outFile << "[L2 SMALL TLB] data misses = " << l2_tlb[2 * i]->num_data_misses << "\n";
+        outFile << "[L2 SMALL TLB] translation misses = " << l2_tlb[2 * i]->num_tr_misses << "\n";
+        outFile << "[L2 SMALL TLB] MSHR data hits = " << l2_tlb[2 * i]->num_mshr_data_hits << "\n";
+        outFile << "[L2 SMALL TLB] MSHR translation hits = " << l2_tlb[2 * i]->num_mshr_tr_hits << "\n";
+        printMSHRStats(outFile, "[L2 SMALL TLB]", *l2_tlb[2 * i]);
+        outFile << "[L2 SMALL TLB] data accesses = " << l2_tlb[2 * i]->num_data_accesses << "\n";
+        outFile << "[L2 SMALL TLB] translation accesses = " << l2_tlb[2 * i]->num_tr_accesses << "\n";
+        if(cores[i]->m_num_retired)
+        {
+            double l2ts_mpki = (double) ((l2_tlb[2 * i]->num_data_misses  + l2_tlb[2 * i]->num_tr_misses)* 1000.0)/(cores[i]->m_num_retired);
+            outFile << "[L2 SMALL TLB] MPKI = " << l2ts_mpki << "\n";
+            if(!tp.is_multicore) l2ts_agg_mpki += l2ts_mpki;
+        }
+
+        outFile << "[L2 LARGE TLB] data hits = " << l2_tlb[2 * i + 1]->num_data_hits << "\n";
+        outFile << "[L2 LARGE TLB] translation hits = " << l2_tlb[2 * i + 1]->num_tr_hits << "\n";
+        outFile << "[L2 LARGE TLB] data misses = " << l2_tlb[2 * i + 1]->num_data_misses << "\n";
+        outFile << "[L2 LARGE TLB] translation misses = " << l2_tlb[2 * i + 1]->num_tr_misses << "\n";
+        outFile << "[L2 LARGE TLB] MSHR data hits = " << l2_tlb[2 * i + 1]->num_mshr_data_hits << "\n";
+        outFile << "[L2 LARGE TLB] MSHR translation hits = " << l2_tlb[2 * i + 1]->num_mshr_tr_hits << "\n";
+        printMSHRStats(outFile, "[L2 LARGE TLB]", *l2_tlb[2 * i + 1]);
+        outFile << "[L2 LARGE TLB] data accesses = " << l2_tlb[2 * i + 1]->num_data_accesses << "\n";
+        outFile << "[L2 LARGE TLB] translation accesses = " << l2_tlb[2 * i + 1]->num_tr_accesses << "\n";
+        if(cores[i]->m_num_retired)
+        {
+            double l2tl_mpki = (double) ((l2_tlb[2 * i + 1]->num_data_misses  + l2_tlb[2 * i + 1]->num_tr_misses)* 1000.0)/(cores[i]->m_num_retired);
+            outFile << "[L2 LARGE TLB] MPKI = " << l2tl_mpki << "\n";
+            if(!tp.is_multicore) l2tl_agg_mpki += l2tl_mpki;
+        }
+    }
+
+    outFile << "----------------------------------------------------------------------\n";
+
+    if(!tp.is_multicore)
+    {
+        outFile << "Cycles = " << total_num_cycles << "\n";
+        outFile << "Instructions = " << (total_instructions) << "\n";
+        if(total_num_cycles > 0)
+        {
+            outFile << "IPC = " << (double) (total_instructions)/(total_num_cycles + total_stall_cycles) << "\n";
+        }
+        outFile << "Stall cycles = " << total_stall_cycles << "\n";
+        outFile << "Num shootdowns = " << total_shootdowns << "\n";
+        outFile << "[L1 D$] Aggregate MPKI = " << l1d_agg_mpki << "\n";
+        outFile << "[L2 D$] Aggregate MPKI = " << l2d_agg_mpki << "\n";
+        outFile << "[L1 SMALL TLB] Aggregate MPKI = " << l1ts_agg_mpki << "\n";
+        outFile << "[L1 LARGE TLB] Aggregate MPKI = " << l1tl_agg_mpki << "\n";
+        outFile << "[L2 SMALL TLB] Aggregate MPKI = " << l2ts_agg_mpki << "\n";
+        outFile << "[L2 LARGE TLB] Aggregate MPKI = " << l2tl_agg_mpki << "\n";
+    }
+
+    outFile << "----------------------------------------------------------------------\n";
+    outFile << "[AGGREGATE] Number of data coherence messages = " << total_num_data_coh_msgs << "\n";
+    outFile << "[AGGREGATE] Number of translation coherence messages = " << total_num_tr_coh_msgs << "\n";
+    outFile << "[L3] data hits = " << llc->num_data_hits << "\n";
+    outFile << "[L3] translation hits = " << llc->num_tr_hits << "\n";
+    outFile << "[L3] data misses = " << llc->num_data_misses << "\n";
+    outFile << "[L3] translation misses = " << llc->num_tr_misses << "\n";
+    outFile << "[L3] MSHR data hits = " << llc->num_mshr_data_hits << "\n";
+    outFile << "[L3] MSHR translation hits = " << llc->num_mshr_tr_hits << "\n";
+    printMSHRStats(outFile, "[L3]", *llc);
+    outFile << "[L3] data accesses = " << llc->num_data_accesses << "\n";
+    outFile << "[L3] translation accesses = " << llc->num_tr_accesses << "\n";
+    if(total_instructions)
+    {
+        outFile << "[L3] MPKI = " << (double) ((llc->num_data_misses  + llc->num_tr_misses)* 1000.0)/(total_instructions) << "\n";
+    }
+
+    outFile << "[L3 SMALL TLB] data hits = " << l3_tlb_small->num_data_hits << "\n";
+    outFile << "[L3 SMALL TLB] translation hits = " << l3_tlb_small->num_tr_hits << "\n";
+    outFile << "[L3 SMALL TLB] data misses = " << l3_tlb_small->num_data_misses << "\n";
+    outFile << "[L3 SMALL TLB] translation misses = " << l3_tlb_small->num_tr_misses << "\n";
+    outFile << "[L3 SMALL TLB] MSHR data hits = " << l3_tlb_small->num_mshr_data_hits << "\n";
+    outFile << "[L3 SMALL TLB] MSHR translation hits = " << l3_tlb_small->num_mshr_tr_hits << "\n";
+    printMSHRStats(outFile, "[L3 SMALL TLB]", *l3_tlb_small);
+    outFile << "[L3 SMALL TLB] data accesses = " << l3_tlb_small->num_data_accesses << "\n";
+    outFile << "[L3 SMALL TLB] translation accesses = " << l3_tlb_small->num_tr_accesses << "\n";
+    if(total_instructions)
+    {
+        outFile << "[L3 SMALL TLB] MPKI = " << (double) (l3_tlb_small->num_tr_misses * 1000.0)/(total_instructions) << "\n";
+    }
+
+    outFile << "[L3 LARGE TLB] data hits = " << l3_tlb_large->num_data_hits << "\n";
+    outFile << "[L3 LARGE TLB] translation hits = " << l3_tlb_large->num_tr_hits << "\n";
+    outFile << "[L3 LARGE TLB] data misses = " << l3_tlb_large->num_data_misses << "\n";
+    outFile << "[L3 LARGE TLB] translation misses = " << l3_tlb_large->num_tr_misses << "\n";
+    outFile << "[L3 LARGE TLB] MSHR data hits = " << l3_tlb_large->num_mshr_data_hits << "\n";
+    outFile << "[L3 LARGE TLB] MSHR translation hits = " << l3_tlb_large->num_mshr_tr_hits << "\n";
+    printMSHRStats(outFile, "[L3 LARGE TLB]", *l3_tlb_large);
+    outFile << "[L3 LARGE TLB] data accesses = " << l3_tlb_large->num_data_accesses << "\n";
+    outFile << "[L3 LARGE TLB] translation accesses = " << l3_tlb_large->num_tr_accesses << "\n";
+    if(total_instructions)
+    {
+        outFile << "[L3 LARGE TLB] MPKI = " << (double) (l3_tlb_large->num_tr_misses * 1000.0)/(total_instructions) << "\n";
+    }
+
+    outFile << "----------------------------------------------------------------------\n";
+}
@@ -0,0 +1,95 @@
+//
+//  Simulator.hpp
+//  TLB-Coherence-Simulator
+//
+//  Copyright © 2018 Yashwant Marathe. All rights reserved.
+//
+
+#ifndef Simulator_hpp
+#define Simulator_hpp
+
+#include <iostream>
+#include <vector>
+#include <memory>
+#include "CacheSys.hpp"
+#include "ROB.hpp"
+#include "Core.hpp"
+#include "TraceProcessor.hpp"
+
+//One simulated system: the trace processor, the cores and their cache and TLB hierarchies.
+//Set up tp (config, command line overrides, trace files), then build(), initial_fill(), run() or run_parallel() and print_stats().
+class Simulator {
+private:
+    //CacheSys of the LLC and of the L3 TLBs in a parallel run, see run_parallel
+    std::shared_ptr<CacheSys> m_uncore_data;
+    std::shared_ptr<CacheSys> m_uncore_tlb;
+
+    //Hands out the next request, as the main loop does after every core tick
+    void add_trace();
+
+    //Whether add_trace may still hand out requests
+    bool is_input_pending()
+    {
+        return (num_traces_added < num_total_traces) && !tp.is_exhausted();
+    }
+
+    //Whether core i ran out of cycles, printing what holds up every core if so
+    bool is_timed_out(int i);
+
+public:
+    TraceProcessor tp;
+
+    std::shared_ptr<Cache> llc;
+    std::shared_ptr<Cache> l3_tlb_small;
+    std::shared_ptr<Cache> l3_tlb_large;
+
+    std::vector<std::shared_ptr<CacheSys>> data_hier;
+    std::vector<std::shared_ptr<CacheSys>> tlb_hier;
+    std::vector<std::shared_ptr<Cache>> l1_data_caches;
+    std::vector<std::shared_ptr<Cache>> l2_data_caches;
+
+    std::vector<std::shared_ptr<Cache>> l1_tlb;
+    std::vector<std::shared_ptr<Cache>> l2_tlb;
+
+    std::vector<std::shared_ptr<ROB>> rob_arr;
+
+    std::vector<std::shared_ptr<Core>> cores;
+
+    uint64_t num_traces_added = 0;
+    uint64_t num_total_traces = 0;
+    //Whether run and run_parallel jump over cycles in which no core can make progress, see -bench skip
+    bool skip_idle_cycles = true;
+    uint64_t num_skipped_cycles = 0;
+    //Wall time of run_parallel, the CPU time its threads spent on the simulation outside the barrier, summed,
+    //and the number of threads: the utilization of the threads, not the speedup over run, see -bench parallel
+    double parallel_seconds = 0;
+    double parallel_busy_seconds = 0;
+    unsigned int parallel_threads = 0;
+
+    //own_rng: for a Simulator run next to others, see TraceProcessor
+    explicit Simulator(bool own_rng = false) : tp(8, own_rng) {}
+
+    //Creates the hierarchy of tp.hier_config for every core of the trace
+    void build();
+
+    void initial_fill();
+
+    //Ticks the cores one after the other until all are done or one times out
+    void run();
+
+    //Same with the cores on num_threads worker threads, synchronized every quantum cycles, see ParallelSim
+    void run_parallel(unsigned int num_threads, unsigned int quantum);
+
+    //Cycles a request needs at the least to get from a core to the shared levels: the lookahead of run_parallel
+    unsigned int default_quantum();
+
+    //Zeroes the counters of every core and cache, e.g. once the caches are warm
+    void reset_stats();
+
+    //Adds the counters of other, a run of the same config over another part of the trace
+    void merge_stats(const Simulator &other);
+
+    void print_stats(std::ostream &outFile);
+};
+
+#endif /* Simulator_hpp */
@@ -0,0 +1,106 @@
+//
+//  SweepSim.cpp
+//  TLB-Coherence-Simulator
+//
+//  Copyright © 2018 Yashwant Marathe. All rights reserved.
+//
+
+#include "SweepSim.hpp"
+#include <fstream>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <assert.h>
+
+SweepSim::SweepSim(const std::vector<std::string> &configs) : m_configs(configs), m_next(0)
+{
+    for(int k = 0; k < m_configs.size(); k++)
+    {
+        m_sims.emplace_back(new Simulator(true));
+        m_sims[k]->tp.parseAndSetupInputs(&m_configs[k][0]);
+        m_sims[k]->tp.load_traces(m_traces);
+    }
+}
+
+static std::string configName(const std::string &config)
+{
+    std::string name = config;
+
+    size_t pos = name.find_last_of('/');
+    if(pos != std::string::npos)
+    {
+        name = name.substr(pos + 1);
+    }
+
+    pos = name.find_last_of('.');
+    if(pos != std::string::npos && pos > 0)
+    {
+        name = name.substr(0, pos);
+    }
+
+    return name;
+}
+
+std::string SweepSim::get_out_name(unsigned int k)
+{
+    TraceProcessor &tp = m_sims[k]->tp;
+    std::string name = tp.benchmark + "_" + schemeName(tp.scheme) + "_" + configName(m_configs[k]);
+
+    //Configs of the same name in different directories, or the same config given twice, would write to the same file
+    for(unsigned int j = 0; j < m_configs.size(); j++)
+    {
+        TraceProcessor &other_tp = m_sims[j]->tp;
+        if(j != k && other_tp.benchmark == tp.benchmark && other_tp.scheme == tp.scheme && configName(m_configs[j]) == configName(m_configs[k]))
+        {
+            name += "_" + std::to_string(k);
+            break;
+        }
+    }
+
+    return name + ".out";
+}
+
+void SweepSim::run_config(unsigned int k)
+{
+    Simulator &sim = *m_sims[k];
+
+    sim.tp.verifyOpenTraceFiles();
+    sim.build();
+    sim.initial_fill();
+
+    auto start = std::chrono::steady_clock::now();
+    sim.run();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::string out_name = get_out_name(k);
+    std::ofstream outFile(out_name);
+    sim.print_stats(outFile);
+    outFile.close();
+
+    std::cout << "[SWEEP] " << m_configs[k] << " -> " << out_name << ", seconds = " << seconds << "\n";
+}
+
+void SweepSim::work()
+{
+    for(unsigned int k = m_next++; k < m_sims.size(); k = m_next++)
+    {
+        run_config(k);
+    }
+}
+
+void SweepSim::run(unsigned int num_threads)
+{
+    assert(num_threads > 0);
+
+    std::vector<std::thread> workers;
+
+    for(int i = 0; i < std::min(num_threads, (unsigned int) m_sims.size()); i++)
+    {
+        workers.emplace_back(&SweepSim::work, this);
+    }
+
+    for(int i = 0; i < workers.size(); i++)
+    {
+        workers[i].join();
+    }
+}
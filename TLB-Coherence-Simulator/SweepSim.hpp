@@ -0,0 +1,53 @@
+//
+//  SweepSim.hpp
+//  TLB-Coherence-Simulator
+//
+//  Copyright © 2018 Yashwant Marathe. All rights reserved.
+//
+
+#ifndef SweepSim_hpp
+#define SweepSim_hpp
+
+#include <iostream>
+#include <vector>
+#include <memory>
+#include <string>
+#include <atomic>
+#include "Simulator.hpp"
+#include "TraceBuffer.hpp"
+
+//Runs several configs over the same traces at once, see main.cpp -sweep.
+//Traces are read and decoded once into a TraceBuffer, every config then walks them from memory in a Simulator of its own.
+//Worker threads take the configs one after the other, each writes the stats of its config to a file of its own.
+//Memory holds the decoded traces once, and the model of every config.
+class SweepSim {
+private:
+    std::vector<std::string> m_configs;
+    std::vector<std::unique_ptr<Simulator>> m_sims;
+    TraceBuffer m_traces;
+
+    //Next config for a worker to take
+    std::atomic<unsigned int> m_next;
+
+    void work();
+
+    void run_config(unsigned int k);
+
+public:
+    //Parses the configs and reads their traces into memory
+    SweepSim(const std::vector<std::string> &configs);
+
+    //Runs every config, on up to num_threads threads
+    void run(unsigned int num_threads);
+
+    //Stats file of config k: <benchmark>_<scheme>_<config name>.out,
+    //<benchmark>_<scheme>_<config name>_<k>.out if another config of the sweep would get the same name
+    std::string get_out_name(unsigned int k);
+
+    const TraceBuffer& get_traces()
+    {
+        return m_traces;
+    }
+};
+
+#endif /* SweepSim_hpp */
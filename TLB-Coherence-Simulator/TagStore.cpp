@@ -0,0 +1,207 @@
+//
+//  TagStore.cpp
+//  TLB-Coherence-Simulator
+//
+//  Copyright © 2018 Yashwant Marathe. All rights reserved.
+//
+
+#include "TagStore.hpp"
+#include <cstring>
+#include <assert.h>
+
+#ifdef TAG_MATCH_AVX2
+#include <immintrin.h>
+#endif
+
+const uint8_t TagStore::VALID;
+const uint8_t TagStore::DIRTY;
+const uint8_t TagStore::LOCK;
+const uint8_t TagStore::TRANSLATION;
+const uint8_t TagStore::LARGE;
+const unsigned int TagStore::SIMD_MIN_WAYS;
+const unsigned int TagStore::STATE_SHIFT;
+const uint8_t TagStore::FLAG_MASK;
+const uint32_t TagStore::NO_POS;
+
+TagStore::TagStore(unsigned int num_sets, unsigned int associativity) : m_num_sets(num_sets), m_associativity(associativity)
+{
+    size_t num_lines = (size_t) m_num_sets * m_associativity;
+
+    m_tags.assign(num_lines, 0);
+    m_tids.assign(num_lines, 0);
+    m_cotags.assign(num_lines, 0);
+    m_bits.assign(num_lines, INVALID << STATE_SHIFT);
+
+    if(m_associativity <= 64)
+    {
+        m_valid_ways.assign(m_num_sets, 0);
+    }
+
+    set_use_simd(m_associativity >= SIMD_MIN_WAYS);
+}
+
+bool TagStore::simd_supported()
+{
+#ifdef TAG_MATCH_AVX2
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    return avx2;
+#else
+    return false;
+#endif
+}
+
+#ifdef TAG_MATCH_AVX2
+//Tags are compared four ways per step and only ways with an equal tag have their flags and tid checked.
+//Equal tags are rare outside the matching way, so a lookup mostly reads the tag array alone.
+__attribute__((target("avx2")))
+unsigned int TagStore::find_avx2(uint64_t set, uint64_t tag, bool is_translation, uint64_t tid) const
+{
+    size_t base = set * m_associativity;
+    const uint64_t *tags = &m_tags[base];
+    __m256i vtag = _mm256_set1_epi64x(tag);
+
+    unsigned int way = 0;
+    for(; way + 4 <= m_associativity; way += 4)
+    {
+        __m256i eq = _mm256_cmpeq_epi64(_mm256_loadu_si256((const __m256i*) (tags + way)), vtag);
+
+        for(int mask = _mm256_movemask_pd(_mm256_castsi256_pd(eq)); mask != 0; mask &= (mask - 1))
+        {
+            unsigned int candidate = way + __builtin_ctz(mask);
+            if(matches(base + candidate, tag, is_translation, tid))
+            {
+                return candidate;
+            }
+        }
+    }
+
+    for(; way < m_associativity; way++)
+    {
+        if(matches(base + way, tag, is_translation, tid))
+        {
+            return way;
+        }
+    }
+
+    return m_associativity;
+}
+#endif
+
+void TagStore::enable_cotag_index()
+{
+    if(m_cotag_index.capacity() > 0)
+    {
+        return;
+    }
+
+    CotagSlot empty = {0, 0, NO_POS};
+    m_cotag_index.reset(2 * m_tags.size(), empty);
+
+    for(size_t pos = 0; pos < m_tags.size(); pos++)
+    {
+        index(pos);
+    }
+}
+
+void TagStore::cotag_insert(size_t pos)
+{
+    //Lines of the same (co-tag, tid) are all kept, the new one goes to the end of the probe run
+    size_t i = m_cotag_index.find(cotag_hash(m_cotags[pos], m_tids[pos]), [](const CotagSlot &) { return false; });
+
+    m_cotag_index[i].cotag = m_cotags[pos];
+    m_cotag_index[i].tid = m_tids[pos];
+    m_cotag_index[i].pos = (uint32_t) pos;
+}
+
+void TagStore::cotag_erase(size_t pos)
+{
+    size_t hole = m_cotag_index.find(cotag_hash(m_cotags[pos], m_tids[pos]), [pos](const CotagSlot &slot) { return slot.pos == pos; });
+    assert(m_cotag_index[hole].pos == pos);
+
+    m_cotag_index.erase(hole);
+}
+
+bool TagStore::find_by_cotag(uint64_t cotag, uint64_t tid, unsigned int &set, unsigned int &way) const
+{
+    size_t found = NO_POS;
+
+    if(m_cotag_index.capacity() > 0)
+    {
+        //The same translation may sit in more than one way, the whole probe run is checked
+        for(size_t i = m_cotag_index.home(cotag_hash(cotag, tid)); !m_cotag_index.is_free(i); i = m_cotag_index.next(i))
+        {
+            if(m_cotag_index[i].cotag == cotag && m_cotag_index[i].tid == tid && m_cotag_index[i].pos < found)
+            {
+                found = m_cotag_index[i].pos;
+            }
+        }
+    }
+    else
+    {
+        for(size_t i = 0; i < m_cotags.size(); i++)
+        {
+            if(m_cotags[i] == cotag && m_tids[i] == tid && (m_bits[i] & VALID))
+            {
+                found = i;
+                break;
+            }
+        }
+    }
+
+    if(found == NO_POS)
+    {
+        return false;
+    }
+
+    set = (unsigned int) (found / m_associativity);
+    way = (unsigned int) (found % m_associativity);
+    return true;
+}
+
+size_t TagStore::get_memory_usage() const
+{
+    return m_tags.capacity() * sizeof(uint64_t) + m_tids.capacity() * sizeof(uint64_t) + m_cotags.capacity() * sizeof(uint64_t) + m_bits.capacity() * sizeof(uint8_t) + m_cotag_index.get_memory_usage() + m_valid_ways.capacity() * sizeof(uint64_t);
+}
+
+void TagStore::print_set(std::ostream &out, uint64_t set)
+{
+    for(unsigned int way = 0; way < m_associativity; way++)
+    {
+        out << line(set, way);
+    }
+}
+
+std::ostream& operator << (std::ostream &out, const TagStore::Line &l)
+{
+    switch(l.get_coherence_state())
+    {
+        case MODIFIED:
+            out << "|M|";
+            break;
+        case OWNER:
+            out << "|O|";
+            break;
+        case EXCLUSIVE:
+            out << "|E|";
+            break;
+        case SHARED:
+            out << "|S|";
+            break;
+        case INVALID:
+            out << "|I|";
+            break;
+    }
+
+    out << "|" << l.is_valid() << "|" << l.is_dirty() << "|" << l.is_locked() << "|" << l.is_translation() << "|" << std::hex << l.tag();
+
+    if(l.is_translation())
+    {
+        out << "|" << l.cotag() << "| --";
+    }
+    else
+    {
+        out << "| -- ";
+    }
+
+    return out;
+}
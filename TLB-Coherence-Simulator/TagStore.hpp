@@ -0,0 +1,299 @@
+//
+//  TagStore.hpp
+//  TLB-Coherence-Simulator
+//
+//  Copyright © 2018 Yashwant Marathe. All rights reserved.
+//
+
+#ifndef TagStore_hpp
+#define TagStore_hpp
+
+#include <iostream>
+#include <vector>
+#include <cstdint>
+#include "utils.hpp"
+#include "OpenAddressTable.hpp"
+
+//Tag match compares four ways per AVX2 instruction where the CPU has it, unless built with -DNO_SIMD_TAG_MATCH
+#if (defined(__x86_64__) || defined(__i386__)) && !defined(NO_SIMD_TAG_MATCH)
+#define TAG_MATCH_AVX2
+#endif
+
+//Tags of one cache, laid out as parallel arrays indexed by set * associativity + way.
+//Tags, tids and co-tags of a set are contiguous, so a lookup touches one or two cache lines per array.
+//The valid/dirty/lock/is_translation/is_large bits and the coherence state of a line share one byte.
+//TLBs also index their valid lines by (co-tag, tid), so coherence messages find their line without a scan.
+class TagStore {
+public:
+    static const uint8_t VALID = 0x1;
+    static const uint8_t DIRTY = 0x2;
+    static const uint8_t LOCK = 0x4;
+    static const uint8_t TRANSLATION = 0x8;
+    static const uint8_t LARGE = 0x10;
+
+    //Narrower sets are matched as fast by the scalar loop, see -bench tagmatch
+    static const unsigned int SIMD_MIN_WAYS = 16;
+
+    //Coherence state lives in the bits above the flags
+    static const unsigned int STATE_SHIFT = 5;
+    static const uint8_t FLAG_MASK = (1 << STATE_SHIFT) - 1;
+
+    //Handle to one line, used where code used to hold a CacheLine&
+    class Line {
+    private:
+        TagStore *m_store;
+        size_t m_pos;
+
+        bool get_flag(uint8_t flag) const
+        {
+            return m_store->m_bits[m_pos] & flag;
+        }
+
+        void set_flag(uint8_t flag, bool val)
+        {
+            m_store->m_bits[m_pos] = val ? (m_store->m_bits[m_pos] | flag) : (m_store->m_bits[m_pos] & ~flag);
+        }
+
+    public:
+        Line(TagStore *store, size_t pos) : m_store(store), m_pos(pos) {}
+
+        uint64_t tag() const { return m_store->m_tags[m_pos]; }
+        uint64_t tid() const { return m_store->m_tids[m_pos]; }
+        uint64_t cotag() const { return m_store->m_cotags[m_pos]; }
+        bool is_valid() const { return get_flag(VALID); }
+        bool is_dirty() const { return get_flag(DIRTY); }
+        bool is_locked() const { return get_flag(LOCK); }
+        bool is_translation() const { return get_flag(TRANSLATION); }
+        bool is_large() const { return get_flag(LARGE); }
+
+        CoherenceState get_coherence_state() const
+        {
+            return static_cast<CoherenceState>(m_store->m_bits[m_pos] >> STATE_SHIFT);
+        }
+
+        void set_tag(uint64_t tag) { m_store->m_tags[m_pos] = tag; }
+
+        void set_tid(uint64_t tid)
+        {
+            m_store->unindex(m_pos);
+            m_store->m_tids[m_pos] = tid;
+            m_store->index(m_pos);
+        }
+
+        void set_cotag(uint64_t cotag)
+        {
+            m_store->unindex(m_pos);
+            m_store->m_cotags[m_pos] = cotag;
+            m_store->index(m_pos);
+        }
+
+        void set_valid(bool valid)
+        {
+            m_store->unindex(m_pos);
+            set_flag(VALID, valid);
+            m_store->track_valid(m_pos, valid);
+            m_store->index(m_pos);
+        }
+        void set_dirty(bool dirty) { set_flag(DIRTY, dirty); }
+        void set_locked(bool lock) { set_flag(LOCK, lock); }
+        void set_translation(bool is_translation) { set_flag(TRANSLATION, is_translation); }
+        void set_large(bool is_large) { set_flag(LARGE, is_large); }
+
+        void set_coherence_state(CoherenceState coh_state)
+        {
+            m_store->m_bits[m_pos] = (m_store->m_bits[m_pos] & FLAG_MASK) | (coh_state << STATE_SHIFT);
+        }
+
+        //Makes the line valid and unlocked with new contents, the coherence state is left as it is
+        void fill(uint64_t tag, uint64_t tid, uint64_t cotag, bool is_translation, bool is_large, bool dirty)
+        {
+            m_store->unindex(m_pos);
+            m_store->m_tags[m_pos] = tag;
+            m_store->m_tids[m_pos] = tid;
+            m_store->m_cotags[m_pos] = cotag;
+            uint8_t flags = VALID | (dirty ? DIRTY : 0) | (is_translation ? TRANSLATION : 0) | (is_large ? LARGE : 0);
+            m_store->m_bits[m_pos] = (m_store->m_bits[m_pos] & ~FLAG_MASK) | flags;
+            m_store->track_valid(m_pos, true);
+            m_store->index(m_pos);
+        }
+
+        friend std::ostream& operator << (std::ostream &out, const Line &l);
+    };
+
+private:
+    unsigned int m_num_sets;
+    unsigned int m_associativity;
+
+    std::vector<uint64_t> m_tags;
+    std::vector<uint64_t> m_tids;
+    std::vector<uint64_t> m_cotags;
+    std::vector<uint8_t> m_bits;
+
+    bool m_use_simd;
+
+    //Bitmap of the valid ways of every set, for sets of at most 64 ways, empty otherwise
+    std::vector<uint64_t> m_valid_ways;
+
+    void track_valid(size_t pos, bool valid)
+    {
+        if(!m_valid_ways.empty())
+        {
+            uint64_t bit = 1ULL << (pos % m_associativity);
+            uint64_t &ways = m_valid_ways[pos / m_associativity];
+            ways = valid ? (ways | bit) : (ways & ~bit);
+        }
+    }
+
+    //OpenAddressTable of the valid lines by (co-tag, tid),
+    //at most half full since it has room for twice the lines. Of no capacity when the store is not indexed.
+    class CotagSlot {
+    public:
+        uint64_t cotag;
+        uint64_t tid;
+        uint32_t pos;
+    };
+
+    static const uint32_t NO_POS = 0xffffffff;
+
+    static size_t cotag_hash(uint64_t cotag, uint64_t tid)
+    {
+        return (size_t) mix_hash(cotag ^ (tid * 0x9e3779b97f4a7c15ULL));
+    }
+
+    class CotagHash {
+    public:
+        size_t operator () (const CotagSlot &slot) const { return cotag_hash(slot.cotag, slot.tid); }
+    };
+
+    class CotagIsFree {
+    public:
+        bool operator () (const CotagSlot &slot) const { return slot.pos == NO_POS; }
+    };
+
+    OpenAddressTable<CotagSlot, CotagHash, CotagIsFree> m_cotag_index;
+
+    void index(size_t pos)
+    {
+        if(m_cotag_index.capacity() > 0 && (m_bits[pos] & VALID))
+        {
+            cotag_insert(pos);
+        }
+    }
+
+    void unindex(size_t pos)
+    {
+        if(m_cotag_index.capacity() > 0 && (m_bits[pos] & VALID))
+        {
+            cotag_erase(pos);
+        }
+    }
+
+    void cotag_insert(size_t pos);
+    void cotag_erase(size_t pos);
+
+    bool matches(size_t pos, uint64_t tag, bool is_translation, uint64_t tid) const
+    {
+        uint8_t want = is_translation ? (VALID | TRANSLATION) : VALID;
+        return m_tags[pos] == tag && (m_bits[pos] & (VALID | TRANSLATION)) == want && (!is_translation || m_tids[pos] == tid);
+    }
+
+public:
+    TagStore(unsigned int num_sets, unsigned int associativity);
+
+    Line line(uint64_t set, unsigned int way)
+    {
+        return Line(this, set * m_associativity + way);
+    }
+
+    //Way holding a valid line with this tag, associativity if there is none
+    //Threads share address space, so tid only has to match for translations
+    unsigned int find(uint64_t set, uint64_t tag, bool is_translation, uint64_t tid) const
+    {
+#ifdef TAG_MATCH_AVX2
+        if(m_use_simd)
+        {
+            return find_avx2(set, tag, is_translation, tid);
+        }
+#endif
+        return find_scalar(set, tag, is_translation, tid);
+    }
+
+    unsigned int find_scalar(uint64_t set, uint64_t tag, bool is_translation, uint64_t tid) const
+    {
+        size_t base = set * m_associativity;
+
+        for(unsigned int way = 0; way < m_associativity; way++)
+        {
+            if(matches(base + way, tag, is_translation, tid))
+            {
+                return way;
+            }
+        }
+
+        return m_associativity;
+    }
+
+#ifdef TAG_MATCH_AVX2
+    unsigned int find_avx2(uint64_t set, uint64_t tag, bool is_translation, uint64_t tid) const;
+#endif
+
+    //Whether the running CPU can use the vector tag match
+    static bool simd_supported();
+
+    //Vector tag match is on by default from SIMD_MIN_WAYS up where supported, and needs at least four ways
+    void set_use_simd(bool use_simd)
+    {
+        m_use_simd = use_simd && simd_supported() && m_associativity >= 4;
+    }
+
+    bool get_use_simd() const
+    {
+        return m_use_simd;
+    }
+
+    //First invalid way of the set, associativity if the set is full
+    unsigned int find_invalid(uint64_t set) const
+    {
+        if(!m_valid_ways.empty())
+        {
+            uint64_t invalid = ~m_valid_ways[set] & (~0ULL >> (64 - m_associativity));
+            return invalid ? __builtin_ctzll(invalid) : m_associativity;
+        }
+
+        size_t base = set * m_associativity;
+
+        for(unsigned int way = 0; way < m_associativity; way++)
+        {
+            if(!(m_bits[base + way] & VALID))
+            {
+                return way;
+            }
+        }
+
+        return m_associativity;
+    }
+
+    //Starts indexing valid lines by co-tag, for TLBs that receive coherence messages
+    void enable_cotag_index();
+
+    //First valid line in set order with this co-tag and tid
+    //Indexed stores answer from the index, others scan
+    bool find_by_cotag(uint64_t cotag, uint64_t tid, unsigned int &set, unsigned int &way) const;
+
+    unsigned int get_num_sets() const
+    {
+        return m_num_sets;
+    }
+
+    unsigned int get_associativity() const
+    {
+        return m_associativity;
+    }
+
+    //Bytes held by the tag arrays, the valid bitmaps and the co-tag index
+    size_t get_memory_usage() const;
+
+    void print_set(std::ostream &out, uint64_t set);
+};
+
+#endif /* TagStore_hpp */
@@ -0,0 +1,72 @@
+//
+//  TimeParallelSim.cpp
+//  TLB-Coherence-Simulator
+//
+//  Copyright © 2018 Yashwant Marathe. All rights reserved.
+//
+
+#include "TimeParallelSim.hpp"
+#include <thread>
+#include <algorithm>
+#include <assert.h>
+
+TimeParallelSim::TimeParallelSim(unsigned int num_segments, uint64_t start_ts, uint64_t end_ts, uint64_t overlap, std::function<void(TraceProcessor&)> setup) :
+m_end_ts(end_ts), m_overlap(overlap)
+{
+    assert(num_segments > 0 && start_ts < end_ts);
+
+    for(int k = 0; k < num_segments; k++)
+    {
+        m_start_ts.push_back(start_ts + (end_ts - start_ts) * k / num_segments);
+
+        //Set up here, setup runs on the calling thread only
+        m_segments.emplace_back(new Simulator(true));
+        setup(m_segments[k]->tp);
+    }
+}
+
+void TimeParallelSim::run_segment(unsigned int k)
+{
+    Simulator &sim = *m_segments[k];
+
+    uint64_t start_ts = m_start_ts[k];
+    uint64_t end_ts = (k + 1 < m_start_ts.size()) ? m_start_ts[k + 1] : m_end_ts;
+    uint64_t warmup_ts = (k > 0) ? std::max(m_start_ts[0], start_ts - std::min(start_ts, m_overlap)) : start_ts;
+
+    sim.tp.start_ts = warmup_ts;
+    sim.tp.end_ts = (warmup_ts < start_ts) ? start_ts : end_ts;
+    sim.tp.verifyOpenTraceFiles();
+
+    sim.build();
+    sim.initial_fill();
+    sim.run();
+
+    if(warmup_ts < start_ts)
+    {
+        //Caches and TLBs are warm, count from the first request of the segment on
+        sim.tp.extend(end_ts);
+        sim.reset_stats();
+        sim.initial_fill();
+        sim.run();
+    }
+}
+
+void TimeParallelSim::run()
+{
+    std::vector<std::thread> workers;
+
+    for(int k = 0; k < m_segments.size(); k++)
+    {
+        workers.emplace_back(&TimeParallelSim::run_segment, this, k);
+    }
+
+    for(int k = 0; k < workers.size(); k++)
+    {
+        workers[k].join();
+    }
+
+    for(int k = 1; k < m_segments.size(); k++)
+    {
+        m_segments[0]->merge_stats(*m_segments[k]);
+    }
+}
@@ -0,0 +1,46 @@
+//
+//  TimeParallelSim.hpp
+//  TLB-Coherence-Simulator
+//
+//  Copyright © 2018 Yashwant Marathe. All rights reserved.
+//
+
+#ifndef TimeParallelSim_hpp
+#define TimeParallelSim_hpp
+
+#include <iostream>
+#include <vector>
+#include <memory>
+#include <functional>
+#include "Simulator.hpp"
+
+//Runs one trace as consecutive slices of its timestamps, all at once, each by a Simulator of its own on a thread of its own, see main.cpp -segments.
+//A segment other than the first starts overlap timestamps early: the caches, TLBs and presence trackers warm up on the tail of the previous segment,
+//then the counters are reset and the segment itself is simulated. Counters of all segments are merged into the Simulator of the first one.
+//State older than the overlap is lost and every segment starts with an empty pipeline, see -bench timeparallel for the error against a serial run.
+class TimeParallelSim {
+private:
+    std::vector<std::unique_ptr<Simulator>> m_segments;
+
+    //First timestamp of every segment, the last one ends at m_end_ts
+    std::vector<uint64_t> m_start_ts;
+    uint64_t m_end_ts;
+    uint64_t m_overlap;
+
+    void run_segment(unsigned int k);
+
+public:
+    //Splits [start_ts, end_ts) into num_segments segments of the same length.
+    //setup configures the TraceProcessor of a segment as for a serial run, before its traces are opened.
+    TimeParallelSim(unsigned int num_segments, uint64_t start_ts, uint64_t end_ts, uint64_t overlap, std::function<void(TraceProcessor&)> setup);
+
+    void run();
+
+    //Simulator of the first segment, which holds the counters of all segments once run returns
+    Simulator& get_merged()
+    {
+        return *m_segments[0];
+    }
+};
+
+#endif /* TimeParallelSim_hpp */
@@ -0,0 +1,47 @@
+//
+//  TraceBuffer.cpp
+//  TLB-Coherence-Simulator
+//
+//  Copyright © 2018 Yashwant Marathe. All rights reserved.
+//
+
+#include "TraceBuffer.hpp"
+
+void TraceBuffer::add(const std::string &path, TraceReader *reader, size_t record_size)
+{
+    std::vector<char> *data = new std::vector<char>();
+    data->reserve(reader->get_num_records(record_size) * record_size);
+
+    //next() decodes compact traces, the records come out as a raw trace holds them
+    for(const char *rec = static_cast<const char*>(reader->next(record_size)); rec != nullptr; rec = static_cast<const char*>(reader->next(record_size)))
+    {
+        data->insert(data->end(), rec, rec + record_size);
+    }
+
+    m_traces[path] = std::shared_ptr<const std::vector<char>>(data);
+
+    delete reader;
+}
+
+TraceReader* TraceBuffer::open(const std::string &path) const
+{
+    auto it = m_traces.find(path);
+    if(it == m_traces.end())
+    {
+        return nullptr;
+    }
+
+    return new MemoryTraceReader(it->second);
+}
+
+size_t TraceBuffer::get_memory_usage() const
+{
+    size_t size = 0;
+
+    for(auto it = m_traces.begin(); it != m_traces.end(); it++)
+    {
+        size += it->second->size();
+    }
+
+    return size;
+}
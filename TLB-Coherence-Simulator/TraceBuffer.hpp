@@ -0,0 +1,41 @@
+//
+//  TraceBuffer.hpp
+//  TLB-Coherence-Simulator
+//
+//  Copyright © 2018 Yashwant Marathe. All rights reserved.
+//
+
+#ifndef TraceBuffer_hpp
+#define TraceBuffer_hpp
+
+#include <iostream>
+#include <vector>
+#include <map>
+#include <memory>
+#include <string>
+#include "TraceReader.hpp"
+
+//Traces read and decoded once, kept in memory for the TraceProcessors of several Simulators, see SweepSim.
+//Records are kept raw, whatever the format of the file, so a MemoryTraceReader hands them out as they are.
+//Traces are only added before readers are handed out, after that the buffer is read-only and safe to share between threads.
+class TraceBuffer {
+private:
+    std::map<std::string, std::shared_ptr<const std::vector<char>>> m_traces;
+
+public:
+    bool contains(const std::string &path) const
+    {
+        return m_traces.find(path) != m_traces.end();
+    }
+
+    //Reads the records of record_size bytes from reader to the end of the trace, keeps them as path and deletes reader
+    void add(const std::string &path, TraceReader *reader, size_t record_size);
+
+    //Reader from the first record of path, nullptr if path was not added
+    TraceReader* open(const std::string &path) const;
+
+    //Bytes of all traces kept
+    size_t get_memory_usage() const;
+};
+
+#endif /* TraceBuffer_hpp */
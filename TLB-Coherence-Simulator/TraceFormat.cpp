@@ -0,0 +1,456 @@
+//
+//  TraceFormat.cpp
+//  TLB-Coherence-Simulator
+//
+//  Copyright © 2018 Yashwant Marathe. All rights reserved.
+//
+
+#include "TraceFormat.hpp"
+#include <cstring>
+#include <assert.h>
+
+size_t encodeVarint(char *out, uint64_t val)
+{
+    size_t size = 0;
+
+    while(val >= 0x80)
+    {
+        out[size++] = (char)((val & 0x7f) | 0x80);
+        val >>= 7;
+    }
+    out[size++] = (char) val;
+
+    return size;
+}
+
+size_t decodeVarint(const char *in, size_t avail, uint64_t &val)
+{
+    uint64_t res = 0;
+    size_t limit = (avail < MAX_VARINT_SIZE) ? avail : MAX_VARINT_SIZE;
+
+    for(size_t i = 0; i < limit; i++)
+    {
+        uint8_t byte = (uint8_t) in[i];
+        res |= (uint64_t)(byte & 0x7f) << (7 * i);
+        if((byte & 0x80) == 0)
+        {
+            val = res;
+            return i + 1;
+        }
+    }
+
+    return 0;
+}
+
+size_t CompactTraceState::encode(char *out, bool large, uint64_t ts, uint64_t va, int write, uint64_t tid, TraceRecordKind rec_kind)
+{
+    size_t size = 0;
+
+    assert(can_encode(ts));
+    uint64_t head = (zigzagEncode((int64_t)(ts - m_ts)) << 2) | ((large ? 1 : 0) << 1) | ((write != 0) ? 1 : 0);
+    size += encodeVarint(out + size, head);
+    size += encodeVarint(out + size, zigzagEncode((int64_t)(va - m_va)));
+    if(rec_kind == TLB_TID_RECORD)
+    {
+        size += encodeVarint(out + size, zigzagEncode((int64_t)(tid - m_tid)));
+    }
+
+    m_ts = ts;
+    m_va = va;
+    m_tid = tid;
+
+    return size;
+}
+
+size_t CompactTraceState::decode(const char *in, size_t avail, trace_tlb_tid_entry_t &rec, TraceRecordKind rec_kind)
+{
+    uint64_t head, va_delta, tid_delta = 0;
+    size_t size = 0, len;
+
+    if((len = decodeVarint(in, avail, head)) == 0)
+    {
+        return 0;
+    }
+    size += len;
+
+    if((len = decodeVarint(in + size, avail - size, va_delta)) == 0)
+    {
+        return 0;
+    }
+    size += len;
+
+    if(rec_kind == TLB_TID_RECORD)
+    {
+        if((len = decodeVarint(in + size, avail - size, tid_delta)) == 0)
+        {
+            return 0;
+        }
+        size += len;
+    }
+
+    m_ts += (uint64_t) zigzagDecode(head >> 2);
+    m_va += (uint64_t) zigzagDecode(va_delta);
+    m_tid += (uint64_t) zigzagDecode(tid_delta);
+
+    rec.large = ((head >> 1) & 1) != 0;
+    rec.write = (int)(head & 1);
+    rec.ts = m_ts;
+    rec.va = m_va;
+    rec.tid = m_tid;
+
+    return size;
+}
+
+bool CompactTraceReader::open(const char *path)
+{
+    if(!m_src->open(path))
+    {
+        return false;
+    }
+
+    size_t avail;
+    const char *header = m_src->peek(COMPACT_TRACE_HEADER_SIZE, avail);
+    if(avail < COMPACT_TRACE_HEADER_SIZE || memcmp(header, COMPACT_TRACE_MAGIC, 4) != 0 || !loadTraceIndex(path, m_index))
+    {
+        std::cout << "[Error] " << path << " is not a compact trace" << std::endl;
+        return false;
+    }
+
+    m_src->consume(COMPACT_TRACE_HEADER_SIZE);
+    enter_chunk(0);
+    return true;
+}
+
+bool CompactTraceReader::enter_chunk(size_t chunk)
+{
+    if(chunk >= m_index.size())
+    {
+        m_chunk = m_index.size();
+        m_chunk_left = 0;
+        return false;
+    }
+
+    m_chunk = chunk;
+    m_chunk_left = m_index[chunk].count;
+    m_state.reset();
+    return true;
+}
+
+//peek() and consume() expose the encoded stream, next() hands out decoded records
+const char* CompactTraceReader::peek(size_t want, size_t &avail)
+{
+    return m_src->peek(want, avail);
+}
+
+void CompactTraceReader::consume(size_t size)
+{
+    m_src->consume(size);
+}
+
+const void* CompactTraceReader::next(size_t size)
+{
+    size_t avail;
+    trace_tlb_tid_entry_t rec;
+
+    //The index follows the last chunk, stop there
+    if(m_chunk_left == 0 && !enter_chunk(m_chunk + 1))
+    {
+        return nullptr;
+    }
+
+    const char *in = m_src->peek(MAX_COMPACT_RECORD_SIZE, avail);
+    size_t len = m_state.decode(in, avail, rec, m_rec_kind);
+
+    //Records handed out so far are left untouched at the end of the trace
+    if(len == 0)
+    {
+        return nullptr;
+    }
+    m_src->consume(len);
+    m_chunk_left--;
+
+    if(m_rec_kind == TLB_TID_RECORD)
+    {
+        assert(size == sizeof(trace_tlb_tid_entry_t));
+        m_tid_rec = rec;
+        return &m_tid_rec;
+    }
+
+    assert(size == sizeof(trace_tlb_entry_t));
+    m_rec.large = rec.large;
+    m_rec.ts = rec.ts;
+    m_rec.va = rec.va;
+    m_rec.write = rec.write;
+    return &m_rec;
+}
+
+bool CompactTraceReader::seek(size_t offset)
+{
+    //Only chunk starts are valid positions in the encoded stream
+    for(size_t i = 0; i < m_index.size(); i++)
+    {
+        if(m_index[i].offset == offset)
+        {
+            return m_src->seek(offset) && enter_chunk(i);
+        }
+    }
+
+    return false;
+}
+
+bool CompactTraceReader::seek_ts(uint64_t ts)
+{
+    //First chunk that still has records at or after ts
+    size_t lo = 0, hi = m_index.size();
+    while(lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        if(m_index[mid].last_ts < ts)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+
+    if(lo == m_index.size())
+    {
+        enter_chunk(lo);
+        return true;
+    }
+
+    return m_src->seek(m_index[lo].offset) && enter_chunk(lo);
+}
+
+//Compact records have no fixed size, the index holds the count of every chunk
+size_t CompactTraceReader::get_num_records(size_t /*record_size*/)
+{
+    size_t num_records = 0;
+    for(size_t i = 0; i < m_index.size(); i++)
+    {
+        num_records += m_index[i].count;
+    }
+    return num_records;
+}
+
+bool loadTraceIndex(const char *path, std::vector<TraceChunkIndex> &index)
+{
+    TraceIndexTrailer trailer;
+    bool ok = false;
+
+    FILE *fp = fopen(path, "r");
+    if(fp == nullptr)
+    {
+        return false;
+    }
+
+    if(fseek(fp, -(long) sizeof(TraceIndexTrailer), SEEK_END) == 0 &&
+       fread(&trailer, sizeof(TraceIndexTrailer), 1, fp) == 1 &&
+       memcmp(trailer.magic, COMPACT_TRACE_INDEX_MAGIC, sizeof(trailer.magic)) == 0)
+    {
+        index.resize(trailer.num_chunks);
+        ok = (fseek(fp, (long) trailer.index_offset, SEEK_SET) == 0) &&
+             (fread(index.data(), sizeof(TraceChunkIndex), index.size(), fp) == index.size());
+    }
+
+    fclose(fp);
+    return ok;
+}
+
+bool findTraceEndTs(const char *path, TraceRecordKind rec_kind, uint64_t &end_ts)
+{
+    char header[COMPACT_TRACE_HEADER_SIZE];
+
+    FILE *fp = fopen(path, "r");
+    if(fp == nullptr)
+    {
+        return false;
+    }
+
+    if(fread(header, 1, COMPACT_TRACE_HEADER_SIZE, fp) == COMPACT_TRACE_HEADER_SIZE && memcmp(header, COMPACT_TRACE_MAGIC, 4) == 0)
+    {
+        fclose(fp);
+
+        std::vector<TraceChunkIndex> index;
+        if(!loadTraceIndex(path, index))
+        {
+            return false;
+        }
+
+        end_ts = index.empty() ? 0 : (index.back().last_ts + 1);
+        return true;
+    }
+
+    trace_tlb_tid_entry_t rec;
+    size_t rec_size = (rec_kind == TLB_TID_RECORD) ? sizeof(trace_tlb_tid_entry_t) : sizeof(trace_tlb_entry_t);
+    bool ok = (fseek(fp, 0, SEEK_END) == 0);
+    long size = ok ? ftell(fp) : -1;
+
+    //Both raw layouts start with the same fields, the last record is read into the larger one
+    if(ok && size >= (long) rec_size)
+    {
+        ok = (fseek(fp, size - (long)(size % rec_size) - (long) rec_size, SEEK_SET) == 0) && (fread(&rec, rec_size, 1, fp) == 1);
+        end_ts = rec.ts + 1;
+    }
+    else
+    {
+        end_ts = 0;
+    }
+
+    fclose(fp);
+    return ok && (size >= 0);
+}
+
+TraceReader* openTrace(TraceReaderKind kind, const char *path)
+{
+    TraceReader *src = TraceReader::create(kind);
+
+    if(!src->open(path))
+    {
+        delete src;
+        return nullptr;
+    }
+
+    //Raw traces have no header, anything that does not start with the magic is read as is
+    size_t avail;
+    const char *header = src->peek(COMPACT_TRACE_HEADER_SIZE, avail);
+    if(avail < COMPACT_TRACE_HEADER_SIZE || memcmp(header, COMPACT_TRACE_MAGIC, 4) != 0)
+    {
+        return src;
+    }
+
+    if(header[4] != COMPACT_TRACE_VERSION)
+    {
+        std::cout << "[Error] Unsupported compact trace version " << (int) header[4] << " in " << path << std::endl;
+        delete src;
+        return nullptr;
+    }
+
+    TraceRecordKind rec_kind = (TraceRecordKind) header[5];
+    src->consume(COMPACT_TRACE_HEADER_SIZE);
+
+    std::vector<TraceChunkIndex> index;
+    if(!loadTraceIndex(path, index))
+    {
+        std::cout << "[Error] Missing or damaged chunk index in " << path << std::endl;
+        delete src;
+        return nullptr;
+    }
+
+    return new CompactTraceReader(src, rec_kind, index);
+}
+
+bool convertTrace(const char *in_path, const char *out_path, TraceRecordKind rec_kind)
+{
+    TraceReader *in = TraceReader::create(MMAP_TRACE_READER);
+    if(!in->open(in_path))
+    {
+        std::cout << "[Error] Could not open " << in_path << std::endl;
+        delete in;
+        return false;
+    }
+
+    FILE *out = fopen(out_path, "w");
+    if(out == nullptr)
+    {
+        std::cout << "[Error] Could not open " << out_path << std::endl;
+        delete in;
+        return false;
+    }
+
+    char header[COMPACT_TRACE_HEADER_SIZE] = {0};
+    memcpy(header, COMPACT_TRACE_MAGIC, 4);
+    header[4] = COMPACT_TRACE_VERSION;
+    header[5] = (char) rec_kind;
+    fwrite(header, 1, COMPACT_TRACE_HEADER_SIZE, out);
+
+    CompactTraceState state;
+    std::vector<TraceChunkIndex> index;
+    char rec[MAX_COMPACT_RECORD_SIZE];
+    uint64_t num_records = 0;
+    uint64_t in_size = 0;
+    uint64_t out_size = COMPACT_TRACE_HEADER_SIZE;
+
+    while(true)
+    {
+        bool large;
+        uint64_t ts, va, tid = 0;
+        int write;
+
+        if(rec_kind == TLB_TID_RECORD)
+        {
+            const trace_tlb_tid_entry_t *e = in->next_record<trace_tlb_tid_entry_t>();
+            if(e == nullptr)
+            {
+                break;
+            }
+            large = e->large; ts = e->ts; va = e->va; write = e->write; tid = e->tid;
+            in_size += sizeof(trace_tlb_tid_entry_t);
+        }
+        else
+        {
+            const trace_tlb_entry_t *e = in->next_record<trace_tlb_entry_t>();
+            if(e == nullptr)
+            {
+                break;
+            }
+            large = e->large; ts = e->ts; va = e->va; write = e->write;
+            in_size += sizeof(trace_tlb_entry_t);
+        }
+
+        if(index.empty() || index.back().count == COMPACT_TRACE_CHUNK_RECORDS)
+        {
+            TraceChunkIndex chunk = {ts, ts, out_size, 0};
+            index.push_back(chunk);
+            state.reset();
+        }
+
+        if(!state.can_encode(ts))
+        {
+            std::cout << "[Error] Timestamp " << ts << " is too far from the previous one in " << in_path << ", the compact encoding holds deltas up to 2^61" << std::endl;
+            fclose(out);
+            remove(out_path);
+            delete in;
+            return false;
+        }
+
+        size_t len = state.encode(rec, large, ts, va, write, tid, rec_kind);
+        fwrite(rec, 1, len, out);
+        out_size += len;
+        num_records++;
+
+        //Records are sorted by timestamp, so the last one closes the range
+        index.back().last_ts = ts;
+        index.back().count++;
+    }
+
+    TraceIndexTrailer trailer;
+    memset(&trailer, 0, sizeof(trailer));
+    trailer.index_offset = out_size;
+    trailer.num_chunks = index.size();
+    memcpy(trailer.magic, COMPACT_TRACE_INDEX_MAGIC, sizeof(trailer.magic));
+
+    fwrite(index.data(), sizeof(TraceChunkIndex), index.size(), out);
+    fwrite(&trailer, sizeof(TraceIndexTrailer), 1, out);
+    out_size += index.size() * sizeof(TraceChunkIndex) + sizeof(TraceIndexTrailer);
+
+    bool ok = (ferror(out) == 0);
+    ok = (fclose(out) == 0) && ok;
+    delete in;
+
+    if(!ok)
+    {
+        std::cout << "[Error] Could not write " << out_path << std::endl;
+        return false;
+    }
+
+    std::cout << "Records = " << num_records << std::endl;
+    std::cout << "Chunks = " << index.size() << std::endl;
+    std::cout << "Raw size = " << in_size << " bytes" << std::endl;
+    std::cout << "Compact size = " << out_size << " bytes" << std::endl;
+    std::cout << "Ratio = " << ((out_size != 0) ? ((double) in_size / out_size) : 0) << std::endl;
+
+    return true;
+}
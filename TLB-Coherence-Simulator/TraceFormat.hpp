@@ -0,0 +1,144 @@
+//
+//  TraceFormat.hpp
+//  TLB-Coherence-Simulator
+//
+//  Copyright © 2018 Yashwant Marathe. All rights reserved.
+//
+
+#ifndef TraceFormat_hpp
+#define TraceFormat_hpp
+
+#include <iostream>
+#include <vector>
+#include "utils.hpp"
+#include "TraceReader.hpp"
+
+//Compact trace container
+//Header:  "TLBZ", version, record kind, 2 reserved bytes
+//Chunks:  COMPACT_TRACE_CHUNK_RECORDS records each, delta state starts from zero in every chunk
+//Record:  varint((zigzag(ts - prev ts) << 2) | (large << 1) | write), timestamp deltas within +-2^61
+//         varint(zigzag(va - prev va))
+//         varint(zigzag(tid - prev tid))    [tid traces only]
+//Index:   one TraceChunkIndex per chunk
+//Trailer: TraceIndexTrailer, fixed size at the end of the file
+//Consecutive accesses are close in time and in the address space, so most records take 3-6 bytes.
+//Chunks decode independently, so the index lets a reader start at any timestamp without scanning.
+#define COMPACT_TRACE_MAGIC "TLBZ"
+#define COMPACT_TRACE_INDEX_MAGIC "TLBZIDX"
+#define COMPACT_TRACE_VERSION 2
+#define COMPACT_TRACE_HEADER_SIZE 8
+#ifndef COMPACT_TRACE_CHUNK_RECORDS
+#define COMPACT_TRACE_CHUNK_RECORDS (64 * 1024)
+#endif
+#define MAX_VARINT_SIZE 10
+#define MAX_COMPACT_RECORD_SIZE (3 * MAX_VARINT_SIZE)
+
+typedef struct {
+    uint64_t first_ts;
+    uint64_t last_ts;
+    uint64_t offset;
+    uint64_t count;
+} TraceChunkIndex;
+
+typedef struct {
+    uint64_t index_offset;
+    uint64_t num_chunks;
+    char     magic[8];
+} TraceIndexTrailer;
+
+typedef enum {
+    TLB_RECORD,
+    TLB_TID_RECORD,
+} TraceRecordKind;
+
+inline uint64_t zigzagEncode(int64_t val)
+{
+    return ((uint64_t) val << 1) ^ (uint64_t)(val >> 63);
+}
+
+inline int64_t zigzagDecode(uint64_t val)
+{
+    return (int64_t)(val >> 1) ^ -(int64_t)(val & 1);
+}
+
+//Delta state shared by the encoder and the decoder
+class CompactTraceState {
+public:
+    uint64_t m_ts;
+    uint64_t m_va;
+    uint64_t m_tid;
+
+    CompactTraceState() : m_ts(0), m_va(0), m_tid(0) {}
+
+    void reset()
+    {
+        m_ts = m_va = m_tid = 0;
+    }
+
+    //Whether the timestamp delta to ts fits next to the flags in the head varint, i.e. is within +-2^61
+    bool can_encode(uint64_t ts) const
+    {
+        return (zigzagEncode((int64_t)(ts - m_ts)) >> 62) == 0;
+    }
+
+    //Encodes one record into out, returns number of bytes written, ts must pass can_encode
+    size_t encode(char *out, bool large, uint64_t ts, uint64_t va, int write, uint64_t tid, TraceRecordKind rec_kind);
+
+    //Decodes one record from in, returns number of bytes read or 0 if the record is cut short
+    size_t decode(const char *in, size_t avail, trace_tlb_tid_entry_t &rec, TraceRecordKind rec_kind);
+};
+
+//Decodes a compact trace on top of any byte reader.
+//Hands out records in the raw layout, so TraceProcessor does not see the difference.
+class CompactTraceReader : public TraceReader {
+private:
+    TraceReader *m_src;
+    TraceRecordKind m_rec_kind;
+    CompactTraceState m_state;
+    trace_tlb_entry_t m_rec;
+    trace_tlb_tid_entry_t m_tid_rec;
+
+    std::vector<TraceChunkIndex> m_index;
+    size_t m_chunk;
+    uint64_t m_chunk_left;
+
+    bool enter_chunk(size_t chunk);
+
+public:
+    CompactTraceReader(TraceReader *src, TraceRecordKind rec_kind, const std::vector<TraceChunkIndex> &index) : m_src(src), m_rec_kind(rec_kind), m_index(index), m_chunk(0), m_chunk_left(0)
+    {
+        enter_chunk(0);
+    }
+
+    ~CompactTraceReader()
+    {
+        delete m_src;
+    }
+
+    virtual bool open(const char *path) override final;
+    virtual const char* peek(size_t want, size_t &avail) override final;
+    virtual void consume(size_t size) override final;
+    virtual const void* next(size_t size) override final;
+    virtual bool seek(size_t offset) override final;
+    virtual bool seek_ts(uint64_t ts) override final;
+    virtual size_t get_num_records(size_t record_size) override final;
+};
+
+size_t encodeVarint(char *out, uint64_t val);
+
+size_t decodeVarint(const char *in, size_t avail, uint64_t &val);
+
+//Reads the chunk index from the end of a compact trace
+bool loadTraceIndex(const char *path, std::vector<TraceChunkIndex> &index);
+
+//Timestamp past the last record of a raw or compact trace, 0 if it has none, without reading the records before it.
+//Records are sorted by timestamp: a raw trace is read at its last record, a compact one at the index of its last chunk.
+bool findTraceEndTs(const char *path, TraceRecordKind rec_kind, uint64_t &end_ts);
+
+//Opens a trace, raw or compact, and returns a reader that hands out raw records
+TraceReader* openTrace(TraceReaderKind kind, const char *path);
+
+//Converts a raw trace into the compact encoding, returns false on I/O errors
+bool convertTrace(const char *in_path, const char *out_path, TraceRecordKind rec_kind);
+
+#endif /* TraceFormat_hpp */
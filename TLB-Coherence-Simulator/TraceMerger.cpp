@@ -0,0 +1,59 @@
+//
+//  TraceMerger.cpp
+//  TLB-Coherence-Simulator
+//
+//  Copyright © 2018 Yashwant Marathe. All rights reserved.
+//
+
+#include "TraceMerger.hpp"
+#include <assert.h>
+
+void TraceMerger::reset(unsigned int num_streams)
+{
+    //Pad to a power of two so every stream is a leaf of a complete tree
+    m_num_leaves = 1;
+    while(m_num_leaves < num_streams)
+    {
+        m_num_leaves *= 2;
+    }
+
+    m_leaf_ts.assign(m_num_leaves, UINT64_MAX);
+    m_live.assign(m_num_leaves, false);
+    m_loser.assign(m_num_leaves, 0);
+    m_winner = make_key(UINT64_MAX, 0);
+    m_num_live = 0;
+}
+
+void TraceMerger::push(unsigned int stream, uint64_t ts)
+{
+    assert(stream < m_num_leaves);
+
+    if(!m_live[stream])
+    {
+        m_live[stream] = true;
+        m_num_live++;
+    }
+    m_leaf_ts[stream] = ts;
+}
+
+void TraceMerger::build()
+{
+    //Play the whole tournament bottom up, winners move on and losers stay at the node
+    std::vector<Key> winner(2 * m_num_leaves);
+
+    for(unsigned int i = 0; i < m_num_leaves; i++)
+    {
+        winner[m_num_leaves + i] = make_key(m_leaf_ts[i], i);
+    }
+
+    for(unsigned int node = m_num_leaves - 1; node > 0; node--)
+    {
+        Key a = winner[2 * node];
+        Key b = winner[2 * node + 1];
+
+        winner[node] = (a < b) ? a : b;
+        m_loser[node] = (a < b) ? b : a;
+    }
+
+    m_winner = winner[1];
+}
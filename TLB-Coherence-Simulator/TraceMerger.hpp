@@ -0,0 +1,96 @@
+//
+//  TraceMerger.hpp
+//  TLB-Coherence-Simulator
+//
+//  Copyright © 2018 Yashwant Marathe. All rights reserved.
+//
+
+#ifndef TraceMerger_hpp
+#define TraceMerger_hpp
+
+#include <iostream>
+#include <vector>
+#include <cstdint>
+
+//Tournament (loser) tree over the head records of several trace streams.
+//Orders by timestamp, ties go to the lower stream index, same as a linear scan with a strict compare.
+//Picking the next stream is O(1), advancing it replays one leaf-to-root path, one compare per level.
+//Matches against the stream that just advanced, which is all a replay needs.
+class TraceMerger {
+private:
+    //Timestamp in the upper bits, stream index in the lower ones, so ties go to the lower stream with one compare
+    typedef unsigned __int128 Key;
+
+    static Key make_key(uint64_t ts, unsigned int stream)
+    {
+        return ((Key) ts << 32) | stream;
+    }
+
+    //m_loser[node] is the key that lost the match at node, leaves start at m_num_leaves
+    //Streams without records sit at the maximum timestamp
+    std::vector<Key> m_loser;
+    std::vector<uint64_t> m_leaf_ts;
+    std::vector<bool> m_live;
+    Key m_winner;
+    unsigned int m_num_leaves;
+    unsigned int m_num_live;
+
+    void replay(Key key)
+    {
+        for(unsigned int node = ((unsigned int) key + m_num_leaves) >> 1; node > 0; node >>= 1)
+        {
+            //Branch free, which stream wins is close to random from one record to the next
+            Key other = m_loser[node];
+            bool swap = (other < key);
+            m_loser[node] = swap ? key : other;
+            key = swap ? other : key;
+        }
+        m_winner = key;
+    }
+
+public:
+    TraceMerger(unsigned int num_streams = 0)
+    {
+        reset(num_streams);
+    }
+
+    //Drops all streams and makes room for num_streams
+    void reset(unsigned int num_streams);
+
+    //Adds stream with its first record, call build() once all streams are in
+    void push(unsigned int stream, uint64_t ts);
+
+    void build();
+
+    bool empty() const
+    {
+        return (m_num_live == 0);
+    }
+
+    //Stream holding the oldest head record
+    unsigned int top() const
+    {
+        return (unsigned int) m_winner;
+    }
+
+    uint64_t top_ts() const
+    {
+        return (uint64_t)(m_winner >> 32);
+    }
+
+    //Top stream moved on to a record with timestamp ts
+    void update_top(uint64_t ts)
+    {
+        replay(make_key(ts, top()));
+    }
+
+    //Top stream ran out of records
+    void pop()
+    {
+        m_live[top()] = false;
+        m_num_live--;
+        replay(make_key(UINT64_MAX, top()));
+    }
+};
+
+#endif /* TraceMerger_hpp */
@@ -7,9 +7,14 @@
 //
 
 #include "TraceProcessor.hpp"
+#include "ParallelSim.hpp"
+#include <algorithm>
 
 void TraceProcessor::processPair(std::string name, std::string val)
 {
+    if (hier_config.processPair(name, val))
+        return;
+
     if (name.find("fmt") != std::string::npos)
     {
         if (val.find("m") != std::string::npos)
@@ -22,35 +27,100 @@ void TraceProcessor::processPair(std::string name, std::string val)
     
     if (name.find("cores") != std::string::npos)
         num_cores=(int)strtoul(val.c_str(), NULL, 10);
-    
-    for(int i = 0; i < num_cores; i++)
+
+    if (name == ("shootdown"))
+        strcpy(shootdown, val.c_str());
+
+    //Per-core settings: t<i>, i<i>, c<i>, tl<i> and pw<i>
+    std::size_t digits = name.find_first_of("0123456789");
+    if (digits != std::string::npos && digits > 0 && name.find_first_not_of("0123456789", digits) == std::string::npos)
     {
-        if (name == ("t" + std::to_string(i)))
-            strcpy(trace[i], val.c_str());
-        if (name == ("shootdown"))
-            strcpy(shootdown, val.c_str());
-        if (name == ("i" + std::to_string(i)))
-            total_instructions_in_real_run[i] = strtoul(val.c_str(),NULL, 10);
-        if (name == ("c" + std::to_string(i)))
-            ideal_cycles_in_real_run[i] = strtoul(val.c_str(), NULL, 10);
-        if (name == ("tl" + std::to_string(i)))
-            num_tlb_misses_in_real_run[i] = strtoul(val.c_str(), NULL, 10);
-        if (name == ("pw" + std::to_string(i)))
-            avg_pw_cycles_in_real_run[i] = strtod(val.c_str(),NULL);
+        std::string key = name.substr(0, digits);
+        unsigned int i = (unsigned int) strtoul(name.c_str() + digits, NULL, 10);
+
+        if (key == "t" || key == "i" || key == "c" || key == "tl" || key == "pw")
+        {
+            if (i >= trace.size())
+            {
+                resize_core_settings(i + 1);
+            }
+
+            if (key == "t")
+                trace[i] = val;
+            if (key == "i")
+                total_instructions_in_real_run[i] = strtoul(val.c_str(),NULL, 10);
+            if (key == "c")
+                ideal_cycles_in_real_run[i] = strtoul(val.c_str(), NULL, 10);
+            if (key == "tl")
+                num_tlb_misses_in_real_run[i] = strtoul(val.c_str(), NULL, 10);
+            if (key == "pw")
+                avg_pw_cycles_in_real_run[i] = strtod(val.c_str(),NULL);
+        }
     }
     
-    if (name == "l2d_lat")
-        l2d_lat = strtoul(val.c_str(),NULL, 10);
-    if (name == "l3d_lat")
-        l3d_lat = strtoul(val.c_str(),NULL, 10);
-    if (name == "vl_lat")
-        vl_lat = strtoul(val.c_str(),NULL, 10);
-    if (name == "dram_lat")
-        dram_lat = strtoul(val.c_str(),NULL, 10);
-    if (name == "vl_small_size")
-        l3_small_tlb_size = 33554432;
-    if (name == "vl_large_size")
-        l3_large_tlb_size = 8388608 / 4;
+    if (name == "reader")
+    {
+        if (val == "stdio")
+            reader_kind = STDIO_TRACE_READER;
+        else if (val == "async")
+            reader_kind = ASYNC_TRACE_READER;
+        else
+            reader_kind = MMAP_TRACE_READER;
+    }
+    if (name == "start_ts")
+        start_ts = strtoull(val.c_str(), NULL, 10);
+    if (name == "end_ts")
+        end_ts = strtoull(val.c_str(), NULL, 10);
+    if (name == "scheme")
+    {
+        if (!parseScheme(val, scheme))
+        {
+            std::cout << "[Error] Unknown translation coherence scheme " << val << std::endl;
+            exit(0);
+        }
+    }
+    if (name == "shootdown_penalty")
+        shootdown_penalty = strtoull(val.c_str(), NULL, 10);
+    if (name == "benchmark")
+        benchmark = val;
+    if (name == "warmup")
+        warmup_period = strtoull(val.c_str(), NULL, 10);
+}
+
+void TraceProcessor::resize_core_settings(unsigned int num_cores)
+{
+    trace.resize(num_cores);
+    total_instructions_in_real_run.resize(num_cores, 0);
+    ideal_cycles_in_real_run.resize(num_cores, 0);
+    num_tlb_misses_in_real_run.resize(num_cores, 0);
+    avg_pw_cycles_in_real_run.resize(num_cores, 0);
+}
+
+void TraceProcessor::set_num_cores(unsigned int num_cores)
+{
+    this->num_cores = num_cores;
+    resize_core_settings(num_cores);
+
+    for(int i = num_cores; i < trace_reader.size(); i++)
+    {
+        delete trace_reader[i];
+    }
+
+    buf1.resize(num_cores, nullptr);
+    buf2.resize(num_cores, nullptr);
+    trace_reader.resize(num_cores, nullptr);
+    used_up.resize(num_cores, false);
+    empty_file.resize(num_cores, false);
+    entry_count.resize(num_cores, 0);
+    curr_ts.resize(num_cores, 0);
+    last_ts.assign(num_cores, warmup_period);
+    global_ts = warmup_period;
+
+    delete [] request_pool;
+    request_pool = new RequestPool[num_cores];
+
+    presence_small_page = PresenceTracker(num_cores);
+    presence_large_page = PresenceTracker(num_cores);
 }
 
 void TraceProcessor::parseAndSetupInputs(char *input_cfg)
@@ -82,6 +152,8 @@ void TraceProcessor::parseAndSetupInputs(char *input_cfg)
             std::cout <<"Warning! Unknown entry: " << str << " found in cfg file. Exiting..."<< std::endl;
     }
     
+    set_num_cores(num_cores);
+
     if (strcasecmp(fmt, "-m") != 0)
     {
         for (int i = 0;i < num_cores; i++)
@@ -94,47 +166,123 @@ void TraceProcessor::parseAndSetupInputs(char *input_cfg)
     }
 }
 
+TraceReader* TraceProcessor::open_reader(const char *path, bool is_shootdown)
+{
+    if(trace_buffer != nullptr)
+    {
+        return trace_buffer->open(path);
+    }
+
+    //Shootdown files are always raw
+    if(!is_shootdown)
+    {
+        return openTrace(reader_kind, path);
+    }
+
+    TraceReader *reader = TraceReader::create(reader_kind);
+    if(!reader->open(path))
+    {
+        delete reader;
+        return nullptr;
+    }
+
+    return reader;
+}
+
+void TraceProcessor::load_traces(TraceBuffer &buffer)
+{
+    assert(trace_buffer == nullptr);
+
+    //Paths that do not open are left out, verifyOpenTraceFiles reports them
+    for(int i = 0; i < (is_multicore ? num_cores : 1); i++)
+    {
+        if(!buffer.contains(trace[i]))
+        {
+            TraceReader *reader = open_reader(trace[i].c_str(), false);
+            if(reader != nullptr)
+            {
+                buffer.add(trace[i], reader, is_multicore ? sizeof(trace_tlb_entry_t) : sizeof(trace_tlb_tid_entry_t));
+            }
+        }
+    }
+
+    if(!buffer.contains(shootdown))
+    {
+        TraceReader *reader = open_reader(shootdown, true);
+        if(reader != nullptr)
+        {
+            buffer.add(shootdown, reader, sizeof(trace_shootdown_entry_t));
+        }
+    }
+
+    trace_buffer = &buffer;
+}
+
 void TraceProcessor::verifyOpenTraceFiles()
 {
+    merger.reset(num_cores);
+
     for (int i = 0 ; (i < num_cores) && is_multicore; i++)
     {
-        trace_fp[i] = fopen((char*)trace[i], "r");
-        if (!trace_fp[i])
+        trace_reader[i] = open_reader(trace[i].c_str(), false);
+        if (trace_reader[i] == nullptr)
         {
             std::cout << "[Error] Check trace file path of core " << i << std::endl;
             std::cout << trace[i] << " does not exist" << std::endl;
             exit(0);
         }
-        fread ((void*)&buf1[i], sizeof(trace_tlb_entry_t), 1, trace_fp[i]);
+        buf1[i] = seekToStart<trace_tlb_entry_t>(trace_reader[i]);
         used_up[i] = false;
-        empty_file[i] = false;
+        empty_file[i] = (buf1[i] == nullptr) || (buf1[i]->ts >= end_ts);
         entry_count[i] = 1;
+
+        if(!empty_file[i])
+        {
+            merger.push(i, buf1[i]->ts);
+        }
     }
 
+    merger.build();
+
     if(!is_multicore)
     {
-        trace_fp[0] = fopen((char*)trace[0], "r");
-        if (!trace_fp[0])
+        trace_reader[0] = open_reader(trace[0].c_str(), false);
+        if (trace_reader[0] == nullptr)
         {
             std::cout << "[Error] Check trace file path" << std::endl;
             std::cout << trace[0] << " does not exist" << std::endl;
             exit(0);
         }
-        fread ((void*)&buf2[0], sizeof(trace_tlb_tid_entry_t), 1, trace_fp[0]);
+        buf2[0] = seekToStart<trace_tlb_tid_entry_t>(trace_reader[0]);
         used_up[0] = false;
-        empty_file[0] = false;
+        empty_file[0] = (buf2[0] == nullptr) || (buf2[0]->ts >= end_ts);
         entry_count[0] = 1;
     }
 
-    shootdown_fp = fopen((char*) shootdown, "r");
-    if(!shootdown_fp)
+    shootdown_reader = open_reader(shootdown, true);
+    if(shootdown_reader == nullptr)
     {
         std::cout << "[Error] Check shootdown file path" << std::endl;
         std::cout << shootdown << " does not exist" << std::endl;
         exit(0);
     }
 
-    fread((void*)buf3, sizeof(trace_shootdown_entry_t), 1, shootdown_fp);
+    buf3 = seekToStart<trace_shootdown_entry_t>(shootdown_reader);
+    if(buf3 == nullptr)
+    {
+        std::cout << "[Error] Shootdown file " << shootdown << " has no entries from ts " << start_ts << std::endl;
+        exit(0);
+    }
+
+    //Simulation picks up at start_ts instead of the end of the warmup period
+    if(start_ts != 0)
+    {
+        for(int i = 0; i < num_cores; i++)
+        {
+            last_ts[i] = start_ts;
+        }
+        global_ts = start_ts;
+    }
     used_up_shootdown = false;
 
 }
@@ -143,9 +291,12 @@ void TraceProcessor::getShootdownEntry()
 {
     if(used_up_shootdown)
     {
-        if(!empty_file_shootdown && !feof(shootdown_fp))
+        //On end of file, keep the last entry around like before
+        const trace_shootdown_entry_t *next = (!empty_file_shootdown) ? shootdown_reader->next_record<trace_shootdown_entry_t>() : nullptr;
+
+        if(next != nullptr)
         {
-            fread((void*)buf3, sizeof(trace_shootdown_entry_t), 1, shootdown_fp);
+            buf3 = next;
             std::cout << "[TLB_SHOOTDOWN_NEXT] = " << buf3->ts << "," << buf3->core_id << "," << buf3->num_cores << "\n";
             used_up_shootdown = false;
         }
@@ -160,36 +311,36 @@ void TraceProcessor::getShootdownEntry()
 int TraceProcessor::getNextEntry()
 {
     int index = -1;
-    uint64_t least = 0xffffffffffffffff;
-    
-    for(int i = 0; (i < num_cores) && is_multicore; i++)
+
+    if(is_multicore)
     {
-        if(used_up[i])
+        //Only the stream handed out last can be used up, and it is still at the top
+        if(!merger.empty() && used_up[merger.top()])
         {
-            // if not end-of-file, fill next entry
-            if(!empty_file[i])
+            int i = merger.top();
+            const trace_tlb_entry_t *next = trace_reader[i]->next_record<trace_tlb_entry_t>();
+            if (next != nullptr && next->ts < end_ts)
             {
-                if (!feof(trace_fp[i]))
-                {
-                    fread ((void*)&buf1[i], sizeof(trace_tlb_entry_t), 1, trace_fp[i] );
-                    used_up[i] = false;
-                    entry_count[i]++;
-                }
-                else
-                {
-                    std::cout << " Done with core " << i << std::endl;
-                    empty_file[i] = true;
-                }
+                buf1[i] = next;
+                used_up[i] = false;
+                entry_count[i]++;
+                merger.update_top(next->ts);
             }
-        }
-        if (!empty_file[i])
-        {
-            if (buf1[i].ts < least)
+            else
             {
-                least = buf1[i].ts;
-                index = i;
+                //A record past end_ts is kept for extend
+                buf1[i] = next;
+                used_up[i] = false;
+                std::cout << " Done with core " << i << std::endl;
+                empty_file[i] = true;
+                merger.pop();
             }
         }
+
+        if(!merger.empty())
+        {
+            index = merger.top();
+        }
     }
 
     if(!is_multicore)
@@ -200,20 +351,29 @@ int TraceProcessor::getNextEntry()
         {
             if(!empty_file[0])
             {
-                if(!feof(trace_fp[0]))
+                const trace_tlb_tid_entry_t *next = trace_reader[0]->next_record<trace_tlb_tid_entry_t>();
+                if(next != nullptr && next->ts < end_ts)
                 {
-                    fread((void*)&buf2[0], sizeof(trace_tlb_tid_entry_t), 1, trace_fp[0]);
+                    buf2[0] = next;
                     used_up[0] = false;
                     entry_count[0]++;
                 }
                 else
                 {
+                    //A record past end_ts is kept for extend
+                    buf2[0] = next;
+                    used_up[0] = false;
                     std::cout << "Done with trace " << "\n";
                     empty_file[0] = true;
-                    index = -1;
                 }
             }
         }
+
+        //Nothing left to hand out once the trace is exhausted
+        if(empty_file[0])
+        {
+            index = -1;
+        }
     }
     
     return index;
@@ -221,6 +381,18 @@ int TraceProcessor::getNextEntry()
 
 Request* TraceProcessor::generateRequest()
 {
+    //The rest of a burst reaches the core one instruction per call, the rate single instructions were handed out at.
+    //Cores see their instruction stream at the same points in time as with one request per instruction.
+    if(pending_burst != nullptr)
+    {
+        pending_burst->m_num_avail++;
+        if(--pending_burst_left == 0)
+        {
+            pending_burst = nullptr;
+        }
+        return nullptr;
+    }
+
     int idx = getNextEntry();
     getShootdownEntry();
 
@@ -237,14 +409,14 @@ Request* TraceProcessor::generateRequest()
     {
         if (is_multicore)
         {
-            va = buf1[idx].va;
-            is_large = buf1[idx].large;
-            is_write = (bool)((buf1[idx].write != 0)? true: false);
-            curr_ts[idx] = buf1[idx].ts;
+            va = buf1[idx]->va;
+            is_large = buf1[idx]->large;
+            is_write = (bool)((buf1[idx]->write != 0)? true: false);
+            curr_ts[idx] = buf1[idx]->ts;
 
             if(curr_ts[idx] == last_ts[idx])
             {
-                Request *req = new Request(va, is_write ? DATA_WRITE : DATA_READ, idx, is_large, idx);
+                Request *req = request_pool[idx].create(va, is_write ? DATA_WRITE : DATA_READ, idx, is_large, idx);
                 used_up[idx] = true;
 
                 //add_to_presence_map(*req);
@@ -264,30 +436,27 @@ Request* TraceProcessor::generateRequest()
                 while(req == nullptr)
                 {
                     //double randVal = rand();
-                    //auto chosen_map = (randVal < 0.5) ? presence_map_small_page : presence_map_large_page;
                     //bool shootdown_is_large = (randVal < 0.5) ? false : true;
-                    auto chosen_map = (num_tries % 2 == 0) ? presence_map_small_page : presence_map_large_page;
+                    PresenceTracker &chosen_tracker = (num_tries % 2 == 0) ? presence_small_page : presence_large_page;
                     bool shootdown_is_large = (num_tries % 2 == 0) ? false : true;
 
                     if((num_tries % 2 == 0) && (num_tries > 0))
                     {
                         std::cout << "[CHANGE_SHOOTDOWN_CORES] Could not find adequate address, changing number of cores affected\n";
-                        shootdown_num_cores = (shootdown_num_cores != (NUM_CORES - 1)) ? (shootdown_num_cores + 1) % NUM_CORES : 
-                                                   (num_tries == (2 * NUM_CORES - 1)) ? 1 : 2;
+                        shootdown_num_cores = (shootdown_num_cores != (num_cores - 1)) ? (shootdown_num_cores + 1) % num_cores : 
+                                                   (num_tries == (2 * num_cores - 1)) ? 1 : 2;
                     }
 
-                    for(auto it = chosen_map.begin(); it != chosen_map.end(); it++)
+                    //Page present on the initiator core and on exactly shootdown_num_cores cores,
+                    //on the last try any page present on the initiator core
+                    const RequestDesc *page = (num_tries < num_cores * 2) ? chosen_tracker.find(shootdown_core_id, shootdown_num_cores) :
+                                              (num_tries == num_cores * 2) ? chosen_tracker.find_any(shootdown_core_id) : nullptr;
+                    if(page != nullptr)
                     {
-                        //if(it->second.size() == (shootdown_num_cores - 1))
-                        //if(it->second.size() == (shootdown_num_cores) && (it->second.find(shootdown_core_id) != it->second.end()))
-                        if(((num_tries < NUM_CORES * 2) && it->second.size() == (shootdown_num_cores) && (it->second.find(shootdown_core_id) != it->second.end())) || \
-                                ((num_tries == NUM_CORES * 2) && (it->second.find(shootdown_core_id) != it->second.end())))
-                        {
-                            shootdown_va = it->first.m_addr;
-                            req = new Request(shootdown_va, TRANSLATION_WRITE, idx, shootdown_is_large, shootdown_core_id);
-                            used_up_shootdown = true;
-                            goto exit_loop_mc;
-                        }
+                        shootdown_va = page->m_addr;
+                        req = request_pool[shootdown_core_id].create(shootdown_va, TRANSLATION_WRITE, idx, shootdown_is_large, shootdown_core_id);
+                        used_up_shootdown = true;
+                        goto exit_loop_mc;
                     }
 
                     num_tries += 1;
@@ -299,53 +468,59 @@ Request* TraceProcessor::generateRequest()
                 
                 RequestDesc rdesc(req->m_addr, req->m_tid, req->m_is_large);
                 std::cout << rdesc << ": ";
-                if(req->m_is_large)
-                {
-                    for(auto it = presence_map_large_page[rdesc].begin(); it != presence_map_large_page[rdesc].end(); it++)
-                    {
-                        std::cout << *it << ", ";
-                    }
-                    std::cout << "\n";
-                }
-                else
+                std::vector<unsigned int> sharers = (req->m_is_large) ? presence_large_page.get_sharers(rdesc) : presence_small_page.get_sharers(rdesc);
+                for(int i = 0; i < sharers.size(); i++)
                 {
-                    for(auto it = presence_map_small_page[rdesc].begin(); it != presence_map_small_page[rdesc].end(); it++)
-                    {
-                        std::cout << *it << ", ";
-                    }
-                    std::cout << "\n";
+                    std::cout << sharers[i] << ", ";
                 }
+                std::cout << "\n";
 
                 return req;
             }
             else if(curr_ts[idx] > last_ts[idx])
             {
-                Request *req = new Request();
+                //One request stands for all non-memory instructions up to the next memory access,
+                //or up to a pending shootdown on this core so that it fires at the same instruction
+                uint64_t burst_end = curr_ts[idx];
+                if((shootdown_core_id == idx) && (shootdown_ts > last_ts[idx]) && (shootdown_ts < burst_end))
+                {
+                    burst_end = shootdown_ts;
+                }
+
+                Request *req = request_pool[idx].create();
                 req->m_is_memory_acc = false;
                 req->m_core_id = idx;
-                last_ts[idx]++;
+                req->m_num_instr = burst_end - last_ts[idx];
+                req->m_num_avail = 1;
+
+                for(uint64_t count = (last_ts[idx] / 1000000 + 1) * 1000000; count <= burst_end; count += 1000000)
+                {
+                    std::cout << "[NUM_INSTR_PROCESSED] Core : " << idx << ", Count = " << count << "\n";
+                }
+                last_ts[idx] = burst_end;
 
-                if(last_ts[idx] % 1000000 == 0)
+                if(req->m_num_instr > 1)
                 {
-                    std::cout << "[NUM_INSTR_PROCESSED] Core : " << idx << ", Count = " << last_ts[idx] << "\n";
+                    pending_burst = req;
+                    pending_burst_left = req->m_num_instr - 1;
                 }
                 return req;
             }
         }
         else
         {
-            va = buf2[idx].va;
-            is_large = buf2[idx].large;
-            is_write = (bool)((buf2[idx].write != 0)? true: false);
-            curr_ts[idx] = buf2[idx].ts;
-            tid = buf2[idx].tid;
-            unsigned int core = (tid + tid_offset) % NUM_CORES;
+            va = buf2[idx]->va;
+            is_large = buf2[idx]->large;
+            is_write = (bool)((buf2[idx]->write != 0)? true: false);
+            curr_ts[idx] = buf2[idx]->ts;
+            tid = buf2[idx]->tid;
+            unsigned int core = (tid + tid_offset) % num_cores;
 
             if(curr_ts[idx] == global_ts)
             {
                 //Threads switch about every context switch interval
-                //uint64_t tid = (idx + tid_offset) % NUM_CORES;
-                Request *req = new Request(va, is_write ? DATA_WRITE : DATA_READ, tid, is_large, core);
+                //uint64_t tid = (idx + tid_offset) % num_cores;
+                Request *req = request_pool[core].create(va, is_write ? DATA_WRITE : DATA_READ, tid, is_large, core);
                 used_up[idx] = true;
 
                 last_ts[core] = global_ts;
@@ -370,34 +545,31 @@ Request* TraceProcessor::generateRequest()
                 while(req == nullptr)
                 {
                     //double randVal = rand();
-                    //auto chosen_map = (randVal < 0.5) ? presence_map_small_page : presence_map_large_page;
                     //bool shootdown_is_large = (randVal < 0.5) ? false : true;
-                    auto chosen_map = (num_tries % 2 == 0) ? presence_map_small_page : presence_map_large_page;
+                    PresenceTracker &chosen_tracker = (num_tries % 2 == 0) ? presence_small_page : presence_large_page;
                     bool shootdown_is_large = (num_tries % 2 == 0) ? false : true;
 
                     if((num_tries % 2 == 0) && (num_tries > 0))
                     {
                         std::cout << "[CHANGE_SHOOTDOWN_CORES] Could not find adequate address, changing number of cores affected\n";
-                        shootdown_num_cores = (shootdown_num_cores != (NUM_CORES - 1)) ? (shootdown_num_cores + 1) % NUM_CORES : 
-                                                   (num_tries == (2 * NUM_CORES - 1)) ? 1 : 2;
+                        shootdown_num_cores = (shootdown_num_cores != (num_cores - 1)) ? (shootdown_num_cores + 1) % num_cores : 
+                                                   (num_tries == (2 * num_cores - 1)) ? 1 : 2;
                     }
 
-                    for(auto it = chosen_map.begin(); it != chosen_map.end(); it++)
+                    //If the translation entry is present in the initiator core
+                    //And if the number of cores having the translation entries = Number of victim cores
+                    const RequestDesc *page = (num_tries < num_cores * 2) ? chosen_tracker.find(shootdown_core_id, shootdown_num_cores) :
+                                              (num_tries == num_cores * 2) ? chosen_tracker.find_any(shootdown_core_id) : nullptr;
+                    if(page != nullptr)
                     {
-                        //If the translation entry is present in the initiator core
-                        //And if the number of cores having the translation entries = Number of victim cores
-                        if(((num_tries < NUM_CORES * 2) && it->second.size() == (shootdown_num_cores) && (it->second.find(shootdown_core_id) != it->second.end())) || \
-                                ((num_tries == NUM_CORES * 2) && (it->second.find(shootdown_core_id) != it->second.end())))
-                        {
-                            shootdown_va = it->first.m_addr;
-                            req = new Request(shootdown_va, TRANSLATION_WRITE, tid, shootdown_is_large, shootdown_core_id);
-                            used_up_shootdown = true;
-                            goto exit_loop_mt;
-                        }
+                        shootdown_va = page->m_addr;
+                        req = request_pool[shootdown_core_id].create(shootdown_va, TRANSLATION_WRITE, tid, shootdown_is_large, shootdown_core_id);
+                        used_up_shootdown = true;
+                        goto exit_loop_mt;
                     }
 
                     num_tries += 1;
-                    if(num_tries > NUM_CORES * 2)
+                    if(num_tries > num_cores * 2)
                     {
                         req = nullptr;
                         used_up_shootdown = true;
@@ -413,31 +585,21 @@ Request* TraceProcessor::generateRequest()
 
                     RequestDesc rdesc(req->m_addr, req->m_tid, req->m_is_large);
                     std::cout << rdesc << ": ";
-                    if(req->m_is_large)
+                    std::vector<unsigned int> sharers = (req->m_is_large) ? presence_large_page.get_sharers(rdesc) : presence_small_page.get_sharers(rdesc);
+                    for(int i = 0; i < sharers.size(); i++)
                     {
-                        for(auto it = presence_map_large_page[rdesc].begin(); it != presence_map_large_page[rdesc].end(); it++)
-                        {
-                            std::cout << *it << ", ";
-                        }
-                        std::cout << "\n";
-                    }
-                    else
-                    {
-                        for(auto it = presence_map_small_page[rdesc].begin(); it != presence_map_small_page[rdesc].end(); it++)
-                        {
-                            std::cout << *it << ", ";
-                        }
-                        std::cout << "\n";
+                        std::cout << sharers[i] << ", ";
                     }
+                    std::cout << "\n";
                 }
 
                 return req;
             }
             else if(curr_ts[idx] > global_ts)
             {
-                Request *req = new Request();
+                Request *req = request_pool[global_ts % num_cores].create();
                 req->m_is_memory_acc = false;
-                req->m_core_id = (global_ts) % NUM_CORES;
+                req->m_core_id = (global_ts) % num_cores;
                 global_ts++;
 
                 //For every instruction added, decrement context_switch_count
@@ -466,16 +628,64 @@ Request* TraceProcessor::generateRequest()
     return nullptr;
 }
 
+void TraceProcessor::extend(uint64_t end_ts)
+{
+    assert(is_exhausted() && end_ts >= this->end_ts);
+
+    this->end_ts = end_ts;
+
+    if(is_multicore)
+    {
+        merger.reset(num_cores);
+
+        for(int i = 0; i < num_cores; i++)
+        {
+            //Streams at the end of their file have no record left
+            empty_file[i] = (buf1[i] == nullptr) || (buf1[i]->ts >= end_ts);
+            if(!empty_file[i])
+            {
+                merger.push(i, buf1[i]->ts);
+            }
+        }
+
+        merger.build();
+    }
+    else
+    {
+        empty_file[0] = (buf2[0] == nullptr) || (buf2[0]->ts >= end_ts);
+    }
+}
+
+uint64_t TraceProcessor::find_end_ts()
+{
+    uint64_t end_ts = 0;
+
+    for(int i = 0; i < (is_multicore ? num_cores : 1); i++)
+    {
+        uint64_t trace_end_ts;
+        if (!findTraceEndTs(trace[i].c_str(), is_multicore ? TLB_RECORD : TLB_TID_RECORD, trace_end_ts))
+        {
+            std::cout << "[Error] Check trace file path of core " << i << std::endl;
+            std::cout << trace[i] << " does not exist" << std::endl;
+            exit(0);
+        }
+
+        end_ts = std::max(end_ts, trace_end_ts);
+    }
+
+    return end_ts;
+}
+
 uint64_t TraceProcessor::switch_threads()
 {
     //When context switch count is 0, reinitialize tid offset
-    context_switch_count = (5000000000 - 3000000000) * (rand()/(double) RAND_MAX);
-    uint64_t tid_offset = (NUM_CORES) * (rand()/(double) RAND_MAX);
+    context_switch_count = (5000000000 - 3000000000) * random_fraction();
+    uint64_t tid_offset = (num_cores) * random_fraction();
     std::cout << "Switching threads\n";
 
-    for(int i = 0; i < NUM_CORES; i++)
+    for(int i = 0; i < num_cores; i++)
     {
-        uint64_t tid = (i + tid_offset) % NUM_CORES;
+        uint64_t tid = (i + tid_offset) % num_cores;
         std::cout << "Core " << i << " now running thread = " << tid << "\n";
     }
 
@@ -484,74 +694,44 @@ uint64_t TraceProcessor::switch_threads()
 
 void TraceProcessor::add_to_presence_map(Request &r)
 {
+    //Presence trackers are shared by the cores, worker threads leave updates to the serial phase
+    if(ParallelSim::is_deferring())
+    {
+        Request req = r;
+        ParallelSim::defer([this, req]() mutable { add_to_presence_map(req); });
+        return;
+    }
+
     RequestDesc rdesc(r.m_addr, r.m_tid, r.m_is_large);
 
     if(rdesc.m_is_large)
     {
         rdesc.m_addr = (rdesc.m_addr) & ~((1 << 21) - 1);
-        if(presence_map_large_page.find(rdesc) != presence_map_large_page.end())
-        {
-            presence_map_large_page[rdesc].insert(r.m_core_id);
-        }
-        else
-        {
-            //presence_map_large_page[rdesc] = std::set<uint64_t>();
-            presence_map_large_page.insert(std::pair<RequestDesc, std::set<uint64_t>>(rdesc, std::set<uint64_t>()));
-            presence_map_large_page[rdesc].insert(r.m_core_id);
-        }
+        presence_large_page.add(rdesc, r.m_core_id);
     }
     else
     {
         rdesc.m_addr = (rdesc.m_addr) & ~((1 << 12) - 1);
-        if(presence_map_small_page.find(rdesc) != presence_map_small_page.end())
-        {
-            presence_map_small_page[rdesc].insert(r.m_core_id);
-        }
-        else
-        {
-            //presence_map_small_page[rdesc] = std::set<uint64_t>();
-            presence_map_small_page.insert(std::pair<RequestDesc, std::set<uint64_t>>(rdesc, std::set<uint64_t>()));
-            presence_map_small_page[rdesc].insert(r.m_core_id);
-        }
+        presence_small_page.add(rdesc, r.m_core_id);
     }
 }
 
 void TraceProcessor::remove_from_presence_map(uint64_t addr, uint64_t tid, bool is_large, unsigned int core_id)
 {
+    if(ParallelSim::is_deferring())
+    {
+        ParallelSim::defer([this, addr, tid, is_large, core_id]() { remove_from_presence_map(addr, tid, is_large, core_id); });
+        return;
+    }
+
     RequestDesc rdesc(addr, tid, is_large);
 
     if(is_large)
     {
-        //assert(presence_map_large_page.find(rdesc) != presence_map_large_page.end());
-        if(presence_map_large_page.find(rdesc) != presence_map_large_page.end())
-        {
-            auto it = presence_map_large_page[rdesc].find(core_id);
-            //assert(it != presence_map_large_page[rdesc].end());
-            if(it != presence_map_large_page[rdesc].end())
-            {
-                presence_map_large_page[rdesc].erase(it);
-                if(presence_map_large_page[rdesc].size() == 0)
-                {
-                    presence_map_large_page.erase(rdesc);
-                }
-            }
-        }
+        presence_large_page.remove(rdesc, core_id);
     }
     else
     {
-        //assert(presence_map_small_page.find(rdesc) != presence_map_small_page.end());
-        if(presence_map_small_page.find(rdesc) != presence_map_small_page.end())
-        {
-            auto it = presence_map_small_page[rdesc].find(core_id);
-            //assert(it != presence_map_small_page[rdesc].end());
-            if(it != presence_map_small_page[rdesc].end())
-            {
-                presence_map_small_page[rdesc].erase(it);
-                if(presence_map_small_page[rdesc].size() == 0)
-                {
-                    presence_map_small_page.erase(rdesc);
-                }
-            }
-        }
+        presence_small_page.remove(rdesc, core_id);
     }
 }
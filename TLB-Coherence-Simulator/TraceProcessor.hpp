@@ -13,109 +13,128 @@
 #include "utils.hpp"
 #include <fstream>
 #include "Request.hpp"
+#include "TraceReader.hpp"
+#include "TraceFormat.hpp"
+#include "TraceMerger.hpp"
+#include "RequestPool.hpp"
+#include "PresenceTracker.hpp"
+#include "HierarchyConfig.hpp"
+#include "TraceBuffer.hpp"
 #include <cstring>
 #include <unordered_map>
 #include <set>
+#include <random>
+#include <memory>
+#include <cstdlib>
 #include <assert.h>
 
-class RequestDesc {
-    public:
-        uint64_t m_addr;
-        uint64_t m_tid;
-        bool m_is_large;
-
-        RequestDesc(uint64_t addr, uint64_t tid, bool is_large) : m_addr(addr), m_tid(tid), m_is_large(is_large) { }
-
-        bool operator == (const RequestDesc &other) const
-        {
-            return ((other.m_addr == m_addr) && (other.m_is_large == m_is_large) && (other.m_tid == m_tid));
-        }
-
-        friend std::ostream& operator << (std::ostream& out, const RequestDesc &rdesc)
-        {
-            out << std::hex << rdesc.m_addr << std::dec << "|" << rdesc.m_tid << "|" << rdesc.m_is_large << "|";
-            return out;
-        }
-};
-
-class RequestDescHasher {
-    public:
-	std::size_t operator () (const RequestDesc &r) const
-	{
-		using std::size_t;
-		using std::hash;
-
-		size_t res = 42;
-		res = res * 31 + hash<uint64_t>() (r.m_addr);
-	    res = res * 31 + hash<uint64_t>() (r.m_tid);
-		res = res * 31 + hash<bool>() (r.m_is_large);
-		return res;
-	}
-};
-
 class TraceProcessor {
 
 private:
-    trace_tlb_entry_t *buf1;
-    trace_tlb_tid_entry_t *buf2;
-    trace_shootdown_entry_t *buf3;
+    std::vector<const trace_tlb_entry_t*> buf1;
+    std::vector<const trace_tlb_tid_entry_t*> buf2;
+    const trace_shootdown_entry_t *buf3;
     char fmt[1024];
-    char trace[NUM_CORES][1024];
+    std::vector<std::string> trace;
     char shootdown[1024];
-    FILE *trace_fp[NUM_CORES];
-    FILE *shootdown_fp;
+    std::vector<TraceReader*> trace_reader;
+    TraceReader *shootdown_reader;
+    TraceReaderKind reader_kind;
+    TraceMerger merger;
     bool used_up_shootdown, empty_file_shootdown;
-    uint64_t *entry_count;
+    std::vector<uint64_t> entry_count;
     unsigned int num_cores;
     int global_index;
-    uint64_t *curr_ts;
+    std::vector<uint64_t> curr_ts;
+    Request *pending_burst;
+    uint64_t pending_burst_left;
+
+    //Draws the context switches of a TraceProcessor run next to others, see SweepSim and TimeParallelSim.
+    //A lone TraceProcessor has none and draws from rand(), as every -t run always has.
+    std::unique_ptr<std::mt19937> rng;
+
+    //Uniform in [0, 1]
+    double random_fraction()
+    {
+        return rng ? ((*rng)() / (double) std::mt19937::max()) : (rand() / (double) RAND_MAX);
+    }
+
+    //Grows the per-core config settings to hold num_cores cores
+    void resize_core_settings(unsigned int num_cores);
+
+    //Reader at the start of path, from trace_buffer if set, nullptr if path cannot be opened
+    TraceReader* open_reader(const char *path, bool is_shootdown);
     
 public:
     //Variables
-    bool *used_up, *empty_file;
-    uint64_t *last_ts;
+    std::vector<bool> used_up, empty_file;
+    std::vector<uint64_t> last_ts;
     uint64_t global_ts;
 #ifdef WARMUP
     uint64_t warmup_period = WARMUP;
 #else
     uint64_t warmup_period = 100000;
 #endif
+
+    //Scheme, shootdown penalty and benchmark name default to the build flags of old, config and command line override them
+#if defined(BASELINE) && defined(IDEAL)
+    TranslationCoherenceScheme scheme = IDEAL_SCHEME;
+#elif defined(BASELINE)
+    TranslationCoherenceScheme scheme = BASELINE_SCHEME;
+#elif defined(COTAG)
+    TranslationCoherenceScheme scheme = COTAG_SCHEME;
+#else
+    TranslationCoherenceScheme scheme = COTAGLESS_SCHEME;
+#endif
+#ifdef SHOOTDOWN_PENALTY
+    uint64_t shootdown_penalty = SHOOTDOWN_PENALTY;
+#else
+    uint64_t shootdown_penalty = 0;
+#endif
+#if BENCHMARK == 1
+    std::string benchmark = "httpd";
+#elif BENCHMARK == 3
+    std::string benchmark = "word_count";
+#else
+    std::string benchmark = "dedup";
+#endif
     bool is_multicore;
-    uint64_t total_instructions_in_real_run[NUM_CORES];
-    uint64_t ideal_cycles_in_real_run[NUM_CORES];
-    uint64_t num_tlb_misses_in_real_run[NUM_CORES];
-    double   avg_pw_cycles_in_real_run[NUM_CORES];
-    uint64_t l2d_lat, l3d_lat, vl_lat, dram_lat;
-    uint64_t   l3_small_tlb_size = 1024*1024;
-    uint64_t   l3_large_tlb_size = 256*1024;
+    std::vector<uint64_t> total_instructions_in_real_run;
+    std::vector<uint64_t> ideal_cycles_in_real_run;
+    std::vector<uint64_t> num_tlb_misses_in_real_run;
+    std::vector<double>   avg_pw_cycles_in_real_run;
     uint64_t context_switch_count;
     uint64_t tid_offset = 0;
+    uint64_t start_ts = 0;
+    //Requests stop at the first record with timestamp >= end_ts
+    uint64_t end_ts = UINT64_MAX;
     
-    std::unordered_map<RequestDesc, std::set<uint64_t>, RequestDescHasher> presence_map_small_page;
-    std::unordered_map<RequestDesc, std::set<uint64_t>, RequestDescHasher> presence_map_large_page;
+    //Decoded traces read in place of the files when set, see load_traces
+    const TraceBuffer *trace_buffer = nullptr;
+    
+    //Requests for core i come from request_pool[i]
+    RequestPool *request_pool;
+
+    //Cache and TLB geometry from the config
+    HierarchyConfig hier_config;
 
-    //Constructor
-    TraceProcessor(unsigned int num_cores = 8) : num_cores(num_cores)
+    //Cores holding each translation in their L1/L2 TLBs, shootdown victims are picked from here
+    PresenceTracker presence_small_page;
+    PresenceTracker presence_large_page;
+
+    //Constructor, own_rng: draw the context switches from a generator of its own, seeded the same for every TraceProcessor
+    TraceProcessor(unsigned int num_cores = 8, bool own_rng = false) : rng(own_rng ? new std::mt19937(1) : nullptr), presence_small_page(num_cores), presence_large_page(num_cores)
     {
-        buf1 = new trace_tlb_entry_t[num_cores];
-        buf2 = new trace_tlb_tid_entry_t[num_cores];
-        buf3 = new trace_shootdown_entry_t;
-        
-        used_up = new bool [num_cores];
-        empty_file = new bool [num_cores];
-        entry_count = new uint64_t [num_cores];
-        
-        last_ts = new uint64_t [num_cores];
-        curr_ts = new uint64_t [num_cores];
-
-        for(int i = 0; i < num_cores; i++)
-        {
-        	last_ts[i] = warmup_period;
-        }
+        buf3 = nullptr;
+        shootdown_reader = nullptr;
+        reader_kind = MMAP_TRACE_READER;
+        pending_burst = nullptr;
+        pending_burst_left = 0;
+        request_pool = nullptr;
 
-        global_ts = warmup_period;
+        set_num_cores(num_cores);
 
-        context_switch_count = (5000000 - 3000000) * (rand()/(double) RAND_MAX);
+        context_switch_count = (5000000 - 3000000) * random_fraction();
         std::cout << "Context switch count = " << context_switch_count << "\n";
 
         empty_file_shootdown = false;
@@ -123,20 +142,23 @@ public:
 
     ~TraceProcessor()
     {
-        delete [] buf1;
-        delete [] buf2;
-        delete buf3;
-
-        delete [] used_up;
-        delete [] empty_file;
-
-        delete [] entry_count;
-        
-        delete [] last_ts;
-        delete [] curr_ts;
+        for(int i = 0; i < trace_reader.size(); i++)
+        {
+            delete trace_reader[i];
+        }
+        delete shootdown_reader;
 
+        delete [] request_pool;
     }
     
+    //Sizes all per-core state for num_cores cores, settings of cores past the new count are dropped
+    void set_num_cores(unsigned int num_cores);
+
+    unsigned int get_num_cores()
+    {
+        return num_cores;
+    }
+
     //Methods
     void processPair(std::string name, std::string val);
     
@@ -147,9 +169,56 @@ public:
     int getNextEntry();
 
     void getShootdownEntry();
+
+    //Positions reader at the first record with timestamp >= start_ts and returns that record
+    template <typename T>
+    const T* seekToStart(TraceReader *reader)
+    {
+        //Indexed traces jump to the right chunk, the rest is a short scan
+        if(start_ts != 0)
+        {
+            reader->seek_ts(start_ts);
+        }
+
+        const T *rec = reader->next_record<T>();
+        while(rec != nullptr && rec->ts < start_ts)
+        {
+            rec = reader->next_record<T>();
+        }
+
+        return rec;
+    }
     
     Request* generateRequest();
 
+    //Moves end_ts further out once every request up to the old one has been handed out,
+    //streams that stopped at the old end_ts pick up where they stopped
+    void extend(uint64_t end_ts);
+
+    //Timestamp past the last record of the traces, from their last record or chunk index
+    uint64_t find_end_ts();
+
+    //Reads the traces and the shootdown file of the config into buffer, unless already there, and reads them from buffer from now on
+    void load_traces(TraceBuffer &buffer);
+
+    //Whether every request has been handed out, generateRequest only returns nullptr from here on
+    bool is_exhausted()
+    {
+        return (pending_burst == nullptr) && (is_multicore ? merger.empty() : empty_file[0]);
+    }
+
+    //Whether generateRequest may still hand a request to core core_id.
+    //Streams of a multicore trace belong to one core each, a single trace may hand any core a request until it is exhausted.
+    bool is_pending(unsigned int core_id)
+    {
+        if(!is_multicore)
+        {
+            return !is_exhausted();
+        }
+
+        return !empty_file[core_id] || (pending_burst != nullptr && pending_burst->m_core_id == core_id);
+    }
+
     uint64_t switch_threads();
 
     void add_to_presence_map(Request &r);
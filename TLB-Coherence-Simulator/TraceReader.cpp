@@ -0,0 +1,437 @@
+//
+//  TraceReader.cpp
+//  TLB-Coherence-Simulator
+//
+//  Copyright © 2018 Yashwant Marathe. All rights reserved.
+//
+
+#include "TraceReader.hpp"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstring>
+#include <assert.h>
+
+//Hand consumed pages back to the kernel in steps of this many bytes
+#define MMAP_RELEASE_STRIDE (64 * 1024 * 1024)
+
+//Records of record_size bytes the file behind fp holds, 0 if its size is unknown (pipes, special files)
+static size_t getFileNumRecords(FILE *fp, size_t record_size)
+{
+    struct stat st;
+
+    if(fstat(fileno(fp), &st) != 0 || !S_ISREG(st.st_mode))
+    {
+        return 0;
+    }
+
+    return (size_t) st.st_size / record_size;
+}
+
+TraceReader* TraceReader::create(TraceReaderKind kind)
+{
+    switch(kind)
+    {
+        case STDIO_TRACE_READER:
+            return new StdioTraceReader();
+        case ASYNC_TRACE_READER:
+            return new AsyncTraceReader();
+        case MMAP_TRACE_READER:
+        default:
+            return new MmapTraceReader();
+    }
+}
+
+StdioTraceReader::~StdioTraceReader()
+{
+    if(m_fp)
+    {
+        fclose(m_fp);
+    }
+    delete [] m_buf;
+}
+
+bool StdioTraceReader::open(const char *path)
+{
+    m_fp = fopen(path, "r");
+    if(m_fp == nullptr)
+    {
+        return false;
+    }
+
+    m_buf = new char[BUF_SIZE];
+    m_ptr = m_end = m_buf;
+    return true;
+}
+
+const char* StdioTraceReader::peek(size_t want, size_t &avail)
+{
+    assert(want <= BUF_SIZE);
+
+    if((size_t)(m_end - m_ptr) < want && !m_eof)
+    {
+        //Move the unread tail to the front and refill behind it
+        size_t leftover = m_end - m_ptr;
+        memmove(m_buf, m_ptr, leftover);
+        m_ptr = m_buf;
+        m_end = m_buf + leftover;
+
+        size_t size = fread(m_end, 1, BUF_SIZE - leftover, m_fp);
+        m_end += size;
+        m_eof = (size < BUF_SIZE - leftover);
+    }
+
+    avail = m_end - m_ptr;
+    return m_ptr;
+}
+
+void StdioTraceReader::consume(size_t size)
+{
+    assert(size <= (size_t)(m_end - m_ptr));
+    m_ptr += size;
+}
+
+bool StdioTraceReader::seek(size_t offset)
+{
+    if(fseek(m_fp, (long) offset, SEEK_SET) != 0)
+    {
+        return false;
+    }
+
+    m_ptr = m_end = m_buf;
+    m_eof = false;
+    return true;
+}
+
+size_t StdioTraceReader::get_num_records(size_t record_size)
+{
+    return getFileNumRecords(m_fp, record_size);
+}
+
+MmapTraceReader::~MmapTraceReader()
+{
+    if(m_base)
+    {
+        munmap((void*)m_base, m_size);
+    }
+
+    if(m_fd != -1)
+    {
+        close(m_fd);
+    }
+}
+
+bool MmapTraceReader::open(const char *path)
+{
+    struct stat st;
+
+    m_fd = ::open(path, O_RDONLY);
+    if(m_fd == -1)
+    {
+        return false;
+    }
+
+    if(fstat(m_fd, &st) != 0)
+    {
+        return false;
+    }
+
+    m_size = (size_t) st.st_size;
+    m_offset = 0;
+    m_released = 0;
+
+    //Nothing to map, next() reports end of trace straight away
+    if(m_size == 0)
+    {
+        return true;
+    }
+
+    void *base = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+    if(base == MAP_FAILED)
+    {
+        std::cout << "[Error] Could not map " << path << std::endl;
+        return false;
+    }
+
+    m_base = static_cast<const char*>(base);
+    madvise(base, m_size, MADV_SEQUENTIAL);
+    madvise(base, (m_size < MMAP_RELEASE_STRIDE) ? m_size : MMAP_RELEASE_STRIDE, MADV_WILLNEED);
+
+    return true;
+}
+
+void MmapTraceReader::release_consumed()
+{
+    //Keep one stride behind the cursor mapped in, the last records handed out may still be in use
+    size_t upto = ((m_offset / MMAP_RELEASE_STRIDE) - 1) * MMAP_RELEASE_STRIDE;
+    madvise((void*)(m_base + m_released), upto - m_released, MADV_DONTNEED);
+    m_released = upto;
+
+    //Ask for the stride after the current one ahead of time
+    size_t ahead = ((m_offset / MMAP_RELEASE_STRIDE) + 1) * MMAP_RELEASE_STRIDE;
+    if(ahead < m_size)
+    {
+        madvise((void*)(m_base + ahead), ((m_size - ahead) < MMAP_RELEASE_STRIDE) ? (m_size - ahead) : MMAP_RELEASE_STRIDE, MADV_WILLNEED);
+    }
+}
+
+const char* MmapTraceReader::peek(size_t /*want*/, size_t &avail)
+{
+    avail = m_size - m_offset;
+    return m_base + m_offset;
+}
+
+void MmapTraceReader::consume(size_t size)
+{
+    assert(size <= m_size - m_offset);
+    m_offset += size;
+
+    if((m_offset - m_released) > 2 * MMAP_RELEASE_STRIDE)
+    {
+        release_consumed();
+    }
+}
+
+bool MmapTraceReader::seek(size_t offset)
+{
+    if(offset > m_size)
+    {
+        return false;
+    }
+
+    m_offset = offset;
+
+    //Pages before the new position may have been released, they fault back in from the file on demand
+    m_released = (offset / MMAP_RELEASE_STRIDE) * MMAP_RELEASE_STRIDE;
+    if(m_offset < m_size)
+    {
+        madvise((void*)(m_base + m_released), ((m_size - m_released) < MMAP_RELEASE_STRIDE) ? (m_size - m_released) : MMAP_RELEASE_STRIDE, MADV_WILLNEED);
+    }
+
+    return true;
+}
+
+size_t MmapTraceReader::get_num_records(size_t record_size)
+{
+    return m_size / record_size;
+}
+
+AsyncTraceReader::~AsyncTraceReader()
+{
+    stop();
+
+    for(int i = 0; i < NUM_SLOTS; i++)
+    {
+        delete [] m_slots[i].buf;
+    }
+
+    if(m_fp)
+    {
+        fclose(m_fp);
+    }
+}
+
+bool AsyncTraceReader::open(const char *path)
+{
+    m_fp = fopen(path, "r");
+    if(m_fp == nullptr)
+    {
+        return false;
+    }
+
+    //Blocks are fread straight into the slots, skip the stdio buffer
+    setvbuf(m_fp, nullptr, _IONBF, 0);
+
+    for(int i = 0; i < NUM_SLOTS; i++)
+    {
+        m_slots[i].buf = new char[MAX_RECORD_SIZE + m_block_size];
+    }
+
+    start();
+
+    return true;
+}
+
+void AsyncTraceReader::start()
+{
+    for(int i = 0; i < NUM_SLOTS; i++)
+    {
+        m_slots[i].size = 0;
+        m_slots[i].full = false;
+    }
+
+    m_stop = false;
+    m_eof = false;
+    m_producer = std::thread(&AsyncTraceReader::produce, this);
+
+    //Wait for the first block
+    m_cur = NUM_SLOTS - 1;
+    m_ptr = m_end = nullptr;
+    advance_slot();
+}
+
+void AsyncTraceReader::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cv.notify_all();
+
+    if(m_producer.joinable())
+    {
+        m_producer.join();
+    }
+}
+
+bool AsyncTraceReader::seek(size_t offset)
+{
+    //Blocks already read ahead belong to the old position, restart the producer behind the new one
+    stop();
+
+    if(fseek(m_fp, (long) offset, SEEK_SET) != 0)
+    {
+        return false;
+    }
+
+    start();
+    return true;
+}
+
+size_t AsyncTraceReader::get_num_records(size_t record_size)
+{
+    return getFileNumRecords(m_fp, record_size);
+}
+
+void AsyncTraceReader::produce()
+{
+    unsigned int slot = 0;
+
+    while(true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [this, slot] { return m_stop || !m_slots[slot].full; });
+            if(m_stop)
+            {
+                return;
+            }
+        }
+
+        size_t size = fread(m_slots[slot].buf + MAX_RECORD_SIZE, 1, m_block_size, m_fp);
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_slots[slot].size = size;
+            m_slots[slot].full = true;
+        }
+        m_cv.notify_all();
+
+        //An empty block marks the end of the trace
+        if(size == 0)
+        {
+            return;
+        }
+
+        slot = (slot + 1) % NUM_SLOTS;
+    }
+}
+
+bool AsyncTraceReader::advance_slot()
+{
+    unsigned int next_slot = (m_cur + 1) % NUM_SLOTS;
+    Slot &next = m_slots[next_slot];
+
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_cv.wait(lock, [&next] { return next.full; });
+    }
+
+    //End of trace, keep the current slot so records handed out so far stay valid
+    if(next.size == 0)
+    {
+        m_eof = true;
+        return false;
+    }
+
+    //Move the partial record in front of the new block
+    size_t leftover = m_end - m_ptr;
+    assert(leftover <= MAX_RECORD_SIZE);
+    char *start = next.buf + MAX_RECORD_SIZE - leftover;
+    if(leftover > 0)
+    {
+        memcpy(start, m_ptr, leftover);
+    }
+
+    //Hand the consumed slot back to the producer
+    if(m_ptr != nullptr)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_slots[m_cur].full = false;
+        }
+        m_cv.notify_all();
+    }
+
+    m_cur = next_slot;
+    m_ptr = start;
+    m_end = next.buf + MAX_RECORD_SIZE + next.size;
+
+    return true;
+}
+
+const char* AsyncTraceReader::peek(size_t want, size_t &avail)
+{
+    assert(want <= MAX_RECORD_SIZE);
+
+    while((size_t)(m_end - m_ptr) < want)
+    {
+        if(m_eof || !advance_slot())
+        {
+            break;
+        }
+    }
+
+    avail = m_end - m_ptr;
+    return m_ptr;
+}
+
+void AsyncTraceReader::consume(size_t size)
+{
+    assert(size <= (size_t)(m_end - m_ptr));
+    m_ptr += size;
+}
+
+bool MemoryTraceReader::open(const char * /*path*/)
+{
+    return false;
+}
+
+const char* MemoryTraceReader::peek(size_t /*want*/, size_t &avail)
+{
+    avail = m_data->size() - m_offset;
+    return m_data->data() + m_offset;
+}
+
+void MemoryTraceReader::consume(size_t size)
+{
+    assert(size <= m_data->size() - m_offset);
+    m_offset += size;
+}
+
+bool MemoryTraceReader::seek(size_t offset)
+{
+    if(offset > m_data->size())
+    {
+        return false;
+    }
+
+    m_offset = offset;
+    return true;
+}
+
+size_t MemoryTraceReader::get_num_records(size_t record_size)
+{
+    return m_data->size() / record_size;
+}
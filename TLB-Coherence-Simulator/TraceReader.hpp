@@ -0,0 +1,196 @@
+//
+//  TraceReader.hpp
+//  TLB-Coherence-Simulator
+//
+//  Copyright © 2018 Yashwant Marathe. All rights reserved.
+//
+
+#ifndef TraceReader_hpp
+#define TraceReader_hpp
+
+#include <iostream>
+#include <cstdio>
+#include <cstdint>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <memory>
+
+typedef enum {
+    STDIO_TRACE_READER,
+    MMAP_TRACE_READER,
+    ASYNC_TRACE_READER,
+} TraceReaderKind;
+
+//Interface class for trace sources
+//Bytes are handed out as pointers into reader owned memory.
+//A pointer stays valid until the next call to peek() or next() on the same reader.
+class TraceReader {
+public:
+    virtual bool open(const char *path) = 0;
+
+    //Returns pointer to the unread bytes without moving past them.
+    //avail is set to the number of bytes there, at least want unless the trace ends first.
+    virtual const char* peek(size_t want, size_t &avail) = 0;
+
+    virtual void consume(size_t size) = 0;
+
+    //Moves to byte offset from the start of the trace, returns false if the position cannot be reached
+    virtual bool seek(size_t offset) = 0;
+
+    //Moves to a position at or before the first record with timestamp >= ts.
+    //Returns false if the trace has no index, the caller then has to scan for ts itself.
+    virtual bool seek_ts(uint64_t /*ts*/)
+    {
+        return false;
+    }
+
+    //Records of record_size bytes in the whole trace, 0 if the reader cannot tell before reading them
+    virtual size_t get_num_records(size_t /*record_size*/)
+    {
+        return 0;
+    }
+
+    //Returns pointer to the next size bytes and moves past them, nullptr if fewer than size bytes remain
+    virtual const void* next(size_t size)
+    {
+        size_t avail;
+        const char *rec = peek(size, avail);
+
+        if(avail < size)
+        {
+            return nullptr;
+        }
+
+        consume(size);
+        return rec;
+    }
+
+    virtual ~TraceReader() {}
+
+    template <typename T>
+    const T* next_record()
+    {
+        return static_cast<const T*>(next(sizeof(T)));
+    }
+
+    static TraceReader* create(TraceReaderKind kind);
+};
+
+//Buffered fread.
+//Fallback for inputs that cannot be mapped (pipes, special files).
+class StdioTraceReader : public TraceReader {
+private:
+    static const size_t BUF_SIZE = 64 * 1024;
+
+    FILE *m_fp;
+    char *m_buf;
+    char *m_ptr;
+    char *m_end;
+    bool m_eof;
+
+public:
+    StdioTraceReader() : m_fp(nullptr), m_buf(nullptr), m_ptr(nullptr), m_end(nullptr), m_eof(false) {}
+
+    ~StdioTraceReader();
+
+    virtual bool open(const char *path) override final;
+    virtual const char* peek(size_t want, size_t &avail) override final;
+    virtual void consume(size_t size) override final;
+    virtual bool seek(size_t offset) override final;
+    virtual size_t get_num_records(size_t record_size) override final;
+};
+
+//Maps the whole trace and walks the records in place, no per-record copy.
+//Pages behind the cursor are handed back to the kernel so resident memory stays bounded on long traces.
+class MmapTraceReader : public TraceReader {
+private:
+    int m_fd;
+    const char *m_base;
+    size_t m_size;
+    size_t m_offset;
+    size_t m_released;
+
+    void release_consumed();
+
+public:
+    MmapTraceReader() : m_fd(-1), m_base(nullptr), m_size(0), m_offset(0), m_released(0) {}
+
+    ~MmapTraceReader();
+
+    virtual bool open(const char *path) override final;
+    virtual const char* peek(size_t want, size_t &avail) override final;
+    virtual void consume(size_t size) override final;
+    virtual bool seek(size_t offset) override final;
+    virtual size_t get_num_records(size_t record_size) override final;
+};
+
+//Reads the trace in large blocks on a background thread.
+//Two slots are filled in turn, the simulation thread only walks a slot that is already resident,
+//so I/O on slow storage overlaps with simulation.
+class AsyncTraceReader : public TraceReader {
+private:
+    //Bytes of a record that straddles two blocks are copied in front of the next block
+    //Bounds how much peek() can ask for across a block boundary
+    static const size_t MAX_RECORD_SIZE = 64;
+    static const size_t NUM_SLOTS = 2;
+
+    class Slot {
+    public:
+        char *buf;
+        size_t size;
+        bool full;
+
+        Slot() : buf(nullptr), size(0), full(false) {}
+    };
+
+    FILE *m_fp;
+    size_t m_block_size;
+    Slot m_slots[NUM_SLOTS];
+    unsigned int m_cur;
+    const char *m_ptr;
+    const char *m_end;
+    bool m_eof;
+
+    bool m_stop;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::thread m_producer;
+
+    void produce();
+    bool advance_slot();
+    void start();
+    void stop();
+
+public:
+    AsyncTraceReader(size_t block_size = 4 * 1024 * 1024) : m_fp(nullptr), m_block_size(block_size), m_cur(0), m_ptr(nullptr), m_end(nullptr), m_eof(false), m_stop(false) {}
+
+    ~AsyncTraceReader();
+
+    virtual bool open(const char *path) override final;
+    virtual const char* peek(size_t want, size_t &avail) override final;
+    virtual void consume(size_t size) override final;
+    virtual bool seek(size_t offset) override final;
+    virtual size_t get_num_records(size_t record_size) override final;
+};
+
+//Walks records already in memory, shared read-only with other readers, see TraceBuffer.
+//Every reader has a cursor of its own, so readers on different threads can walk the same bytes.
+class MemoryTraceReader : public TraceReader {
+private:
+    std::shared_ptr<const std::vector<char>> m_data;
+    size_t m_offset;
+
+public:
+    MemoryTraceReader(std::shared_ptr<const std::vector<char>> data) : m_data(data), m_offset(0) {}
+
+    //Bytes come from the buffer handed to the constructor, there is no file to open
+    virtual bool open(const char *path) override final;
+    virtual const char* peek(size_t want, size_t &avail) override final;
+    virtual void consume(size_t size) override final;
+    virtual bool seek(size_t offset) override final;
+    virtual size_t get_num_records(size_t record_size) override final;
+};
+
+#endif /* TraceReader_hpp */
@@ -8,478 +8,183 @@
 
 #include <iostream>
 #include <fstream>
-#include "Cache.hpp"
-#include "CacheSys.hpp"
-#include "ROB.hpp"
-#include "Core.hpp"
+#include <chrono>
+#include "Simulator.hpp"
+#include "TimeParallelSim.hpp"
+#include "SweepSim.hpp"
 #include "TraceProcessor.hpp"
+#include "Benchmark.hpp"
 #include <memory>
 #include "utils.hpp"
 
-#ifndef NUM_TRACES_PER_CORE
-    #define NUM_TRACES_PER_CORE 1660000000L
-#endif
-#define NUM_INITIAL_FILL 100 
-#define STRING(s) #s
-
 int main(int argc, char * argv[])
 {
     int num_args = 1;
     int num_real_args = num_args + 1;
-    uint64_t num_total_traces;
-#if BENCHMARK == 1
-    std::string benchmark = "httpd";
-#elif BENCHMARK == 2
-    std::string benchmark = "dedup";
-#elif BENCHMARK == 3
-    std::string benchmark = "word_count";
-#else
-    std::string benchmark = "dedup";
-#endif
+    unsigned int num_threads = 0;
+    unsigned int quantum = 0;
+    unsigned int num_segments = 0;
+    uint64_t overlap = 1000000;
     
-    TraceProcessor tp(8);
+    Simulator sim;
+    TraceProcessor &tp = sim.tp;
     if (argc < num_real_args)
     {
         std::cout << "Program takes " << num_args << " arguments" << std::endl;
         std::cout << "Path name of input config file" << std::endl;
+        std::cout << "Optionally followed by -scheme <baseline|ideal|cotag|cotagless>, -penalty <shootdown penalty> and -benchmark <name>" << std::endl;
+        std::cout << "and by -threads <worker threads> [-quantum <cycles between barriers, default the lookahead>] to tick the cores in parallel" << std::endl;
+        std::cout << "or by -segments <segments> [-overlap <warm-up timestamps>] to simulate slices of the trace in parallel" << std::endl;
+        std::cout << "Or -sweep <threads> <config> [<config> ...] to simulate several configs over traces read once" << std::endl;
         exit(0);
     }
-    
-    char* input_cfg=argv[1];
-    
-    tp.parseAndSetupInputs(input_cfg);
-    
-    tp.verifyOpenTraceFiles();
-
-    if(tp.is_multicore)
-    {
-        num_total_traces = NUM_TRACES_PER_CORE * NUM_CORES;
-    }
-    else
-    {
-        num_total_traces = NUM_TRACES_PER_CORE;
-    }
-
-    std::ofstream outFile;
-#ifdef BASELINE
-#ifdef IDEAL
-    std::cout << ("Opening " + benchmark + "_baseline_ideal.out") << std::endl;
-    outFile.open(benchmark + "_baseline_ideal.out");
-#else
-    std::cout << ("Opening " + benchmark + "_baseline.out") << std::endl;
-    outFile.open(benchmark + "_baseline.out");
-#endif
-#else
-#ifdef COTAG
-    std::cout << ("Opening " + benchmark + "_cotag.out") << std::endl;
-    outFile.open(benchmark + "_cotag.out");
-#else
-    std::cout << ("Opening " + benchmark + "_cotagless.out") << std::endl;
-    outFile.open(benchmark + "_cotagless.out");
-#endif
-#endif
-    
-    std::shared_ptr<Cache> llc = std::make_shared<Cache>(Cache(8192, 16, 64, 38,  DATA_AND_TRANSLATION));
-    
-    bool ll_interface_complete = false;
-    
-    std::shared_ptr<Cache> l3_tlb_small = std::make_shared<Cache>(Cache(16384, 4, 4096, 75, TRANSLATION_ONLY));
-    std::shared_ptr<Cache> l3_tlb_large = std::make_shared<Cache>(Cache(4096, 4, 2 * 1024 * 1024, 75, TRANSLATION_ONLY, true));
-   
-    /* 
-    std::shared_ptr<Cache> l3_tlb_small = std::make_shared<Cache>(Cache(8, 8, 4096, 1, TRANSLATION_ONLY));
-    std::shared_ptr<Cache> l3_tlb_large = std::make_shared<Cache>(Cache(8, 8, 2 * 1024 * 1024, 1, TRANSLATION_ONLY, true));
-    */
 
-    std::vector<std::shared_ptr<CacheSys>> data_hier;
-    std::vector<std::shared_ptr<CacheSys>> tlb_hier;
-    std::vector<std::shared_ptr<Cache>> l1_data_caches;
-    std::vector<std::shared_ptr<Cache>> l2_data_caches;
-    
-    std::vector<std::shared_ptr<Cache>> l1_tlb;
-    std::vector<std::shared_ptr<Cache>> l2_tlb;
-    
-    std::vector<std::shared_ptr<ROB>> rob_arr;
-    
-    std::vector<std::shared_ptr<Core>> cores;
-    
-    for(int i = 0; i < NUM_CORES; i++)
+    //Trace conversion: -convert <raw trace> <compact trace> [-m|-t]
+    if (strcmp(argv[1], "-convert") == 0)
     {
-        data_hier.push_back(std::make_shared<CacheSys>(CacheSys(false)));
-        l1_data_caches.push_back(std::make_shared<Cache>(Cache(64, 8, 64, 4, DATA_ONLY)));
-        l2_data_caches.push_back(std::make_shared<Cache>(Cache(1024, 4, 64, 12, DATA_AND_TRANSLATION)));
-        
-        data_hier[i]->add_cache_to_hier(l1_data_caches[i]);
-        data_hier[i]->add_cache_to_hier(l2_data_caches[i]);
-        data_hier[i]->add_cache_to_hier(llc);
-        
-        tlb_hier.push_back(std::make_shared<CacheSys>(CacheSys(true)));
-        
-        /*l1_tlb.push_back(std::make_shared<Cache>(Cache(2, 2, 4096, 1, TRANSLATION_ONLY)));
-        l1_tlb.push_back(std::make_shared<Cache>(Cache(1, 2, 2 * 1024 * 1024, 1, TRANSLATION_ONLY, true)));
-        l2_tlb.push_back(std::make_shared<Cache>(Cache(4, 4, 4096, 1, TRANSLATION_ONLY)));
-        l2_tlb.push_back(std::make_shared<Cache>(Cache(4, 4, 2 * 1024 * 1024, 1, TRANSLATION_ONLY, true)));*/
-        
-        l1_tlb.push_back(std::make_shared<Cache>(Cache(16, 4, 4096, 1, TRANSLATION_ONLY)));
-        l1_tlb.push_back(std::make_shared<Cache>(Cache(8, 4, 2 * 1024 * 1024, 1, TRANSLATION_ONLY, true)));
-        l2_tlb.push_back(std::make_shared<Cache>(Cache(64, 16, 4096, 14, TRANSLATION_ONLY)));
-        l2_tlb.push_back(std::make_shared<Cache>(Cache(32, 16, 2 * 1024 * 1024, 14, TRANSLATION_ONLY, true)));
-
-        l1_tlb[2 * i]->add_traceprocessor(&tp);
-        l1_tlb[2 * i + 1]->add_traceprocessor(&tp);
-        l2_tlb[2 * i]->add_traceprocessor(&tp);
-        l2_tlb[2 * i + 1]->add_traceprocessor(&tp);
-       
-        tlb_hier[i]->add_cache_to_hier(l1_tlb[2 * i]);
-        tlb_hier[i]->add_cache_to_hier(l1_tlb[2 * i + 1]);
-        tlb_hier[i]->add_cache_to_hier(l2_tlb[2 * i]);
-        tlb_hier[i]->add_cache_to_hier(l2_tlb[2 * i + 1]);
-        tlb_hier[i]->add_cache_to_hier(l3_tlb_small);
-        tlb_hier[i]->add_cache_to_hier(l3_tlb_large);
-        
-        rob_arr.push_back(std::make_shared<ROB>(ROB()));
-        
-        cores.push_back(std::make_shared<Core>(Core(data_hier[i], tlb_hier[i], rob_arr[i])));
-
-        data_hier[i]->set_core(cores[i]);
-        tlb_hier[i]->set_core(cores[i]);
-        
-        cores[i]->set_core_id(i);
-        
-        ll_interface_complete = cores[i]->interfaceHier(ll_interface_complete);
-    }
-
-    //Make cores aware of each other
-    for(int i = 0; i < NUM_CORES; i++)
-    {
-        for(int j = 0; j < NUM_CORES; j++)
+        if (argc < 4)
         {
-            if(i != j)
-            {
-                cores[i]->add_core(cores[j]);
-            }
+            std::cout << "Usage: " << argv[0] << " -convert <raw trace> <compact trace> [-m|-t]" << std::endl;
+            exit(0);
         }
-    }
-    
-    //Make cache hierarchies aware of each other
-    for(int i = 0; i < NUM_CORES; i++)
-    {
-        for(int j = 0; j < NUM_CORES; j++)
-        {
-            if(i != j)
-            {
-                //Data caches see other data caches
-                data_hier[i]->add_cachesys(data_hier[j]);
 
-                //TLB see other data caches
-                tlb_hier[i]->add_cachesys(data_hier[j]);
-            }
-        }
+        TraceRecordKind rec_kind = (argc > 4 && strcmp(argv[4], "-t") == 0) ? TLB_TID_RECORD : TLB_RECORD;
+        return convertTrace(argv[2], argv[3], rec_kind) ? 0 : 1;
     }
 
-    for(int i = 0; i < NUM_CORES; i++)
+    //Microbenchmarks: -bench <name> [args]
+    if (strcmp(argv[1], "-bench") == 0)
     {
-        for(int j = 0; j < NUM_CORES; j++)
-        {
-            if(i != j)
-            {
-                //Data caches see other TLBs 
-                //Done this way because indexing is dependent on having all data caches first, and then all the TLBs
-                data_hier[i]->add_cachesys(tlb_hier[j]);
-            }
-        }
+        return runBenchmark(argc - 2, argv + 2);
     }
 
-    uint64_t num_traces_added = 0;
-
-    std::cout << "Initial fill\n";
-    for(int i = 0; i < NUM_INITIAL_FILL; i++)
+    //Configuration sweep: -sweep <threads> <config> [<config> ...]
+    if (strcmp(argv[1], "-sweep") == 0)
     {
-        Request *r = tp.generateRequest();
-
-        //std::cout << "Request = " << std::hex << (*r) << std::dec;
-
-        if((r != nullptr) && r->m_core_id >=0 && r->m_core_id < NUM_CORES)
+        if (argc < 4 || strtoul(argv[2], NULL, 10) == 0)
         {
-                cores[r->m_core_id]->add_trace(r);
-                num_traces_added += int(r->m_is_memory_acc);
-        } 
-    }
-    std::cout << "Initial fill done\n";
-
-   bool done = false;
-   bool timeout = false;
-   while(!done && !timeout)
-   {
-	done = true;
-   	for(int i = 0; i < NUM_CORES; i++)
-   	{
-	   cores[i]->tick();
-       
-       //if((num_traces_added < num_total_traces) && (cores[i]->must_add_trace()))
-       if(num_traces_added < num_total_traces)
-       {
-           Request *r = tp.generateRequest();
-
-           //std::cout << "Request = " << std::hex << (*r) << std::dec;
-
-           if((r != nullptr) && r->m_core_id >= 0 && r->m_core_id < NUM_CORES)
-           {
-               if(cores[r->m_core_id]->must_add_trace())
-               {
-                    num_traces_added +=  int(r->m_is_memory_acc);
-                    cores[r->m_core_id]->add_trace(r);
-               }
-               else
-               {
-                    tp.used_up[0] = false;
-               }
-           }
-           
-           if(num_traces_added % 1000000 == 0)
-           {
-               std::cout << "[NUM_TRACES_ADDED] Count = " << num_traces_added << "\n";
-           }
-
-           //if(r != nullptr)
-           //{
-           //    num_traces_added +=  int(r->m_is_memory_acc);
-           //}
-       }
-
-	   done = done & cores[i]->is_done() && (cores[i]->traceVec.size() == 0);
-       if((cores[i]->m_clk + cores[i]->num_stall_cycles) > NUM_TRACES_PER_CORE * 5)
-	   {
-		   //std::cout << "Core " << i << " timed out " << std::endl;
-		   //std::cout << "Blocking request = " ; cores[i]->m_rob->peek_commit_ptr();
-           for(int j = 0; j < NUM_CORES; j++)
-           {
-               if(cores[j]->traceVec.size())
-               {
-                   std::cout << "Core " << j << " has unserviced requests = " << cores[j]->traceVec.size() << "\n";
-               }
+            std::cout << "Usage: " << argv[0] << " -sweep <threads> <config> [<config> ...]" << std::endl;
+            exit(0);
+        }
 
-               if(!cores[j]->is_done())
-               {
-                   std::cout << "Core " << j << " NOT done\n";
-		           std::cout << "Blocking request = " ; cores[j]->m_rob->peek_commit_ptr();
-                   std::cout << "Core clk = " << cores[j]->m_clk << "\n";
-               }
+        unsigned int sweep_threads = strtoul(argv[2], NULL, 10);
+        std::vector<std::string> configs(argv + 3, argv + argc);
 
-               if(cores[j]->stall)
-               {
-                   std::cout << "Core " << j << " STALLED\n";
-               }
+        auto start = std::chrono::steady_clock::now();
+        SweepSim sweep(configs);
+        std::cout << "[SWEEP] Configs = " << configs.size() << ", worker threads = " << sweep_threads << ", trace bytes in memory = " << sweep.get_traces().get_memory_usage() << ", seconds reading = " << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() << "\n";
 
-               if(!cores[j]->m_rob->can_issue())
-               {
-                   std::cout << "Core " << j << " can't issue\n";
-               }
-           }
-		   timeout = true;
-	   }
- 	}
-   }
+        sweep.run(sweep_threads);
+        std::cout << "[SIMULATION_TIME] Seconds = " << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() << "\n";
+        return 0;
+    }
 
-    uint64_t total_num_cycles = 0;
-    uint64_t total_stall_cycles = 0;
-    uint64_t total_shootdowns = 0;
-    uint64_t total_instructions = 0;
-    uint64_t total_num_data_coh_msgs = 0;
-    uint64_t total_num_tr_coh_msgs = 0;
-    double l1d_agg_mpki;
-    double l2d_agg_mpki;
-    double l1ts_agg_mpki;
-    double l1tl_agg_mpki;
-    double l2ts_agg_mpki;
-    double l2tl_agg_mpki;
+    char* input_cfg=argv[1];
+    
+    tp.parseAndSetupInputs(input_cfg);
 
-    for(int i = 0; i < NUM_CORES;i++)
+    //Command line overrides the config
+    for (int i = 2; i < argc; i += 2)
     {
-        //cores[i]->m_rob->printContents();
-        //
-        outFile << "--------Core " << i << " -------------" << "\n";
-        if(tp.is_multicore)
-        {
-            outFile << "Cycles = " << cores[i]->m_clk << "\n";
-            outFile << "Instructions = " << (cores[i]->m_num_retired) << "\n";
-            if(cores[i]->m_clk > 0)
-            {
-                outFile << "IPC = " << (double) (cores[i]->m_num_retired)/(cores[i]->m_clk) << "\n";
-            }
-            outFile << "Stall cycles = " << cores[i]->num_stall_cycles << "\n";
-            outFile << "Num shootdowns = " << cores[i]->num_shootdown << "\n";
-            total_instructions = cores[i]->m_num_retired;
-        }
-        else
+        if (i + 1 == argc)
         {
-            outFile << "Cycles = " << cores[i]->m_clk << "\n";
-            outFile << "Instructions = " << (cores[i]->m_num_retired) << "\n";
-            outFile << "Stall cycles = " << cores[i]->num_stall_cycles << "\n";
-            outFile << "Num shootdowns = " << cores[i]->num_shootdown << "\n";
-            total_num_cycles += cores[i]->m_clk;
-            total_stall_cycles += cores[i]->num_stall_cycles;
-            total_shootdowns += cores[i]->num_shootdown;
-            total_instructions += cores[i]->m_num_retired;
+            std::cout << "[Error] Option " << argv[i] << " needs a value" << std::endl;
+            exit(0);
         }
 
-        outFile << "[L1 D$] data hits = " << l1_data_caches[i]->num_data_hits << "\n";
-        outFile << "[L1 D$] translation hits = " << l1_data_caches[i]->num_tr_hits << "\n";
-        outFile << "[L1 D$] data misses = " << l1_data_caches[i]->num_data_misses << "\n";
-        outFile << "[L1 D$] translation misses = " << l1_data_caches[i]->num_tr_misses << "\n";
-        outFile << "[L1 D$] MSHR data hits = " << l1_data_caches[i]->num_mshr_data_hits << "\n";
-        outFile << "[L1 D$] MSHR translation hits = " << l1_data_caches[i]->num_mshr_tr_hits << "\n";
-        outFile << "[L1 D$] data accesses = " << l1_data_caches[i]->num_data_accesses << "\n";
-        outFile << "[L1 D$] translation accesses = " << l1_data_caches[i]->num_tr_accesses << "\n";
-        if(cores[i]->m_num_retired)
+        if (strcmp(argv[i], "-scheme") == 0)
         {
-            double l1d_mpki = (double) (l1_data_caches[i]->num_data_misses * 1000.0)/(cores[i]->m_num_retired);
-            outFile << "[L1 D$] MPKI = " << l1d_mpki << "\n";
-            if(!tp.is_multicore) l1d_agg_mpki += l1d_mpki;
-        }
-
-        outFile << "[L2 D$] data hits = " << l2_data_caches[i]->num_data_hits << "\n";
-        outFile << "[L2 D$] translation hits = " << l2_data_caches[i]->num_tr_hits << "\n";
-        outFile << "[L2 D$] data misses = " << l2_data_caches[i]->num_data_misses << "\n";
-        outFile << "[L2 D$] translation misses = " << l2_data_caches[i]->num_tr_misses << "\n";
-        outFile << "[L2 D$] MSHR data hits = " << l2_data_caches[i]->num_mshr_data_hits << "\n";
-        outFile << "[L2 D$] MSHR translation hits = " << l2_data_caches[i]->num_mshr_tr_hits << "\n";
-        outFile << "[L2 D$] data accesses = " << l2_data_caches[i]->num_data_accesses << "\n";
-        outFile << "[L2 D$] translation accesses = " << l2_data_caches[i]->num_tr_accesses << "\n";
-        if(cores[i]->m_num_retired)
-        {
-            double l2d_mpki = (double) ((l2_data_caches[i]->num_data_misses  + l2_data_caches[i]->num_tr_misses)* 1000.0)/(cores[i]->m_num_retired);
-            outFile << "[L2 D$] MPKI = " << l2d_mpki << "\n";
-            if(!tp.is_multicore) l2d_agg_mpki += l2d_mpki;
+            if (!parseScheme(argv[i + 1], tp.scheme))
+            {
+                std::cout << "[Error] Unknown translation coherence scheme " << argv[i + 1] << std::endl;
+                exit(0);
+            }
         }
-
-        outFile << "[L1 SMALL TLB] data hits = " << l1_tlb[2 * i]->num_data_hits << "\n";
-        outFile << "[L1 SMALL TLB] translation hits = " << l1_tlb[2 * i]->num_tr_hits << "\n";
-        outFile << "[L1 SMALL TLB] data misses = " << l1_tlb[2 * i]->num_data_misses << "\n";
-        outFile << "[L1 SMALL TLB] translation misses = " << l1_tlb[2 * i]->num_tr_misses << "\n";
-        outFile << "[L1 SMALL TLB] MSHR data hits = " << l1_tlb[2 * i]->num_mshr_data_hits << "\n";
-        outFile << "[L1 SMALL TLB] MSHR translation hits = " << l1_tlb[2 * i]->num_mshr_tr_hits << "\n";
-        outFile << "[L1 SMALL TLB] data accesses = " << l1_tlb[2 * i]->num_data_accesses << "\n";
-        outFile << "[L1 SMALL TLB] translation accesses = " << l1_tlb[2 * i]->num_tr_accesses << "\n";
-        if(cores[i]->m_num_retired)
+        else if (strcmp(argv[i], "-penalty") == 0)
+            tp.shootdown_penalty = strtoull(argv[i + 1], NULL, 10);
+        else if (strcmp(argv[i], "-benchmark") == 0)
+            tp.benchmark = argv[i + 1];
+        else if (strcmp(argv[i], "-threads") == 0)
+            num_threads = strtoul(argv[i + 1], NULL, 10);
+        else if (strcmp(argv[i], "-quantum") == 0)
+            quantum = strtoul(argv[i + 1], NULL, 10);
+        else if (strcmp(argv[i], "-segments") == 0)
+            num_segments = strtoul(argv[i + 1], NULL, 10);
+        else if (strcmp(argv[i], "-overlap") == 0)
+            overlap = strtoull(argv[i + 1], NULL, 10);
+        else
         {
-            double l1ts_mpki = (double) ((l1_tlb[2 * i]->num_data_misses  + l1_tlb[2 * i]->num_tr_misses)* 1000.0)/(cores[i]->m_num_retired);
-            outFile << "[L1 SMALL TLB] MPKI = " << l1ts_mpki << "\n";
-            if(!tp.is_multicore) l1ts_agg_mpki += l1ts_mpki;
+            std::cout << "[Error] Unknown option " << argv[i] << std::endl;
+            exit(0);
         }
+    }
+    
+    if (num_threads > 0 && num_segments > 0)
+    {
+        std::cout << "[Error] -threads and -segments cannot be combined" << std::endl;
+        exit(0);
+    }
+    
+    tp.verifyOpenTraceFiles();
 
-        total_num_data_coh_msgs += l1_tlb[2 * i]->num_data_coh_msgs;
-        total_num_tr_coh_msgs += l1_tlb[2 * i]->num_tr_coh_msgs;
-
-        outFile << "[L1 LARGE TLB] data hits = " << l1_tlb[2 * i + 1]->num_data_hits << "\n";
-        outFile << "[L1 LARGE TLB] translation hits = " << l1_tlb[2 * i + 1]->num_tr_hits << "\n";
-        outFile << "[L1 LARGE TLB] data misses = " << l1_tlb[2 * i + 1]->num_data_misses << "\n";
-        outFile << "[L1 LARGE TLB] translation misses = " << l1_tlb[2 * i + 1]->num_tr_misses << "\n";
-        outFile << "[L1 LARGE TLB] MSHR data hits = " << l1_tlb[2 * i + 1]->num_mshr_data_hits << "\n";
-        outFile << "[L1 LARGE TLB] MSHR translation hits = " << l1_tlb[2 * i + 1]->num_mshr_tr_hits << "\n";
-        outFile << "[L1 LARGE TLB] data accesses = " << l1_tlb[2 * i + 1]->num_data_accesses << "\n";
-        outFile << "[L1 LARGE TLB] translation accesses = " << l1_tlb[2 * i + 1]->num_tr_accesses << "\n";
-        if(cores[i]->m_num_retired)
-        {
-            double l1tl_mpki = (double) ((l1_tlb[2 * i + 1]->num_data_misses  + l1_tlb[2 * i + 1]->num_tr_misses)* 1000.0)/(cores[i]->m_num_retired);
-            outFile << "[L1 LARGE TLB] MPKI = " << l1tl_mpki << "\n";
-            if(!tp.is_multicore) l1tl_agg_mpki += l1tl_mpki;
-        }
+    std::ofstream outFile;
+    std::cout << "Translation coherence scheme = " << schemeName(tp.scheme) << ", shootdown penalty = " << tp.shootdown_penalty << "\n";
+    std::string out_name = tp.benchmark + "_" + schemeName(tp.scheme) + ".out";
+    std::cout << ("Opening " + out_name) << std::endl;
+    outFile.open(out_name);
+    
+    tp.hier_config.print(std::cout);
 
-        outFile << "[L2 SMALL TLB] data hits = " << l2_tlb[2 * i]->num_data_hits << "\n";
-        outFile << "[L2 SMALL TLB] translation hits = " << l2_tlb[2 * i]->num_tr_hits << "\n";
-        outFile << "[L2 SMALL TLB] data misses = " << l2_tlb[2 * i]->num_data_misses << "\n";
-        outFile << "[L2 SMALL TLB] translation misses = " << l2_tlb[2 * i]->num_tr_misses << "\n";
-        outFile << "[L2 SMALL TLB] MSHR data hits = " << l2_tlb[2 * i]->num_mshr_data_hits << "\n";
-        outFile << "[L2 SMALL TLB] MSHR translation hits = " << l2_tlb[2 * i]->num_mshr_tr_hits << "\n";
-        outFile << "[L2 SMALL TLB] data accesses = " << l2_tlb[2 * i]->num_data_accesses << "\n";
-        outFile << "[L2 SMALL TLB] translation accesses = " << l2_tlb[2 * i]->num_tr_accesses << "\n";
-        if(cores[i]->m_num_retired)
-        {
-            double l2ts_mpki = (double) ((l2_tlb[2 * i]->num_data_misses  + l2_tlb[2 * i]->num_tr_misses)* 1000.0)/(cores[i]->m_num_retired);
-            outFile << "[L2 SMALL TLB] MPKI = " << l2ts_mpki << "\n";
-            if(!tp.is_multicore) l2ts_agg_mpki += l2ts_mpki;
-        }
+    //Simulator holding the stats at the end
+    Simulator *result = &sim;
+    std::unique_ptr<TimeParallelSim> tpsim;
 
-        outFile << "[L2 LARGE TLB] data hits = " << l2_tlb[2 * i + 1]->num_data_hits << "\n";
-        outFile << "[L2 LARGE TLB] translation hits = " << l2_tlb[2 * i + 1]->num_tr_hits << "\n";
-        outFile << "[L2 LARGE TLB] data misses = " << l2_tlb[2 * i + 1]->num_data_misses << "\n";
-        outFile << "[L2 LARGE TLB] translation misses = " << l2_tlb[2 * i + 1]->num_tr_misses << "\n";
-        outFile << "[L2 LARGE TLB] MSHR data hits = " << l2_tlb[2 * i + 1]->num_mshr_data_hits << "\n";
-        outFile << "[L2 LARGE TLB] MSHR translation hits = " << l2_tlb[2 * i + 1]->num_mshr_tr_hits << "\n";
-        outFile << "[L2 LARGE TLB] data accesses = " << l2_tlb[2 * i + 1]->num_data_accesses << "\n";
-        outFile << "[L2 LARGE TLB] translation accesses = " << l2_tlb[2 * i + 1]->num_tr_accesses << "\n";
-        if(cores[i]->m_num_retired)
-        {
-            double l2tl_mpki = (double) ((l2_tlb[2 * i + 1]->num_data_misses  + l2_tlb[2 * i + 1]->num_tr_misses)* 1000.0)/(cores[i]->m_num_retired);
-            outFile << "[L2 LARGE TLB] MPKI = " << l2tl_mpki << "\n";
-            if(!tp.is_multicore) l2tl_agg_mpki += l2tl_mpki;
-        }
+    if(num_segments > 0)
+    {
+        uint64_t start_ts = (tp.start_ts != 0) ? tp.start_ts : tp.warmup_period;
+        uint64_t end_ts = (tp.end_ts != UINT64_MAX) ? tp.end_ts : tp.find_end_ts();
+        std::cout << "[TIME_PARALLEL] Segments = " << num_segments << ", timestamps = " << start_ts << " to " << end_ts << ", warm-up overlap = " << overlap << "\n";
+
+        //Segments take the config and the command line overrides of the serial run
+        tpsim.reset(new TimeParallelSim(num_segments, start_ts, end_ts, overlap, [&](TraceProcessor &seg_tp) {
+            seg_tp.parseAndSetupInputs(input_cfg);
+            seg_tp.scheme = tp.scheme;
+            seg_tp.shootdown_penalty = tp.shootdown_penalty;
+            seg_tp.benchmark = tp.benchmark;
+        }));
+        result = &tpsim->get_merged();
     }
-
-    outFile << "----------------------------------------------------------------------\n";
-
-    if(!tp.is_multicore)
+    else
     {
-        outFile << "Cycles = " << total_num_cycles << "\n";
-        outFile << "Instructions = " << (total_instructions) << "\n";
-        if(total_num_cycles > 0)
-        {
-            outFile << "IPC = " << (double) (total_instructions)/(total_num_cycles + total_stall_cycles) << "\n";
-        }
-        outFile << "Stall cycles = " << total_stall_cycles << "\n";
-        outFile << "Num shootdowns = " << total_shootdowns << "\n";
-        outFile << "[L1 D$] Aggregate MPKI = " << l1d_agg_mpki << "\n";
-        outFile << "[L2 D$] Aggregate MPKI = " << l2d_agg_mpki << "\n";
-        outFile << "[L1 SMALL TLB] Aggregate MPKI = " << l1ts_agg_mpki << "\n";
-        outFile << "[L1 LARGE TLB] Aggregate MPKI = " << l1tl_agg_mpki << "\n";
-        outFile << "[L2 SMALL TLB] Aggregate MPKI = " << l2ts_agg_mpki << "\n";
-        outFile << "[L2 LARGE TLB] Aggregate MPKI = " << l2tl_agg_mpki << "\n";
+        sim.build();
+        sim.initial_fill();
     }
 
-    outFile << "----------------------------------------------------------------------\n";
-    outFile << "[AGGREGATE] Number of data coherence messages = " << total_num_data_coh_msgs << "\n";
-    outFile << "[AGGREGATE] Number of translation coherence messages = " << total_num_tr_coh_msgs << "\n";
-    outFile << "[L3] data hits = " << llc->num_data_hits << "\n";
-    outFile << "[L3] translation hits = " << llc->num_tr_hits << "\n";
-    outFile << "[L3] data misses = " << llc->num_data_misses << "\n";
-    outFile << "[L3] translation misses = " << llc->num_tr_misses << "\n";
-    outFile << "[L3] MSHR data hits = " << llc->num_mshr_data_hits << "\n";
-    outFile << "[L3] MSHR translation hits = " << llc->num_mshr_tr_hits << "\n";
-    outFile << "[L3] data accesses = " << llc->num_data_accesses << "\n";
-    outFile << "[L3] translation accesses = " << llc->num_tr_accesses << "\n";
-    if(total_instructions)
+    auto start = std::chrono::steady_clock::now();
+
+    if(num_segments > 0)
     {
-        outFile << "[L3] MPKI = " << (double) ((llc->num_data_misses  + llc->num_tr_misses)* 1000.0)/(total_instructions) << "\n";
+        tpsim->run();
     }
-
-    outFile << "[L3 SMALL TLB] data hits = " << l3_tlb_small->num_data_hits << "\n";
-    outFile << "[L3 SMALL TLB] translation hits = " << l3_tlb_small->num_tr_hits << "\n";
-    outFile << "[L3 SMALL TLB] data misses = " << l3_tlb_small->num_data_misses << "\n";
-    outFile << "[L3 SMALL TLB] translation misses = " << l3_tlb_small->num_tr_misses << "\n";
-    outFile << "[L3 SMALL TLB] MSHR data hits = " << l3_tlb_small->num_mshr_data_hits << "\n";
-    outFile << "[L3 SMALL TLB] MSHR translation hits = " << l3_tlb_small->num_mshr_tr_hits << "\n";
-    outFile << "[L3 SMALL TLB] data accesses = " << l3_tlb_small->num_data_accesses << "\n";
-    outFile << "[L3 SMALL TLB] translation accesses = " << l3_tlb_small->num_tr_accesses << "\n";
-    if(total_instructions)
+    else if(num_threads > 0)
     {
-        outFile << "[L3 SMALL TLB] MPKI = " << (double) (l3_tlb_small->num_tr_misses * 1000.0)/(total_instructions) << "\n";
+        quantum = (quantum > 0) ? quantum : sim.default_quantum();
+        std::cout << "[PARALLEL] Worker threads = " << num_threads << ", quantum = " << quantum << " cycles, lookahead = " << sim.default_quantum() << " cycles\n";
+        sim.run_parallel(num_threads, quantum);
+        //Share of the wall time the threads were busy, -bench parallel measures the speedup against a serial run
+        std::cout << "[PARALLEL] Thread utilization = " << sim.parallel_busy_seconds / (sim.parallel_seconds * sim.parallel_threads) << " over " << sim.parallel_threads << " threads\n";
     }
-
-    outFile << "[L3 LARGE TLB] data hits = " << l3_tlb_large->num_data_hits << "\n";
-    outFile << "[L3 LARGE TLB] translation hits = " << l3_tlb_large->num_tr_hits << "\n";
-    outFile << "[L3 LARGE TLB] data misses = " << l3_tlb_large->num_data_misses << "\n";
-    outFile << "[L3 LARGE TLB] translation misses = " << l3_tlb_large->num_tr_misses << "\n";
-    outFile << "[L3 LARGE TLB] MSHR data hits = " << l3_tlb_large->num_mshr_data_hits << "\n";
-    outFile << "[L3 LARGE TLB] MSHR translation hits = " << l3_tlb_large->num_mshr_tr_hits << "\n";
-    outFile << "[L3 LARGE TLB] data accesses = " << l3_tlb_large->num_data_accesses << "\n";
-    outFile << "[L3 LARGE TLB] translation accesses = " << l3_tlb_large->num_tr_accesses << "\n";
-    if(total_instructions)
+    else
     {
-        outFile << "[L3 LARGE TLB] MPKI = " << (double) (l3_tlb_large->num_tr_misses * 1000.0)/(total_instructions) << "\n";
+        sim.run();
     }
 
-    outFile << "----------------------------------------------------------------------\n";
+    std::cout << "[SIMULATION_TIME] Seconds = " << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() << "\n";
+    std::cout << "[SKIP_AHEAD] Idle cycles skipped = " << result->num_skipped_cycles << "\n";
+    std::cout << "[PRESENCE_TRACKER] small pages = " << result->tp.presence_small_page.size() << ", bytes = " << result->tp.presence_small_page.get_memory_usage() << "\n";
+    std::cout << "[PRESENCE_TRACKER] large pages = " << result->tp.presence_large_page.size() << ", bytes = " << result->tp.presence_large_page.get_memory_usage() << "\n";
+
+    result->print_stats(outFile);
     outFile.close();
 
-}
+}
\ No newline at end of file
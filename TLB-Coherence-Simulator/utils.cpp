@@ -60,3 +60,34 @@ std::string trim(const std::string& str)
     out = out.substr(0,i+1);
     return out;
 }
+
+bool parseScheme(const std::string& str, TranslationCoherenceScheme &scheme)
+{
+    if (str == "baseline")
+        scheme = BASELINE_SCHEME;
+    else if (str == "ideal" || str == "baseline_ideal")
+        scheme = IDEAL_SCHEME;
+    else if (str == "cotag")
+        scheme = COTAG_SCHEME;
+    else if (str == "cotagless")
+        scheme = COTAGLESS_SCHEME;
+    else
+        return false;
+    return true;
+}
+
+std::string schemeName(TranslationCoherenceScheme scheme)
+{
+    switch(scheme)
+    {
+        case BASELINE_SCHEME:
+            return "baseline";
+        case IDEAL_SCHEME:
+            return "baseline_ideal";
+        case COTAG_SCHEME:
+            return "cotag";
+        case COTAGLESS_SCHEME:
+        default:
+            return "cotagless";
+    }
+}
@@ -14,9 +14,10 @@
 //Defines
 #define ADDR_SIZE 48
 #define MIN_NUM_CACHES 2
-#define NUM_CORES 8
 #define MIN_NUM_TLBS 4
 #define stringify(name) #name
+//Bytes per L3 TLB entry in memory
+#define L3_TLB_ENTRY_SIZE 16
 
 unsigned int log2(unsigned int num);
 
@@ -89,8 +90,23 @@ typedef struct {
     int num_cores;
 } trace_shootdown_entry_t;
 
+//How translation coherence is kept
+//BASELINE stalls the initiating core for a fixed shootdown penalty, IDEAL is BASELINE at no cost
+//COTAG and COTAGLESS send translation writes through the data hierarchy, invalidating TLB entries by co-tag or by whole set
+typedef enum {
+    BASELINE_SCHEME,
+    IDEAL_SCHEME,
+    COTAG_SCHEME,
+    COTAGLESS_SCHEME,
+} TranslationCoherenceScheme;
+
 kind txnKindForCohAction(CoherenceAction coh_action);
 
+bool parseScheme(const std::string& str, TranslationCoherenceScheme &scheme);
+
+//Suffix of the stats file of a scheme, e.g. "baseline_ideal"
+std::string schemeName(TranslationCoherenceScheme scheme);
+
 std::string trim(const std::string& str);
 
 #endif /* utils_hpp */